@@ -46,6 +46,10 @@
 
 
 
+#define CP_OP_CACHE_SZ	256		//resolved coprocessor ops, must be a power of 2
+
+
+
 #define REG_NO_SP		13
 #define REG_NO_LR		14
 #define REG_NO_PC		15
@@ -64,6 +68,13 @@
 
 
 
+struct ArmCpCachedOp {
+
+	uint32_t instr;			//0 is never a coprocessor instr, so zeroed slots are empty
+	ArmCoprocOpF func;		//NULL if the coprocessor left this one to its regXfer/dataProcessing
+	uint32_t arg;
+};
+
 struct ArmBankedRegs{
 
 	uint32_t R13, R14;
@@ -93,6 +104,7 @@ struct ArmCpu {
 	uint16_t CPAR;
 
 	struct ArmCoprocessor coproc[16];		//coprocessors
+	struct ArmCpCachedOp cpOps[CP_OP_CACHE_SZ];
 
 	// various other cpu config options
 	uint32_t vectorBase;		//address of vector base
@@ -1934,6 +1946,25 @@ load_store_mode_2:
 			else if (!(cpu->CPAR & (1UL << cpNo)))	//others are access-controlled by CPAR
 				goto invalid_instr;
 			
+			if (cpu->coproc[cpNo].decode) {
+				
+				struct ArmCpCachedOp *op = &cpu->cpOps[(instr ^ (instr >> 8) ^ (instr >> 16)) & (CP_OP_CACHE_SZ - 1)];
+				
+				if (unlikely(op->instr != instr)) {
+					
+					op->instr = instr;
+					op->arg = 0;
+					op->func = cpu->coproc[cpNo].decode(cpu, cpu->coproc[cpNo].userData, instr, &op->arg);
+				}
+				
+				if (op->func) {
+					
+					if (!op->func(cpu, cpu->coproc[cpNo].userData, instr, op->arg))
+						goto invalid_instr;
+					goto instr_done;
+				}
+			}
+			
 			if (instr & 0x00000010UL) {		//MCR[2]/MRC[2]
 				
 				if (!cpu->coproc[cpNo].regXfer || !cpu->coproc[cpNo].regXfer(cpu, cpu->coproc[cpNo].userData, specialInstr, !!(instr & 0x00100000UL), (instr >> 21) & 0x07, (instr >> 12) & 0x0F, (instr >> 16) & 0x0F, instr & 0x0F, (instr >> 5) & 0x07))
@@ -2411,6 +2442,7 @@ void cpuIrq(struct ArmCpu *cpu, bool fiq, bool raise) {	//unraise when acknowled
 void cpuCoprocessorRegister(struct ArmCpu *cpu, uint8_t cpNum, struct ArmCoprocessor* coproc)
 {
 	cpu->coproc[cpNum] = *coproc;
+	memset(cpu->cpOps, 0, sizeof(cpu->cpOps));
 }
 
 void cpuSetVectorAddr(struct ArmCpu *cpu, uint32_t adr)
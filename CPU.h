@@ -48,6 +48,22 @@ typedef bool (*ArmCoprocDatProcF)(struct ArmCpu *cpu, void* userData, bool two/*
 typedef bool (*ArmCoprocMemAccsF)(struct ArmCpu *cpu, void* userData, bool two /* LDC2/STC2 ? */, bool N, bool store, uint8_t CRd, uint8_t addrReg, uint32_t addBefore, uint32_t addAfter, uint8_t* option /* NULL if none */);	///addBefore/addAfter are UNSCALED. spec syas *4, but WMMX has other ideas. exercise caution. writeback is ON YOU!
 typedef bool (*ArmCoprocTwoRegF)(struct ArmCpu *cpu, void* userData, bool MRRC, uint8_t op, uint8_t Rd, uint8_t Rn, uint8_t CRm);
 
+//a single MCR/MRC/CDP, already resolved by ArmCoprocDecodeF. "arg" is whatever the decoder asked to be handed back
+typedef bool (*ArmCoprocOpF)(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t arg);
+//called once per distinct instr word, the result is cached, so it may only look at the instr's bits. NULL leaves it to regXfer/dataProcessing
+typedef ArmCoprocOpF (*ArmCoprocDecodeF)(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t *argP);
+
+//instr fields, for decoders and ArmCoprocOpF
+#define ARM_CP_INSTR_TWO(_instr)		(((_instr) >> 28) == 0x0F)		//MCR2/MRC2/CDP2
+#define ARM_CP_INSTR_XFER(_instr)		(!!((_instr) & 0x00000010UL))	//MCR/MRC as opposed to CDP
+#define ARM_CP_INSTR_MRC(_instr)		(!!((_instr) & 0x00100000UL))
+#define ARM_CP_INSTR_XFER_OP1(_instr)	(((_instr) >> 21) & 0x07)
+#define ARM_CP_INSTR_CDP_OP1(_instr)	(((_instr) >> 20) & 0x0F)
+#define ARM_CP_INSTR_CRN(_instr)		(((_instr) >> 16) & 0x0F)
+#define ARM_CP_INSTR_RD(_instr)			(((_instr) >> 12) & 0x0F)		//Rx for MCR/MRC, CRd for CDP
+#define ARM_CP_INSTR_OP2(_instr)		(((_instr) >> 5) & 0x07)
+#define ARM_CP_INSTR_CRM(_instr)		((_instr) & 0x0F)
+
 
 struct ArmCoprocessor{
 	
@@ -55,6 +71,7 @@ struct ArmCoprocessor{
 	ArmCoprocDatProcF dataProcessing;
 	ArmCoprocMemAccsF memAccess;
 	ArmCoprocTwoRegF  twoRegF;
+	ArmCoprocDecodeF decode;		//optional
 	void* userData;
 };
 
@@ -14,8 +14,18 @@ struct ArmRam {
 	uint32_t adr;
 	uint32_t sz;
 	uint32_t* buf;
+	uint32_t* dirty;	//bitmap, one bit per granule
+	struct ArmRam *of;	//for a mirror: the RAM it aliases, which does all the work
 };
 
+static void ramPrvMarkDirty(struct ArmRam *ram, uint32_t ofst, uint32_t len)
+{
+	uint32_t g, gLast = (ofst + len - 1) >> RAM_DIRTY_SHIFT;
+	
+	for (g = ofst >> RAM_DIRTY_SHIFT; g <= gLast; g++)
+		ram->dirty[g / 32] |= 1UL << (g % 32);
+}
+
 	
 static bool ramAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* bufP)
 {
@@ -29,6 +39,10 @@ static bool ramAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool writ
 	addr += pa;
 	
 	if (write) {
+		
+		if (ram->dirty)
+			ramPrvMarkDirty(ram, pa, size);
+		
 		switch (size) {
 			
 			case 1:
@@ -122,6 +136,94 @@ static bool ramAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool writ
 	return true;
 }
 
+//a mirror goes through the RAM it aliases, so writes to it are seen by that RAM's dirty tracking
+static bool ramPrvMirrorAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* bufP)
+{
+	struct ArmRam *mirror = (struct ArmRam*)userData;
+	
+	return ramAccessF(mirror->of, pa - mirror->adr + mirror->of->adr, size, write, bufP);
+}
+
+void* ramGetPtr(struct ArmRam *ram, uint32_t pa, uint32_t len)
+{
+	if (ram->of) {
+		pa = pa - ram->adr + ram->of->adr;
+		ram = ram->of;
+	}
+	
+	pa -= ram->adr;
+	if (pa >= ram->sz || ram->sz - pa < len)
+		return NULL;
+	
+	return ((uint8_t*)ram->buf) + pa;
+}
+
+void ramDirtyTrack(struct ArmRam *ram)
+{
+	if (ram->dirty)
+		return;
+	
+	ram->dirty = (uint32_t*)calloc(((ram->sz >> RAM_DIRTY_SHIFT) + 31) / 32, sizeof(uint32_t));
+	if (!ram->dirty)
+		ERR("cannot alloc RAM dirty map\n");
+}
+
+static bool ramPrvDirtyRange(struct ArmRam *ram, uint32_t pa, uint32_t len, uint32_t *firstP, uint32_t *lastP)
+{
+	pa -= ram->adr;
+	if (!ram->dirty || !len || pa >= ram->sz || ram->sz - pa < len)
+		return false;
+	
+	*firstP = pa >> RAM_DIRTY_SHIFT;
+	*lastP = (pa + len - 1) >> RAM_DIRTY_SHIFT;
+	
+	return true;
+}
+
+bool ramDirtyTest(struct ArmRam *ram, uint32_t pa, uint32_t len)
+{
+	uint32_t g, gLast;
+	
+	if (!ramPrvDirtyRange(ram, pa, len, &g, &gLast))
+		return true;
+	
+	for (; g <= gLast; g++) {
+		
+		if (!(g % 32) && gLast - g >= 31) {		//whole words at a time where we can
+			
+			if (ram->dirty[g / 32])
+				return true;
+			g += 31;
+		}
+		else if (ram->dirty[g / 32] & (1UL << (g % 32)))
+			return true;
+	}
+	
+	return false;
+}
+
+void ramDirtyClear(struct ArmRam *ram, uint32_t pa, uint32_t len)
+{
+	uint32_t g, gLast;
+	
+	if (!ramPrvDirtyRange(ram, pa, len, &g, &gLast))
+		return;
+	
+	for (; g <= gLast; g++)
+		ram->dirty[g / 32] &=~ (1UL << (g % 32));
+}
+
+void ramDirtyMark(struct ArmRam *ram, uint32_t pa, uint32_t len)
+{
+	uint32_t g, gLast;
+	
+	if (!ramPrvDirtyRange(ram, pa, len, &g, &gLast))
+		return;
+	
+	for (; g <= gLast; g++)
+		ram->dirty[g / 32] |= 1UL << (g % 32);
+}
+
 struct ArmRam* ramInit(struct ArmMem *mem, uint32_t adr, uint32_t sz, uint32_t* buf)
 {
 	struct ArmRam *ram = (struct ArmRam*)malloc(sizeof(*ram));
@@ -140,3 +242,23 @@ struct ArmRam* ramInit(struct ArmMem *mem, uint32_t adr, uint32_t sz, uint32_t*
 	
 	return ram;
 }
+
+struct ArmRam* ramMirrorInit(struct ArmMem *mem, uint32_t adr, struct ArmRam *of)
+{
+	struct ArmRam *ram = (struct ArmRam*)malloc(sizeof(*ram));
+	
+	if (!ram)
+		ERR("cannot alloc RAM mirror at 0x%08x", adr);
+	
+	memset(ram, 0, sizeof (*ram));
+	
+	ram->adr = adr;
+	ram->sz = of->sz;
+	ram->buf = of->buf;
+	ram->of = of;
+	
+	if (!memRegionAdd(mem, adr, ram->sz, ramPrvMirrorAccessF, ram))
+		ERR("cannot add RAM mirror at 0x%08x to MEM\n", adr);
+	
+	return ram;
+}
@@ -12,6 +12,18 @@ struct ArmRam;
 
 
 struct ArmRam* ramInit(struct ArmMem *mem, uint32_t adr, uint32_t sz, uint32_t* buf);
+struct ArmRam* ramMirrorInit(struct ArmMem *mem, uint32_t adr, struct ArmRam *of);	//same memory at another address, writes count as writes to "of"
+
+void* ramGetPtr(struct ArmRam *ram, uint32_t pa, uint32_t len);	//host pointer to a physical range (little-endian data), NULL if not all of it is in this RAM
+
+//write tracking in RAM_DIRTY_GRANULE-byte granules. meant for a single consumer (the LCD) - it clears what it has seen
+#define RAM_DIRTY_SHIFT		8
+#define RAM_DIRTY_GRANULE	(1UL << RAM_DIRTY_SHIFT)
+
+void ramDirtyTrack(struct ArmRam *ram);
+bool ramDirtyTest(struct ArmRam *ram, uint32_t pa, uint32_t len);	//true if written since last clear (or not tracked)
+void ramDirtyClear(struct ArmRam *ram, uint32_t pa, uint32_t len);
+void ramDirtyMark(struct ArmRam *ram, uint32_t pa, uint32_t len);	//for writes made through ramGetPtr()
 
 
 
@@ -1,15 +1,34 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
 #include "endian.h"
 #include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
 #include "util.h"
 #include "mem.h"
 #include "ROM.h"
 
 #define STRATAFLASH_BLOCK_SIZE	0x20000ul
 
+//overlay file: a header, then records of a block number (little-endian u32) and that erase block's contents.
+//each block has at most one record, rewritten in place as the block changes
+#define ROM_OVERLAY_MAGIC		"uARMnorO"
+#define ROM_OVERLAY_SYNC_SEC	1		//changed blocks reach the overlay within this long
+
+struct RomOverlayHdr {
+	char magic[8];
+	uint32_t blockSz;
+	uint32_t romSz;
+};
+
 enum StrataFlashMode {
 	StrataFlashNormal,
 	StrataFlashReadStatus,
@@ -35,9 +54,33 @@ struct ArmRom {
 	enum RomChipType chipType;
 	enum StrataFlashMode mode;
 	uint16_t configReg, busyCy, stsReg, possibleConfigReg;
+	
+	//overlay of changed erase blocks, if any
+	int ovlFd;
+	uint32_t blockSz, numBlocks, numRecs, blocksWritten;
+	uint32_t *recIdx;				//per block: 1 + its record in the overlay, 0 if none
+	atomic_uint_fast64_t *dirty;	//per block
 };
 
 
+static const char *mOvlPath = NULL;
+static struct ArmRom *mOvlRom = NULL;
+static pthread_mutex_t mOvlLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mOvlCond = PTHREAD_COND_INITIALIZER;
+static pthread_t mOvlThread;
+static bool mOvlStop = false;
+
+
+//call after changing the data: the overlay thread may write the block out the moment it sees the bit
+static void romPrvMarkDirty(struct ArmRom *rom, struct ArmRomPiece *piece, uint32_t ofst)
+{
+	uint32_t block = ofst / rom->blockSz;
+	
+	if (rom->dirty && piece == rom->pieces)		//the overlay covers the first piece, which is all of any writeable ROM
+		atomic_fetch_or_explicit(&rom->dirty[block / 64], 1ULL << (block % 64), memory_order_release);
+}
+
+
 static bool romPrvWrite(struct ArmRom *rom, uint32_t ofst, uint_fast16_t val)
 {
 	struct ArmRomPiece *piece = rom->pieces;
@@ -66,6 +109,7 @@ static bool romPrvWrite(struct ArmRom *rom, uint32_t ofst, uint_fast16_t val)
 		default:
 			return false;
 	}
+	romPrvMarkDirty(rom, piece, ofst);
 	
 	return true;
 }
@@ -111,6 +155,7 @@ static bool romPrvErase(struct ArmRom *rom, uint32_t ofst)
 			now = sz;
 		
 		memset(((char*)piece->buf) + ofst, 0xff, now);
+		romPrvMarkDirty(rom, piece, ofst);
 		sz -= now;
 		ofst = 0;
 		piece = piece->next;
@@ -551,6 +596,144 @@ static bool romAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool writ
 	return true;
 }
 
+//write out each changed block. one the guest changes again meanwhile is marked again and written on the next pass
+static void romPrvOverlaySync(struct ArmRom *rom)
+{
+	uint32_t i, block, len, blockLe;
+	struct iovec iov[2];
+	uint64_t bits;
+	
+	for (i = 0; i < (rom->numBlocks + 63) / 64; i++) {
+		
+		bits = atomic_exchange_explicit(&rom->dirty[i], 0, memory_order_acquire);
+		while (bits) {
+			
+			block = i * 64 + __builtin_ctzll(bits);
+			bits &= bits - 1;
+			
+			if (!rom->recIdx[block])
+				rom->recIdx[block] = ++rom->numRecs;
+			
+			len = rom->pieces->size - block * rom->blockSz;
+			if (len > rom->blockSz)
+				len = rom->blockSz;
+			
+			blockLe = htole32(block);
+			iov[0].iov_base = &blockLe;
+			iov[0].iov_len = sizeof(blockLe);
+			iov[1].iov_base = ((char*)rom->pieces->buf) + block * rom->blockSz;
+			iov[1].iov_len = len;
+			if (pwritev(rom->ovlFd, iov, 2, sizeof(struct RomOverlayHdr) + (uint64_t)(rom->recIdx[block] - 1) * (sizeof(blockLe) + rom->blockSz)) != (ssize_t)(sizeof(blockLe) + len))
+				perror("ROM overlay write failed");
+			rom->blocksWritten++;
+		}
+	}
+}
+
+static void* romPrvOverlayThread(void *param)
+{
+	struct ArmRom *rom = (struct ArmRom*)param;
+	struct timespec ts;
+	
+	pthread_mutex_lock(&mOvlLock);
+	while (!mOvlStop) {
+		
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += ROM_OVERLAY_SYNC_SEC;
+		if (pthread_cond_timedwait(&mOvlCond, &mOvlLock, &ts) != ETIMEDOUT)
+			continue;
+		
+		pthread_mutex_unlock(&mOvlLock);
+		romPrvOverlaySync(rom);
+		pthread_mutex_lock(&mOvlLock);
+	}
+	pthread_mutex_unlock(&mOvlLock);
+	
+	return NULL;
+}
+
+static void romPrvOverlayStop(void)
+{
+	pthread_mutex_lock(&mOvlLock);
+	mOvlStop = true;
+	pthread_cond_signal(&mOvlCond);
+	pthread_mutex_unlock(&mOvlLock);
+	pthread_join(mOvlThread, NULL);
+	
+	romPrvOverlaySync(mOvlRom);
+	fsync(mOvlRom->ovlFd);
+	close(mOvlRom->ovlFd);
+	if (mOvlRom->blocksWritten)
+		fprintf(stderr, "ROM: %lu flash blocks written to the overlay\n", (unsigned long)mOvlRom->blocksWritten);
+}
+
+//blocks in the overlay replace those of the image, which stays untouched
+static bool romPrvOverlayOpen(struct ArmRom *rom, const char *path)
+{
+	uint32_t block, len, size = rom->pieces->size;
+	struct RomOverlayHdr hdr;
+	struct stat st;
+	uint64_t pos;
+	
+	rom->numBlocks = (size + rom->blockSz - 1) / rom->blockSz;
+	rom->ovlFd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (rom->ovlFd < 0 || fstat(rom->ovlFd, &st)) {
+		perror("cannot open ROM overlay");
+		return false;
+	}
+	
+	rom->recIdx = (uint32_t*)calloc(rom->numBlocks, sizeof(uint32_t));
+	rom->dirty = (atomic_uint_fast64_t*)calloc((rom->numBlocks + 63) / 64, sizeof(atomic_uint_fast64_t));
+	if (!rom->recIdx || !rom->dirty)
+		ERR("cannot alloc ROM overlay state\n");
+	
+	if (!st.st_size) {
+		
+		memcpy(hdr.magic, ROM_OVERLAY_MAGIC, sizeof(hdr.magic));
+		hdr.blockSz = htole32(rom->blockSz);
+		hdr.romSz = htole32(size);
+		if (pwrite(rom->ovlFd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+			perror("cannot create ROM overlay");
+			return false;
+		}
+	}
+	else if (pread(rom->ovlFd, &hdr, sizeof(hdr), 0) != sizeof(hdr) || memcmp(hdr.magic, ROM_OVERLAY_MAGIC, sizeof(hdr.magic)) ||
+			le32toh(hdr.blockSz) != rom->blockSz || le32toh(hdr.romSz) != size) {
+		fprintf(stderr, "'%s' is not a ROM overlay for this ROM\n", path);
+		return false;
+	}
+	
+	for (pos = sizeof(hdr); pos + sizeof(block) < (uint64_t)st.st_size; pos += sizeof(block) + rom->blockSz) {
+		
+		if (pread(rom->ovlFd, &block, sizeof(block), pos) != sizeof(block) || (block = le32toh(block)) >= rom->numBlocks) {
+			fprintf(stderr, "ROM overlay '%s' is damaged\n", path);
+			return false;
+		}
+		
+		len = size - block * rom->blockSz;
+		if (len > rom->blockSz)
+			len = rom->blockSz;
+		if (pread(rom->ovlFd, ((char*)rom->pieces->buf) + block * rom->blockSz, len, pos + sizeof(block)) != len) {
+			fprintf(stderr, "ROM overlay '%s' is damaged\n", path);
+			return false;
+		}
+		rom->recIdx[block] = ++rom->numRecs;
+	}
+	fprintf(stderr, "%lu changed flash blocks in the ROM overlay\n", (unsigned long)rom->numRecs);
+	
+	mOvlRom = rom;
+	if (pthread_create(&mOvlThread, NULL, romPrvOverlayThread, rom))
+		ERR("cannot start ROM overlay thread\n");
+	atexit(romPrvOverlayStop);
+	
+	return true;
+}
+
+void romSetOverlay(const char *path)
+{
+	mOvlPath = path;
+}
+
 struct ArmRom* romInit(struct ArmMem *mem, uint32_t adr, void **pieces, const uint32_t *pieceSizes, uint32_t numPieces, enum RomChipType chipType)
 {
 	struct ArmRom *rom = (struct ArmRom*)malloc(sizeof(*rom));
@@ -601,6 +784,10 @@ struct ArmRom* romInit(struct ArmMem *mem, uint32_t adr, void **pieces, const ui
 	rom->chipType = chipType;
 	rom->mode = StrataFlashNormal;
 	rom->configReg = 0xc0c2;
+	rom->blockSz = (chipType == RomStrataflash16x2x) ? 2 * STRATAFLASH_BLOCK_SIZE : STRATAFLASH_BLOCK_SIZE;
+	
+	if (mOvlPath && !mOvlRom && rom->pieces && (chipType == RomStrataFlash16x || chipType == RomStrataflash16x2x) && !romPrvOverlayOpen(rom, mOvlPath))
+		return NULL;
 	
 	return rom;
 }
@@ -23,6 +23,9 @@ struct ArmRom;
 
 struct ArmRom* romInit(struct ArmMem *mem, uint32_t adr, void **pieces, const uint32_t *pieceSizes, uint32_t numPieces, enum RomChipType chipType);
 
+//before romInit: keep the erase blocks a flash ROM's guest changes in this file, and start from those already in it
+void romSetOverlay(const char *path);
+
 
 
 
@@ -6,26 +6,62 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "soc_GPIO.h"
+#include "soc_UART.h"
+#include "soc_I2C.h"
 
 
 
 #define CHAR_CTL_C	-1L
 #define CHAR_NONE	-2L
 
+#define SOC_RUN_SLICE_CYCLES	0x00010000UL	//socRun() steps the SoC in slices of this many cycles
 
-typedef bool (*SdSectorR)(uint32_t secNum, void *buf);
-typedef bool (*SdSectorW)(uint32_t secNum, const void *buf);
 
+typedef bool (*SdSectorR)(uint32_t secNum, void *buf, uint32_t numSecs);
+typedef bool (*SdSectorW)(uint32_t secNum, const void *buf, uint32_t numSecs);
 
+
+/*
+	One SoC per process. Device selection, NAND and ROM write-back, the SD store, input, display, audio and host serial
+	I/O all keep their state in globals, so a second SoC would share them with the first. socInit() refuses to run
+	twice. To run several devices, run several processes: they share the pages of a ROM image and of an SD base image.
+	The benchmarks ("-b") run each workload in a process of its own, and a farm ("--farm", see farm.c) runs a list of
+	jobs that way on a pool of workers
+*/
 struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev);
 void socRun(struct SoC* soc);
+void socRunCycles(struct SoC* soc, uint32_t numCycles);	//run for the given number of cycles and return, so a run can be a set length
 
 void socBootload(struct SoC* soc, uint32_t method, void *param);	//soc-specific
+uint32_t socGetRamBase(void);
+
+//every SoC family fills one in and every device names its family (see DEVICE_REGISTER). socInit() and the rest above, plus the
+//soc_GPIO.h, soc_UART.h and soc_I2C.h calls that devices and the frontend make, go to the selected device's family (see
+//socFamily.c), so devices of all families can be linked into one binary. family code calls its own peripherals directly
+struct SocFamily {
+	struct SoC* (*init)(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev);
+	void (*runCycles)(struct SoC* soc, uint32_t numCycles);
+	uint32_t (*getRamBase)(void);
+	
+	enum SocGpioState (*gpioGetState)(struct SocGpio* gpio, uint_fast8_t gpioNum);
+	void (*gpioSetState)(struct SocGpio* gpio, uint_fast8_t gpioNum, bool on);
+	void (*gpioSetNotif)(struct SocGpio* gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData);
+	void (*gpioSetDirsChangedNotif)(struct SocGpio* gpio, GpioDirsChangedF notifF, void *userData);
+	void (*uartSetFuncs)(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void *userData);
+	void (*uartSetBulk)(struct SocUart *uart, bool bulk);
+	bool (*i2cDeviceAdd)(struct SocI2c *i2c, I2cDeviceActionF actF, void *userData);	//NULL if the family has no I2C
+};
+
+extern const struct SocFamily socFamilyPxa, socFamilyOmap, socFamilyS3c24xx;
 
 //externally needed
 void socExtSerialWriteChar(int ch);
 int socExtSerialReadChar(void);
 
+struct SocUart;
+void socExtSerialAttach(struct SocUart *uart, const char *name);	//called for every UART at init, the frontend may hook it up to the host
+
 
 
 #endif
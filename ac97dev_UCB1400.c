@@ -3,6 +3,7 @@
 #include "ac97dev_UCB1400.h"
 #include <string.h>
 #include <stdlib.h>
+#include "audio.h"
 #include "util.h"
 
 
@@ -15,6 +16,8 @@
 #define VGPIO_NUM_TSPX			12		//0x1000
 #define VPGIO_NUM_ADCR			11		//0x0800
 
+#define UCB1400_MAX_SPAN		64		//most audio samples moved each way per periodic call
+
 enum UCB1400REG {
 	RESET = 0x00,
 	MASTERVOL = 0x02,
@@ -443,21 +446,20 @@ void ucb1400setPen(struct UCB1400 *ucb, int16_t x, int16_t y)
 	ucb1400prvRecalcTouchIrq(ucb);
 }
 
-static void ucb1400prvNewAudioPlaybackSample(struct UCB1400 *ucb, uint32_t samp)
-{
-	//nothing for now
-}
-
-static bool ucb1400prvHaveAudioOutSample(struct UCB1400 *ucb, uint32_t *sampP)
+static void ucb1400prvAudioPeriodic(struct UCB1400 *ucb)
 {
-	*sampP = 0;
-	return true;
-}
-
-static bool ucb1400prvHaveMicOutSample(struct UCB1400 *ucb, uint32_t *sampP)
-{
-	*sampP = 0;
-	return true;
+	static const uint32_t silence[UCB1400_MAX_SPAN] = {0, };
+	//the rate registers only count with variable rate audio on
+	uint32_t dacRate = (ucb->extStaCtl & 1) ? ucb->dacRate : 48000, adcRate = (ucb->extStaCtl & 1) ? ucb->adcRate : 48000;
+	uint32_t buf[UCB1400_MAX_SPAN], num;
+	
+	num = socAC97clientTakeSamples(ucb->ac97, Ac97PrimaryAudio, dacRate, buf, UCB1400_MAX_SPAN);
+	if (num)
+		audioPlayFrames(buf, num, dacRate);
+	
+	//nothing to record, so line in and mic are silent
+	socAC97clientGiveSamples(ucb->ac97, Ac97PrimaryAudio, adcRate, silence, UCB1400_MAX_SPAN);
+	socAC97clientGiveSamples(ucb->ac97, Ac97SecondaryAudio, adcRate, silence, UCB1400_MAX_SPAN);
 }
 
 static bool ucb1400prvHaveModemOutSample(struct UCB1400 *ucb, uint32_t *sampP)
@@ -553,14 +555,7 @@ void ucb1400periodic(struct UCB1400 *ucb)
 {
 	uint32_t val = 0;
 	
-	if (socAC97clientClientWantData(ucb->ac97, Ac97PrimaryAudio, &val))
-		ucb1400prvNewAudioPlaybackSample(ucb, val);
-	
-	if (ucb1400prvHaveAudioOutSample(ucb, &val))
-		socAC97clientClientHaveData(ucb->ac97, Ac97PrimaryAudio, val);
-	
-	if (ucb1400prvHaveMicOutSample(ucb, &val))
-		socAC97clientClientHaveData(ucb->ac97, Ac97SecondaryAudio, val);
+	ucb1400prvAudioPeriodic(ucb);
 	
 	if (ucb1400prvHaveModemOutSample(ucb, &val))
 		socAC97clientClientHaveData(ucb->ac97, Ac97PrimaryModem, val);
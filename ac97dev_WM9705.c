@@ -3,8 +3,12 @@
 #include "ac97dev_WM9705.h"
 #include <string.h>
 #include <stdlib.h>
+#include "audio.h"
 #include "util.h"
 
+
+#define WM9705_MAX_SPAN			64		//most audio samples moved each way per periodic call
+
 enum WM9705REG {
 	RESET = 0x00,
 	VOLMASTER = 0x02,
@@ -302,21 +306,20 @@ struct WM9705* wm9705Init(struct SocAC97* ac97)
 	return wm;
 }
 
-static void wm9705prvNewAudioPlaybackSample(struct WM9705 *wm, uint32_t samp)
-{
-	//nothing for now
-}
-
-static bool wm9705prvHaveAudioOutSample(struct WM9705 *wm, uint32_t *sampP)
-{
-	*sampP = 0;
-	return true;
-}
-
-static bool wm9705prvHaveMicOutSample(struct WM9705 *wm, uint32_t *sampP)
+static void wm9705prvAudioPeriodic(struct WM9705 *wm)
 {
-	*sampP = 0;
-	return true;
+	static const uint32_t silence[WM9705_MAX_SPAN] = {0, };
+	//the rate registers only count with variable rate audio on
+	uint32_t dacRate = (wm->extdAudio & 1) ? wm->dacrate : 48000, adcRate = (wm->extdAudio & 1) ? wm->adcrate : 48000;
+	uint32_t buf[WM9705_MAX_SPAN], num;
+	
+	num = socAC97clientTakeSamples(wm->ac97, Ac97PrimaryAudio, dacRate, buf, WM9705_MAX_SPAN);
+	if (num)
+		audioPlayFrames(buf, num, dacRate);
+	
+	//nothing to record, so line in and mic are silent
+	socAC97clientGiveSamples(wm->ac97, Ac97PrimaryAudio, adcRate, silence, WM9705_MAX_SPAN);
+	socAC97clientGiveSamples(wm->ac97, Ac97SecondaryAudio, adcRate, silence, WM9705_MAX_SPAN);
 }
 
 static uint_fast16_t wm9705prvGetSample(struct WM9705 *wm, enum WM9705sampleIdx which)
@@ -444,14 +447,7 @@ void wm9705periodic(struct WM9705 *wm)
 {
 	uint32_t val;
 	
-	if (socAC97clientClientWantData(wm->ac97, Ac97PrimaryAudio, &val))
-		wm9705prvNewAudioPlaybackSample(wm, val);
-	
-	if (wm9705prvHaveAudioOutSample(wm, &val))
-		socAC97clientClientHaveData(wm->ac97, Ac97PrimaryAudio, val);
-	
-	if (wm9705prvHaveMicOutSample(wm, &val))
-		socAC97clientClientHaveData(wm->ac97, Ac97SecondaryAudio, val);
+	wm9705prvAudioPeriodic(wm);
 	
 	if (wm9705prvHaveModemOutSample(wm, &val))
 		socAC97clientClientHaveData(wm->ac97, Ac97PrimaryModem, val);
@@ -3,8 +3,12 @@
 #include "ac97dev_WM9712L.h"
 #include <string.h>
 #include <stdlib.h>
+#include "audio.h"
 #include "util.h"
 
+
+#define WM9712L_MAX_SPAN		64		//most audio samples moved each way per periodic call
+
 enum WM9712REG {
 	RESET = 0x00,
 	OUT2VOL = 0x02,
@@ -439,21 +443,20 @@ struct WM9712L* wm9712LInit(struct SocAC97* ac97, struct SocGpio *gpio, int8_t p
 	return wm;
 }
 
-static void wm9712LprvNewAudioPlaybackSample(struct WM9712L *wm, uint32_t samp)
-{
-	//nothing for now
-}
-
-static bool wm9712LprvHaveAudioOutSample(struct WM9712L *wm, uint32_t *sampP)
-{
-	*sampP = 0;
-	return true;
-}
-
-static bool wm9712LprvHaveMicOutSample(struct WM9712L *wm, uint32_t *sampP)
+static void wm9712LprvAudioPeriodic(struct WM9712L *wm)
 {
-	*sampP = 0;
-	return true;
+	static const uint32_t silence[WM9712L_MAX_SPAN] = {0, };
+	//the rate registers only count with variable rate audio on
+	uint32_t dacRate = (wm->extdCtl & 1) ? wm->dacRate : 48000, adcRate = (wm->extdCtl & 1) ? wm->adcRate : 48000;
+	uint32_t buf[WM9712L_MAX_SPAN], num;
+	
+	num = socAC97clientTakeSamples(wm->ac97, Ac97PrimaryAudio, dacRate, buf, WM9712L_MAX_SPAN);
+	if (num)
+		audioPlayFrames(buf, num, dacRate);
+	
+	//nothing to record, so line in and mic are silent
+	socAC97clientGiveSamples(wm->ac97, Ac97PrimaryAudio, adcRate, silence, WM9712L_MAX_SPAN);
+	socAC97clientGiveSamples(wm->ac97, Ac97SecondaryAudio, adcRate, silence, WM9712L_MAX_SPAN);
 }
 
 static uint16_t wm9712LprvGetSample(struct WM9712L *wm, enum WM9712LsampleIdx which)
@@ -577,14 +580,7 @@ void wm9712Lperiodic(struct WM9712L *wm)
 {
 	uint32_t val;
 	
-	if (socAC97clientClientWantData(wm->ac97, Ac97PrimaryAudio, &val))
-		wm9712LprvNewAudioPlaybackSample(wm, val);
-	
-	if (wm9712LprvHaveAudioOutSample(wm, &val))
-		socAC97clientClientHaveData(wm->ac97, Ac97PrimaryAudio, val);
-	
-	if (wm9712LprvHaveMicOutSample(wm, &val))
-		socAC97clientClientHaveData(wm->ac97, Ac97SecondaryAudio, val);
+	wm9712LprvAudioPeriodic(wm);
 	
 	if (wm9712LprvHaveModemOutSample(wm, &val))
 		socAC97clientClientHaveData(wm->ac97, Ac97PrimaryModem, val);
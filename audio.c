@@ -0,0 +1,386 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "SDL2/SDL.h"
+#include "endian.h"
+#include "audio.h"
+#include "speed.h"
+#include "util.h"
+
+
+#define AUDIO_RING_FRAMES		16384		//power of 2, a third of a second at 48KHz
+#define AUDIO_OUT_RATE			44100
+#define AUDIO_SDL_FRAMES		1024		//per SDL callback
+#define AUDIO_PREFILL_FRAMES	2048		//after running dry, wait for this much before playing again
+#define AUDIO_TARGET_FRAMES		4096		//the level the governor is steered to keep the ring at
+#define AUDIO_STEER_SHIFT		6			//correct this power of 2 fraction of the level error per callback
+#define AUDIO_WAV_PERIOD_USEC	20000
+#define AUDIO_WAV_CHUNK			4096
+
+
+/*
+	Single producer, single consumer ring of frames. The emulator only moves "head" and the output only moves "tail",
+	so neither ever waits. The output resamples from whatever rate the guest last programmed to its own
+*/
+
+struct AudioSink {
+	const char *name;
+	const char *help;
+	bool (*open)(const char *args);		//from here on, pulls frames with audioPrvRender()
+	void (*close)(void);
+};
+
+
+static uint32_t mRing[AUDIO_RING_FRAMES];
+static atomic_uint_fast32_t mRingHead, mRingTail, mInRate;
+static atomic_bool mRunning = false;
+static const struct AudioSink *mSink;
+static const char *mSinkArgs;
+
+//emulator side
+static uint32_t mLastRate;
+static uint64_t mFramesIn, mFramesDropped, mOverruns;
+static bool mOverrunning;
+
+//output side
+static int16_t mCur[2], mNext[2];
+static uint32_t mPhase = 0x10000;		//16.16 position between mCur and mNext
+static bool mPrimed;
+static uint64_t mFramesSilent, mUnderruns, mLevelSum, mLevelSamples;
+
+
+
+static uint32_t audioPrvLevel(void)
+{
+	return atomic_load_explicit(&mRingHead, memory_order_acquire) - atomic_load_explicit(&mRingTail, memory_order_relaxed);
+}
+
+//linear interpolation from the guest rate to ours, for as long as there is data
+static uint32_t audioPrvRender(int16_t *dst, uint32_t num, uint32_t outRate)
+{
+	uint32_t head = atomic_load_explicit(&mRingHead, memory_order_acquire), tail = atomic_load_explicit(&mRingTail, memory_order_relaxed);
+	uint32_t inRate = atomic_load_explicit(&mInRate, memory_order_relaxed), step, i, v;
+	uint_fast8_t ch;
+
+	if (!inRate)
+		inRate = outRate;
+	step = ((uint64_t)inRate << 16) / outRate;
+
+	for (i = 0; i < num; i++, dst += 2) {
+
+		while (mPhase >= 0x10000 && tail != head) {
+
+			v = mRing[tail++ & (AUDIO_RING_FRAMES - 1)];
+			mCur[0] = mNext[0];
+			mCur[1] = mNext[1];
+			mNext[0] = (int16_t)(uint16_t)v;
+			mNext[1] = (int16_t)(uint16_t)(v >> 16);
+			mPhase -= 0x10000;
+		}
+
+		if (mPhase >= 0x10000)	//ran dry
+			break;
+
+		for (ch = 0; ch < 2; ch++)
+			dst[ch] = mCur[ch] + (int16_t)(((int32_t)(mNext[ch] - mCur[ch]) * (int32_t)(mPhase >> 1)) >> 15);
+		mPhase += step;
+	}
+
+	atomic_store_explicit(&mRingTail, tail, memory_order_release);
+	return i;
+}
+
+
+///// SDL audio device: plays in real time, so its level steers the speed governor
+
+static SDL_AudioDeviceID mSdlDev;
+static uint32_t mSdlRate;
+
+static void audioPrvSdlCallback(void *userData, uint8_t *stream, int len)
+{
+	int16_t *dst = (int16_t*)stream;
+	uint32_t num = len / (2 * sizeof(int16_t)), level = audioPrvLevel(), inRate = atomic_load_explicit(&mInRate, memory_order_relaxed), done = 0;
+
+	mLevelSum += level;
+	mLevelSamples++;
+
+	//more than we want queued means the guest is running ahead of the sound card's clock, less that it is behind
+	if (inRate)
+		speedNudge(((int64_t)level - AUDIO_TARGET_FRAMES) * 1000000000LL / inRate >> AUDIO_STEER_SHIFT);
+
+	if (!mPrimed && level >= AUDIO_PREFILL_FRAMES)
+		mPrimed = true;
+
+	if (mPrimed && (done = audioPrvRender(dst, num, mSdlRate)) < num) {
+
+		mPrimed = false;
+		mUnderruns++;
+	}
+
+	memset(dst + done * 2, 0, (num - done) * 2 * sizeof(int16_t));
+	mFramesSilent += num - done;
+}
+
+static bool audioPrvSdlOpen(const char *args)
+{
+	SDL_AudioSpec want, have;
+
+	memset(&want, 0, sizeof(want));
+	want.freq = AUDIO_OUT_RATE;
+	want.format = AUDIO_S16SYS;
+	want.channels = 2;
+	want.samples = AUDIO_SDL_FRAMES;
+	want.callback = audioPrvSdlCallback;
+
+	mSdlDev = SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+	if (!mSdlDev) {
+
+		fprintf(stderr, "Couldn't open audio device: %s. Continuing without sound\n", SDL_GetError());
+		return false;
+	}
+	mSdlRate = have.freq;
+	SDL_PauseAudioDevice(mSdlDev, 0);
+
+	return true;
+}
+
+static void audioPrvSdlClose(void)
+{
+	SDL_CloseAudioDevice(mSdlDev);
+}
+
+static const struct AudioSink* audioPrvSdlSink(void)
+{
+	static const struct AudioSink sink = {
+		.name = "sdl",
+		.help = "the host's sound card (default)",
+		.open = audioPrvSdlOpen,
+		.close = audioPrvSdlClose,
+	};
+
+	return &sink;
+}
+
+
+///// WAV file: takes all the guest makes, as fast as it makes it
+
+static FILE *mWav;
+static pthread_t mWavThread;
+static atomic_bool mWavStop;
+static uint64_t mWavFrames;
+
+static void audioPrvWavHeader(void)
+{
+	uint32_t dataLen = mWavFrames * 4, hdr[11];
+
+	hdr[0] = htole32(0x46464952);			//"RIFF"
+	hdr[1] = htole32(36 + dataLen);
+	hdr[2] = htole32(0x45564157);			//"WAVE"
+	hdr[3] = htole32(0x20746d66);			//"fmt "
+	hdr[4] = htole32(16);
+	hdr[5] = htole32(0x00020001);			//PCM, stereo
+	hdr[6] = htole32(AUDIO_OUT_RATE);
+	hdr[7] = htole32(AUDIO_OUT_RATE * 4);
+	hdr[8] = htole32(0x00100004);			//4 bytes a frame, 16 bits a sample
+	hdr[9] = htole32(0x61746164);			//"data"
+	hdr[10] = htole32(dataLen);
+
+	rewind(mWav);
+	fwrite(hdr, sizeof(hdr), 1, mWav);
+	fseek(mWav, 0, SEEK_END);
+}
+
+static void audioPrvWavDrain(void)
+{
+	int16_t buf[AUDIO_WAV_CHUNK * 2];
+	uint32_t num, i;
+
+	do {
+		num = audioPrvRender(buf, AUDIO_WAV_CHUNK, AUDIO_OUT_RATE);
+		for (i = 0; i < num * 2; i++)
+			buf[i] = htole16(buf[i]);
+		fwrite(buf, 4, num, mWav);
+		mWavFrames += num;
+	} while (num == AUDIO_WAV_CHUNK);
+}
+
+static void* audioPrvWavThread(void *param)
+{
+	while (!atomic_load(&mWavStop)) {
+
+		usleep(AUDIO_WAV_PERIOD_USEC);
+		audioPrvWavDrain();
+	}
+
+	return NULL;
+}
+
+static bool audioPrvWavOpen(const char *args)
+{
+	if (!args || !*args) {
+
+		fprintf(stderr, "WAV output needs a file name\n");
+		return false;
+	}
+
+	mWav = fopen(args, "wb");
+	if (!mWav) {
+
+		perror("cannot create WAV file");
+		return false;
+	}
+	audioPrvWavHeader();
+
+	atomic_init(&mWavStop, false);
+	if (pthread_create(&mWavThread, NULL, audioPrvWavThread, NULL))
+		ERR("cannot start audio thread\n");
+
+	return true;
+}
+
+static void audioPrvWavClose(void)
+{
+	atomic_store(&mWavStop, true);
+	pthread_join(mWavThread, NULL);
+
+	audioPrvWavDrain();
+	audioPrvWavHeader();
+	fclose(mWav);
+}
+
+static const struct AudioSink* audioPrvWavSink(void)
+{
+	static const struct AudioSink sink = {
+		.name = "wav",
+		.help = "wav:FILE - record to a 44.1KHz WAV file, at guest speed",
+		.open = audioPrvWavOpen,
+		.close = audioPrvWavClose,
+	};
+
+	return &sink;
+}
+
+
+///// no sound at all
+
+static bool audioPrvNoneOpen(const char *args)
+{
+	return false;
+}
+
+static const struct AudioSink* audioPrvNoneSink(void)
+{
+	static const struct AudioSink sink = {
+		.name = "none",
+		.help = "discard all sound",
+		.open = audioPrvNoneOpen,
+	};
+
+	return &sink;
+}
+
+
+static const struct AudioSink* (* const mKnownSinks[])(void) = {
+	audioPrvSdlSink,
+	audioPrvWavSink,
+	audioPrvNoneSink,
+};
+
+
+
+bool audioSetSink(const char *spec)
+{
+	const char *args = strchr(spec, ':');
+	size_t nameLen = args ? (size_t)(args++ - spec) : strlen(spec);
+	uint_fast8_t i;
+
+	for (i = 0; i < sizeof(mKnownSinks) / sizeof(*mKnownSinks); i++) {
+
+		const struct AudioSink *sink = mKnownSinks[i]();
+
+		if (strlen(sink->name) != nameLen || strncmp(sink->name, spec, nameLen))
+			continue;
+
+		mSink = sink;
+		mSinkArgs = args;
+
+		return true;
+	}
+
+	return false;
+}
+
+void audioListSinks(FILE *f)
+{
+	uint_fast8_t i;
+
+	for (i = 0; i < sizeof(mKnownSinks) / sizeof(*mKnownSinks); i++)
+		fprintf(f, "\t%-16s %s\n", mKnownSinks[i]()->name, mKnownSinks[i]()->help);
+}
+
+static void audioPrvStop(void)
+{
+	atomic_store(&mRunning, false);
+	mSink->close();
+
+	fprintf(stderr, "audio: %llu guest frames to %s, %llu dropped in %llu overruns, %llu frames of silence in %llu underruns",
+		(unsigned long long)mFramesIn, mSink->name, (unsigned long long)mFramesDropped, (unsigned long long)mOverruns,
+		(unsigned long long)mFramesSilent, (unsigned long long)mUnderruns);
+	if (mLevelSamples && mLastRate)
+		fprintf(stderr, ", %.1f ms average latency", 1000.0 * ((double)mLevelSum / mLevelSamples / mLastRate + (double)AUDIO_SDL_FRAMES / mSdlRate));
+	fprintf(stderr, "\n");
+}
+
+void audioStart(void)
+{
+	if (!mSink)
+		mSink = audioPrvSdlSink();
+
+	atomic_init(&mRingHead, 0);
+	atomic_init(&mRingTail, 0);
+	atomic_init(&mInRate, 0);
+
+	if (!mSink->open(mSinkArgs))
+		return;
+
+	atomic_store(&mRunning, true);
+	atexit(audioPrvStop);
+}
+
+void audioPlayFrames(const uint32_t *frames, uint32_t num, uint32_t rate)
+{
+	uint32_t head, space, i;
+
+	if (!atomic_load_explicit(&mRunning, memory_order_relaxed) || !rate)
+		return;
+
+	if (rate != mLastRate) {
+		mLastRate = rate;
+		atomic_store_explicit(&mInRate, rate, memory_order_relaxed);
+	}
+
+	head = atomic_load_explicit(&mRingHead, memory_order_relaxed);
+	space = AUDIO_RING_FRAMES - (head - atomic_load_explicit(&mRingTail, memory_order_acquire));
+
+	if (num > space) {
+
+		if (!mOverrunning)
+			mOverruns++;
+		mOverrunning = true;
+		mFramesDropped += num - space;
+		num = space;
+	}
+	else
+		mOverrunning = false;
+
+	for (i = 0; i < num; i++)
+		mRing[(head + i) & (AUDIO_RING_FRAMES - 1)] = frames[i];
+
+	atomic_store_explicit(&mRingHead, head + num, memory_order_release);
+	mFramesIn += num;
+}
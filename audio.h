@@ -0,0 +1,22 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _AUDIO_H_
+#define _AUDIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+//the output is picked before audioStart() as "name" or "name:args". with none picked, sound goes to SDL
+bool audioSetSink(const char *spec);
+void audioListSinks(FILE *f);
+
+//call once SDL is up. frames played before this (or with no usable output) are dropped
+void audioStart(void);
+
+//codecs hand us stereo frames (signed 16-bit, left in the low half) at the rate the guest programmed. never blocks
+void audioPlayFrames(const uint32_t *frames, uint32_t num, uint32_t rate);
+
+
+#endif
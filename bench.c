@@ -0,0 +1,368 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <sys/wait.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+#include "display.h"
+#include "device.h"
+#include "bench.h"
+#include "util.h"
+#include "SoC.h"
+
+
+/*
+	Bare-metal benchmark images. Each is placed at the reset vector in place of the ROM and runs forever,
+	so a run is a fixed number of guest instructions. Every image starts with the same preamble that loads
+	the RAM base (which differs per SoC) into r12 from the second word of the image.
+*/
+
+#define BENCH_IMAGE_SIZE		0x00010000UL
+#define BENCH_RAM_BASE_WORD		1
+
+//the "lcd" benchmark converts frames of random pixels on the host, like the PXA LCD controller does for each bpp mode
+#define BENCH_LCD_W				320
+#define BENCH_LCD_H				480
+#define BENCH_LCD_FRAMES		2000
+
+
+static const uint32_t mBenchAlu[] = {
+	0xea000000,	//b 0x8
+	0x00000000,	//RAM base, filled in at runtime
+	0xe51fc00c,	//ldr r12, [pc, #-12]
+	0xe3a01001,	//mov r1, #1
+	0xe3a02003,	//mov r2, #3
+	0xe3a03000,	//mov r3, #0
+	0xe0811002,	//add r1, r1, r2
+	0xe02331e1,	//eor r3, r3, r1, ror #3
+	0xe04220a3,	//sub r2, r2, r3, lsr #1
+	0xe1814002,	//orr r4, r1, r2
+	0xe0045003,	//and r5, r4, r3
+	0xe0060291,	//mul r6, r1, r2
+	0xe0967005,	//adds r7, r6, r5
+	0xe0a78001,	//adc r8, r7, r1
+	0xe3c890ff,	//bic r9, r8, #255
+	0xe069a101,	//rsb r10, r9, r1, lsl #2
+	0xeafffff4,	//b 0x18
+};
+
+static const uint32_t mBenchLdst[] = {
+	0xea000000,	//b 0x8
+	0x00000000,	//RAM base, filled in at runtime
+	0xe51fc00c,	//ldr r12, [pc, #-12]
+	0xe28cc801,	//add r12, r12, #0x10000
+	0xe1a0000c,	//mov r0, r12
+	0xe3a02c01,	//mov r2, #256
+	0xe5901000,	//ldr r1, [r0]
+	0xe2811001,	//add r1, r1, #1
+	0xe4801004,	//str r1, [r0], #4
+	0xe1d030b2,	//ldrh r3, [r0, #2]
+	0xe5c03001,	//strb r3, [r0, #1]
+	0xe2522001,	//subs r2, r2, #1
+	0x1afffff8,	//bne 0x18
+	0xeafffff5,	//b 0x10
+};
+
+static const uint32_t mBenchLdm[] = {
+	0xea000000,	//b 0x8
+	0x00000000,	//RAM base, filled in at runtime
+	0xe51fc00c,	//ldr r12, [pc, #-12]
+	0xe28cc801,	//add r12, r12, #0x10000
+	0xe1a0000c,	//mov r0, r12
+	0xe28c9a01,	//add r9, r12, #0x1000
+	0xe3a0a040,	//mov r10, #64
+	0xe8b001fe,	//ldm r0!, {r1, r2, r3, r4, r5, r6, r7, r8}
+	0xe8a901fe,	//stm r9!, {r1, r2, r3, r4, r5, r6, r7, r8}
+	0xe25aa001,	//subs r10, r10, #1
+	0x1afffffb,	//bne 0x1c
+	0xeafffff7,	//b 0x10
+};
+
+static const uint32_t mBenchBranch[] = {
+	0xea000000,	//b 0x8
+	0x00000000,	//RAM base, filled in at runtime
+	0xe51fc00c,	//ldr r12, [pc, #-12]
+	0xe3a00064,	//mov r0, #100
+	0xeb000002,	//bl 0x20
+	0xe2500001,	//subs r0, r0, #1
+	0x1afffffc,	//bne 0x10
+	0xeafffffa,	//b 0xc
+	0xe3100001,	//tst r0, #1
+	0x02811001,	//addeq r1, r1, #1
+	0x1a000000,	//bne 0x30
+	0xe1a0f00e,	//mov pc, lr
+	0xe2411001,	//sub r1, r1, #1
+	0xe1a0f00e,	//mov pc, lr
+};
+
+static const uint32_t mBenchThumb[] = {
+	0xea000000,	//b 0x8
+	0x00000000,	//RAM base, filled in at runtime
+	0xe51fc00c,	//ldr r12, [pc, #-12]
+	0xe28cc801,	//add r12, r12, #0x10000
+	0xe28f0001,	//add r0, pc, #1
+	0xe12fff10,	//bx r0
+	0x21004664,	//mov r4, r12 / movs r1, #0
+	0x18092064,	//movs r0, #100 / adds r1, r1, r0
+	0x404a00ca,	//lsls r2, r1, #3 / eors r2, r1
+	0x189b6823,	//ldr r3, [r4] / adds r3, r3, r2
+	0x81226063,	//str r3, [r4, #4] / strh r2, [r4, #8]
+	0x38017a65,	//ldrb r5, [r4, #9] / subs r0, #1
+	0xe7f3d1f5,	//bne 0x1e / b 0x1c
+};
+
+static const uint32_t mBenchMmu[] = {
+	0xea000000,	//b 0x8
+	0x00000000,	//RAM base, filled in at runtime
+	0xe51fc00c,	//ldr r12, [pc, #-12]
+	0xe28c0901,	//add r0, r12, #0x4000
+	0xe3a01000,	//mov r1, #0
+	0xe59f207c,	//ldr r2, =0xc02
+	0xe1823a01,	//orr r3, r2, r1, lsl #20
+	0xe7803101,	//str r3, [r0, r1, lsl #2]
+	0xe2811001,	//add r1, r1, #1
+	0xe3510a01,	//cmp r1, #0x1000
+	0x1afffffa,	//bne 0x18
+	0xe2801a02,	//add r1, r0, #0x2000
+	0xe18c3002,	//orr r3, r12, r2
+	0xe3a04c01,	//mov r4, #256
+	0xe4813004,	//str r3, [r1], #4
+	0xe2544001,	//subs r4, r4, #1
+	0x1afffffc,	//bne 0x38
+	0xee020f10,	//mcr p15, #0, r0, c2, c0, #0
+	0xe3a01001,	//mov r1, #1
+	0xee031f10,	//mcr p15, #0, r1, c3, c0, #0
+	0xe3a01000,	//mov r1, #0
+	0xee081f17,	//mcr p15, #0, r1, c8, c7, #0
+	0xee111f10,	//mrc p15, #0, r1, c1, c0, #0
+	0xe3811001,	//orr r1, r1, #1
+	0xee011f10,	//mcr p15, #0, r1, c1, c0, #0
+	0xe1a00000,	//mov r0, r0
+	0xe1a00000,	//mov r0, r0
+	0xe3a05601,	//mov r5, #0x100000
+	0xe3a00102,	//mov r0, #0x80000000
+	0xe2800801,	//add r0, r0, #0x10000
+	0xe3a04c01,	//mov r4, #256
+	0xe5901000,	//ldr r1, [r0]
+	0xe2811001,	//add r1, r1, #1
+	0xe6801005,	//str r1, [r0], r5
+	0xe2544001,	//subs r4, r4, #1
+	0x1afffffa,	//bne 0x7c
+	0xee084f17,	//mcr p15, #0, r4, c8, c7, #0
+	0xeafffff5,	//b 0x70
+	0x00000c02,	//.word 0xc02
+};
+
+static const uint32_t mBenchCp[] = {
+	0xea000000,	//b 0x8
+	0x00000000,	//RAM base, filled in at runtime
+	0xe51fc00c,	//ldr r12, [pc, #-12]
+	0xee101f10,	//mrc p15, #0, r1, c0, c0, #0
+	0xee112f10,	//mrc p15, #0, r2, c1, c0, #0
+	0xee070f9a,	//mcr p15, #0, r0, c7, c10, #4
+	0xee133f10,	//mrc p15, #0, r3, c3, c0, #0
+	0xee033f10,	//mcr p15, #0, r3, c3, c0, #0
+	0xee124f10,	//mrc p15, #0, r4, c2, c0, #0
+	0xe0815002,	//add r5, r1, r2
+	0xeafffff7,	//b 0xc
+};
+
+struct BenchWorkload {
+	const char *name;
+	const char *descr;
+	const uint32_t *code;
+	uint32_t codeSz;
+};
+
+static const struct BenchWorkload mWorkloads[] = {
+	{"alu",		"data processing and multiplies",					mBenchAlu,		sizeof(mBenchAlu),		},
+	{"ldst",	"word/half/byte loads and stores",					mBenchLdst,		sizeof(mBenchLdst),		},
+	{"ldm",		"LDM/STM block copies",								mBenchLdm,		sizeof(mBenchLdm),		},
+	{"branch",	"calls, returns and conditional branches",			mBenchBranch,	sizeof(mBenchBranch),	},
+	{"thumb",	"thumb data processing and memory access",			mBenchThumb,	sizeof(mBenchThumb),	},
+	{"mmu",		"MMU on, 256 aliased sections with TLB flushes",	mBenchMmu,		sizeof(mBenchMmu),		},
+	{"cp",		"CP15 register transfers",							mBenchCp,		sizeof(mBenchCp),		},
+};
+
+
+
+static uint64_t benchPrvNanoTime(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static double benchPrvLcdFps(uint16_t *dst, const uint8_t *src, uint_fast8_t fmt, const uint16_t *pal)
+{
+	uint32_t rowBytes = displayRowBytes(fmt, BENCH_LCD_W), frame, row;
+	uint64_t start = benchPrvNanoTime();
+
+	for (frame = 0; frame < BENCH_LCD_FRAMES; frame++) {
+		for (row = 0; row < BENCH_LCD_H; row++)
+			displayConvertSpan(dst + row * BENCH_LCD_W, src + row * rowBytes, BENCH_LCD_W, fmt, pal);
+	}
+
+	return BENCH_LCD_FRAMES * 1e9 / (benchPrvNanoTime() - start);
+}
+
+//frames per second for each bpp mode, with and without the host vector kernels, which must also agree on every pixel
+static void benchPrvLcd(void)
+{
+	static const struct {
+		const char *name;
+		uint8_t fmt;
+	} modes[] = {
+		{"1bpp", DisplayPixPal1, },
+		{"2bpp", DisplayPixPal2, },
+		{"4bpp", DisplayPixPal4, },
+		{"8bpp", DisplayPixPal8, },
+		{"16bpp", DisplayPixRgb565, },
+	};
+	uint32_t i, srcSz = BENCH_LCD_H * displayRowBytes(DisplayPixRgb565, BENCH_LCD_W), dstSz = BENCH_LCD_W * BENCH_LCD_H * sizeof(uint16_t);
+	uint16_t pal[256], *dst = (uint16_t*)malloc(dstSz), *ref = (uint16_t*)malloc(dstSz);
+	uint8_t *src = (uint8_t*)malloc(srcSz);
+	double fps, fpsPlainC;
+
+	if (!dst || !ref || !src)
+		ERR("cannot alloc benchmark frames\n");
+
+	srand(1);
+	for (i = 0; i < srcSz; i++)
+		src[i] = rand();
+	for (i = 0; i < 256; i++)
+		pal[i] = rand();
+
+	printf("{\n\t\"frame\": \"%ux%u\",\n\t\"frames\": %u,\n\t\"results\": [", BENCH_LCD_W, BENCH_LCD_H, BENCH_LCD_FRAMES);
+
+	for (i = 0; i < sizeof(modes) / sizeof(*modes); i++) {
+
+		fps = benchPrvLcdFps(dst, src, modes[i].fmt, pal);
+		fpsPlainC = benchPrvLcdFps(ref, src, modes[i].fmt | DISPLAY_PIX_PLAIN_C, pal);
+		if (memcmp(dst, ref, dstSz))
+			ERR("%s conversion differs from the plain C\n", modes[i].name);
+
+		printf("%s\n\t\t{\"mode\": \"%s\", \"fps\": %.1f, \"fpsPlainC\": %.1f}", i ? "," : "", modes[i].name, fps, fpsPlainC);
+		fflush(stdout);
+	}
+	printf("\n\t]\n}\n");
+
+	free(src);
+	free(ref);
+	free(dst);
+}
+
+static uint64_t benchPrvRunOne(const struct BenchWorkload *wl, uint64_t numInstrs, FILE *nandFile)
+{
+	uint32_t romSz = BENCH_IMAGE_SIZE, slice;
+	uint64_t start;
+	struct SoC *soc;
+	uint32_t *rom;
+	
+	rom = (uint32_t*)calloc(1, BENCH_IMAGE_SIZE);
+	if (!rom)
+		ERR("cannot alloc benchmark image\n");
+	
+	memcpy(rom, wl->code, wl->codeSz);
+	rom[BENCH_RAM_BASE_WORD] = socGetRamBase();
+	
+	if (nandFile)
+		rewind(nandFile);
+	
+	soc = socInit((void**)&rom, &romSz, 1, 0, NULL, NULL, nandFile, -1, deviceGetSocRev());
+	
+	start = benchPrvNanoTime();
+	while (numInstrs) {
+		
+		slice = numInstrs > SOC_RUN_SLICE_CYCLES ? SOC_RUN_SLICE_CYCLES : numInstrs;
+		socRunCycles(soc, slice);
+		numInstrs -= slice;
+	}
+	
+	return benchPrvNanoTime() - start;
+}
+
+//SoC modules have no teardown, so each workload gets its own process. This returns its memory when it is done
+//and gives every workload a freshly reset SoC, whichever workloads ran before it
+static uint64_t benchPrvRunIsolated(const struct BenchWorkload *wl, uint64_t numInstrs, FILE *nandFile)
+{
+	uint64_t ns = 0;
+	int pipeFds[2];
+	pid_t pid;
+	
+	if (pipe(pipeFds))
+		ERR("cannot create benchmark pipe\n");
+	
+	fflush(stdout);
+	fflush(stderr);
+	
+	pid = fork();
+	if (pid < 0)
+		ERR("cannot fork benchmark process\n");
+	
+	if (!pid) {
+		
+		close(pipeFds[0]);
+		ns = benchPrvRunOne(wl, numInstrs, nandFile);
+		_exit(write(pipeFds[1], &ns, sizeof(ns)) == sizeof(ns) ? 0 : 1);
+	}
+	
+	close(pipeFds[1]);
+	if (read(pipeFds[0], &ns, sizeof(ns)) != sizeof(ns))
+		ERR("benchmark '%s' failed\n", wl->name);
+	close(pipeFds[0]);
+	waitpid(pid, NULL, 0);
+	
+	return ns;
+}
+
+void benchListWorkloads(FILE *f)
+{
+	uint_fast8_t i;
+	
+	for (i = 0; i < sizeof(mWorkloads) / sizeof(*mWorkloads); i++)
+		fprintf(f, "\t%-8s %s\n", mWorkloads[i].name, mWorkloads[i].descr);
+	fprintf(f, "\t%-8s %s\n", "lcd", "host LCD frame conversion per bpp mode (not part of \"all\")");
+}
+
+bool benchRun(const char *which, uint64_t numInstrs, FILE *nandFile)
+{
+	bool all = !strcmp(which, "all"), first = true;
+	uint_fast8_t i;
+	uint64_t ns;
+	
+	if (!strcmp(which, "lcd")) {
+		
+		benchPrvLcd();
+		return true;
+	}
+	
+	for (i = 0; i < sizeof(mWorkloads) / sizeof(*mWorkloads); i++) {
+		
+		if (all || !strcmp(which, mWorkloads[i].name))
+			break;
+	}
+	if (i == sizeof(mWorkloads) / sizeof(*mWorkloads))
+		return false;
+	
+	printf("{\n\t\"device\": \"%s\",\n\t\"instrsPerWorkload\": %llu,\n\t\"results\": [", deviceGetName(), (unsigned long long)numInstrs);
+	
+	for (i = 0; i < sizeof(mWorkloads) / sizeof(*mWorkloads); i++) {
+		
+		if (!all && strcmp(which, mWorkloads[i].name))
+			continue;
+		
+		ns = benchPrvRunIsolated(&mWorkloads[i], numInstrs, nandFile);
+		
+		printf("%s\n\t\t{\"workload\": \"%s\", \"hostNs\": %llu, \"mips\": %.3f, \"nsPerInstr\": %.3f}",
+			first ? "" : ",", mWorkloads[i].name, (unsigned long long)ns, numInstrs * 1000.0 / ns, (double)ns / numInstrs);
+		fflush(stdout);
+		first = false;
+	}
+	printf("\n\t]\n}\n");
+	
+	return true;
+}
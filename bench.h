@@ -0,0 +1,18 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+#define BENCH_DEFAULT_INSTRS	100000000ULL
+
+
+bool benchRun(const char *which /* workload name or "all" */, uint64_t numInstrs, FILE *nandFile);	//prints JSON results to stdout
+void benchListWorkloads(FILE *f);
+
+
+#endif
@@ -341,11 +341,120 @@ success:
 	return true;
 }
 
+static bool cp15prvOpNothing(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	return true;
+}
+
+static bool cp15prvOpInvalIcache(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	struct ArmCP15 *cp15 = (struct ArmCP15*)userData;
+	
+	icacheInval(cp15->ic);
+	return true;
+}
+
+static bool cp15prvOpInvalIcacheLine(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	struct ArmCP15 *cp15 = (struct ArmCP15*)userData;
+	
+	icacheInvalAddr(cp15->ic, cpuGetRegExternal(cpu, ARM_CP_INSTR_RD(instr)));
+	return true;
+}
+
+static bool cp15prvOpReadId(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	struct ArmCP15 *cp15 = (struct ArmCP15*)userData;
+	
+	cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), ARM_CP_INSTR_OP2(instr) ? cp15->cacheId : cp15->cpuid);
+	return true;
+}
+
+static bool cp15prvOpReadControl(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	struct ArmCP15 *cp15 = (struct ArmCP15*)userData;
+	
+	cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), cp15->control);
+	return true;
+}
+
+static bool cp15prvOpDomains(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	struct ArmCP15 *cp15 = (struct ArmCP15*)userData;
+	
+	if (ARM_CP_INSTR_MRC(instr))
+		cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), mmuGetDomainCfg(cp15->mmu));
+	else
+		mmuSetDomainCfg(cp15->mmu, cpuGetRegExternal(cpu, ARM_CP_INSTR_RD(instr)));
+	return true;
+}
+
+static bool cp15prvOpTlbFlush(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	struct ArmCP15 *cp15 = (struct ArmCP15*)userData;
+	
+	mmuTlbFlush(cp15->mmu);
+	return true;
+}
+
+static bool cp15prvOpPid(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	struct ArmCP15 *cp15 = (struct ArmCP15*)userData;
+	
+	if (ARM_CP_INSTR_MRC(instr))
+		cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), cpuGetPid(cp15->cpu));
+	else
+		cpuSetPid(cp15->cpu, cpuGetRegExternal(cpu, ARM_CP_INSTR_RD(instr)) & 0xfe000000ul);
+	return true;
+}
+
+//cache maintenance, TLB flushes, domain and PID switches come in bursts, so they skip the big switch above
+static ArmCoprocOpF cp15prvCoprocDecode(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t *argP)
+{
+	uint_fast8_t CRm = ARM_CP_INSTR_CRM(instr), op2 = ARM_CP_INSTR_OP2(instr);
+	
+	if (!ARM_CP_INSTR_XFER(instr) || ARM_CP_INSTR_TWO(instr) || ARM_CP_INSTR_XFER_OP1(instr))
+		return NULL;
+	
+	switch (ARM_CP_INSTR_CRN(instr)) {
+		
+		case 0:		//ID codes
+			return (ARM_CP_INSTR_MRC(instr) && !CRm && op2 <= 1) ? cp15prvOpReadId : NULL;
+		
+		case 1:		//control register. writes have side effects and are rare
+			return (ARM_CP_INSTR_MRC(instr) && !CRm && !op2) ? cp15prvOpReadControl : NULL;
+		
+		case 3:		//domain access control
+			return cp15prvOpDomains;
+		
+		case 7:		//cache ops
+			if (ARM_CP_INSTR_MRC(instr))
+				return NULL;
+			if ((CRm == 5 || CRm == 7) && (op2 == 0 || op2 == 2))
+				return cp15prvOpInvalIcache;
+			if ((CRm == 5 || CRm == 7) && op2 == 1)
+				return cp15prvOpInvalIcacheLine;
+			if ((CRm == 10 && (op2 <= 2 || op2 == 4)) || (CRm == 6 && op2 <= 2) || (CRm == 2 && op2 == 5) || (CRm == 5 && op2 == 6) || (CRm == 0 && op2 == 4) || (CRm == 14 && op2 == 2))
+				return cp15prvOpNothing;
+			return NULL;
+		
+		case 8:		//TLB ops
+			return ARM_CP_INSTR_MRC(instr) ? NULL : cp15prvOpTlbFlush;
+		
+		case 13:	//FCSE
+			return cp15prvOpPid;
+		
+		default:
+			return NULL;
+	}
+}
+
 struct ArmCP15* cp15Init(struct ArmCpu* cpu, struct ArmMmu* mmu, struct icache *ic, uint32_t cpuid, uint32_t cacheId, bool xscale, bool omap)
 {
 	struct ArmCP15 *cp15 = (struct ArmCP15*)malloc(sizeof(*cp15));
 	struct ArmCoprocessor cp = {
 		.regXfer = cp15prvCoprocRegXferFunc,
+		.decode = cp15prvCoprocDecode,
 		.userData = cp15,
 	};
 	
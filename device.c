@@ -0,0 +1,119 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include "device.h"
+#include <strings.h>
+#include <string.h>
+#include "util.h"
+
+
+static struct DeviceDesc *mDevices = NULL, *mCurDevice = NULL;
+
+
+
+void deviceRegister(struct DeviceDesc *desc)
+{
+	struct DeviceDesc **linkP = &mDevices;
+	
+	//keep the list sorted by name so listings are stable regardless of link order
+	while (*linkP && strcmp((*linkP)->name, desc->name) < 0)
+		linkP = &(*linkP)->next;
+	
+	desc->next = *linkP;
+	*linkP = desc;
+}
+
+bool deviceSelect(const char *name)
+{
+	struct DeviceDesc *desc;
+	
+	if (!name) {
+		
+		if (!mDevices || mDevices->next)	//need exactly one
+			return false;
+		
+		mCurDevice = mDevices;
+		return true;
+	}
+	
+	for (desc = mDevices; desc; desc = desc->next) {
+		
+		if (!strcasecmp(desc->name, name)) {
+			
+			mCurDevice = desc;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+void deviceListSupported(FILE *f)
+{
+	struct DeviceDesc *desc;
+	
+	for (desc = mDevices; desc; desc = desc->next)
+		fprintf(f, "\t%s\n", desc->name);
+}
+
+static const struct DeviceDesc* devicePrvCur(void)
+{
+	if (!mCurDevice)
+		ERR("no device selected\n");
+	
+	return mCurDevice;
+}
+
+const char* deviceGetName(void)
+{
+	return devicePrvCur()->name;
+}
+
+const struct SocFamily* deviceGetSocFamily(void)
+{
+	return devicePrvCur()->socFamily;
+}
+
+bool deviceHasGrafArea(void)
+{
+	return devicePrvCur()->hasGrafArea();
+}
+
+uint32_t deviceGetRamSize(void)
+{
+	return devicePrvCur()->getRamSize();
+}
+
+enum RamTermination deviceGetRamTerminationStyle(void)
+{
+	return devicePrvCur()->getRamTerminationStyle();
+}
+
+enum RomChipType deviceGetRomMemType(void)
+{
+	return devicePrvCur()->getRomMemType();
+}
+
+uint_fast8_t deviceGetSocRev(void)
+{
+	return devicePrvCur()->getSocRev();
+}
+
+struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
+{
+	return devicePrvCur()->setup(sp, kp, vsd, nandFile);
+}
+
+void deviceKey(struct Device *dev, uint32_t key, bool down)
+{
+	devicePrvCur()->key(dev, key, down);
+}
+
+void devicePeriodic(struct Device *dev, uint32_t cycles)
+{
+	devicePrvCur()->periodic(dev, cycles);
+}
+
+void deviceTouch(struct Device *dev, int x, int y)
+{
+	devicePrvCur()->touch(dev, x, y);
+}
@@ -51,14 +51,59 @@ enum RamTermination {		//what's after ram in phys map? (some devices probe)
 
 struct Device;
 
-//simple queries
+struct DeviceDesc {		//every linked-in device registers one of these (see DEVICE_REGISTER)
+	const char *name;
+	const struct SocFamily *socFamily;
+	
+	bool (*hasGrafArea)(void);
+	uint32_t (*getRamSize)(void);
+	enum RamTermination (*getRamTerminationStyle)(void);
+	enum RomChipType (*getRomMemType)(void);
+	uint_fast8_t (*getSocRev)(void);
+	
+	struct Device* (*setup)(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile);
+	void (*key)(struct Device *dev, uint32_t key, bool down);
+	void (*periodic)(struct Device *dev, uint32_t cycles);
+	void (*touch)(struct Device *dev, int x, int y);
+	
+	struct DeviceDesc *next;
+};
+
+//a device file implements the devicePrv* hooks as statics and then says DEVICE_REGISTER("Name", socFamilyXXX);
+#define DEVICE_REGISTER(_name, _socFamily)									\
+	static struct DeviceDesc mDeviceDesc = {								\
+		.name = _name,														\
+		.socFamily = &_socFamily,											\
+		.hasGrafArea = devicePrvHasGrafArea,								\
+		.getRamSize = devicePrvGetRamSize,									\
+		.getRamTerminationStyle = devicePrvGetRamTerminationStyle,			\
+		.getRomMemType = devicePrvGetRomMemType,							\
+		.getSocRev = devicePrvGetSocRev,									\
+		.setup = devicePrvSetup,											\
+		.key = devicePrvKey,												\
+		.periodic = devicePrvPeriodic,										\
+		.touch = devicePrvTouch,											\
+	};																		\
+	static void __attribute__((constructor)) devicePrvRegister(void)		\
+	{																		\
+		deviceRegister(&mDeviceDesc);										\
+	}
+
+//registry
+void deviceRegister(struct DeviceDesc *desc);
+bool deviceSelect(const char *name);		//NULL picks the only linked-in device, if there is just one
+void deviceListSupported(FILE *f);
+const char* deviceGetName(void);
+const struct SocFamily* deviceGetSocFamily(void);
+
+//simple queries (on the selected device)
 bool deviceHasGrafArea(void);
 uint32_t deviceGetRamSize(void);
 enum RamTermination deviceGetRamTerminationStyle(void);
 enum RomChipType deviceGetRomMemType(void);
 uint_fast8_t deviceGetSocRev(void);
 
-//device handling
+//device handling (on the selected device)
 struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile);
 void deviceKey(struct Device *dev, uint32_t key, bool down);
 void devicePeriodic(struct Device *dev, uint32_t cycles);
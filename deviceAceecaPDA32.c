@@ -51,27 +51,27 @@ struct Device {
 	struct NAND *nand;
 };
 
-bool deviceHasGrafArea(void)
+static bool devicePrvHasGrafArea(void)
 {
 	return false;
 }
 
-enum RomChipType deviceGetRomMemType(void)
+static enum RomChipType devicePrvGetRomMemType(void)
 {
 	return RomWriteIgnore;
 }
 
-uint32_t deviceGetRamSize(void)
+static uint32_t devicePrvGetRamSize(void)
 {
 	return 64UL << 20;
 }
 
-enum RamTermination deviceGetRamTerminationStyle(void)
+static enum RamTermination devicePrvGetRamTerminationStyle(void)
 {
 	return RamTerminationMirror;
 }
 
-uint_fast8_t deviceGetSocRev(void)
+static uint_fast8_t devicePrvGetSocRev(void)
 {
 	return 1;	//S3C2440
 }
@@ -83,7 +83,7 @@ static void pda32nandPrvReady(void *userData, bool ready)
 	socGpioSetState(gpio, 161, ready);
 }
 
-struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
+static struct Device* devicePrvSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
 {
 	static const struct NandSpecs nandSpecs = {
 		.bytesPerPage = 2112,
@@ -155,17 +155,19 @@ struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD
 	return dev;
 }
 
-void devicePeriodic(struct Device *dev, uint32_t cycles)
+static void devicePrvPeriodic(struct Device *dev, uint32_t cycles)
 {
 	
 }
 
-void deviceTouch(struct Device *dev, int x, int y)
+static void devicePrvTouch(struct Device *dev, int x, int y)
 {
 	s3c24xxAdcSetPenPos(dev->adc, x >= 0 ? 85 + 2 * x : x, y >= 0 ? 780 - 14 * y / 10 : y);
 }
 
-void deviceKey(struct Device *dev, uint32_t key, bool down)
+static void devicePrvKey(struct Device *dev, uint32_t key, bool down)
 {
 	//nothing
 }
+
+DEVICE_REGISTER("AceecaPDA32", socFamilyS3c24xx);
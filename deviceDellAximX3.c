@@ -16,32 +16,32 @@ struct Device {
 	struct WM9705 *wm9705;
 };
 
-bool deviceHasGrafArea(void)
+static bool devicePrvHasGrafArea(void)
 {
 	return false;
 }
 
-enum RomChipType deviceGetRomMemType(void)
+static enum RomChipType devicePrvGetRomMemType(void)
 {
 	return RomStrataflash16x2x;
 }
 
-uint32_t deviceGetRamSize(void)
+static uint32_t devicePrvGetRamSize(void)
 {
 	return 64UL << 20;
 }
 
-enum RamTermination deviceGetRamTerminationStyle(void)
+static enum RamTermination devicePrvGetRamTerminationStyle(void)
 {
 	return RamTerminationMirror;
 }
 
-uint_fast8_t deviceGetSocRev(void)
+static uint_fast8_t devicePrvGetSocRev(void)
 {
 	return 1;	//PXA26x
 }
 
-struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
+static struct Device* devicePrvSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
 {
 	uint32_t romPieceSize = 32UL << 20;
 	void *romPiece = malloc(romPieceSize);
@@ -134,18 +134,20 @@ struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD
 	return dev;
 }
 
-void devicePeriodic(struct Device *dev, uint32_t cycles)
+static void devicePrvPeriodic(struct Device *dev, uint32_t cycles)
 {
 	if (!(cycles & 0x0000007FUL))
 		wm9705periodic(dev->wm9705);
 }
 
-void deviceTouch(struct Device *dev, int x, int y)
+static void devicePrvTouch(struct Device *dev, int x, int y)
 {
 	wm9705setPen(dev->wm9705, (x >= 0 && y >= 0) ? 3930 - 15 * x : -1, (x >= 0 && y >= 0) ? 3864 - 11 * y : -1, 1000);
 }
 
-void deviceKey(struct Device *dev, uint32_t key, bool down)
+static void devicePrvKey(struct Device *dev, uint32_t key, bool down)
 {
 	//nothing
-}
\ No newline at end of file
+}
+
+DEVICE_REGISTER("DellAximX3", socFamilyPxa);
@@ -23,32 +23,32 @@ struct Device {
 	struct PxaKpc *kpc;
 };
 
-bool deviceHasGrafArea(void)
+static bool devicePrvHasGrafArea(void)
 {
 	return false;
 }
 
-enum RomChipType deviceGetRomMemType(void)
+static enum RomChipType devicePrvGetRomMemType(void)
 {
 	return RomWriteError;
 }
 
-uint32_t deviceGetRamSize(void)
+static uint32_t devicePrvGetRamSize(void)
 {
 	return 32UL << 20;
 }
 
-enum RamTermination deviceGetRamTerminationStyle(void)
+static enum RamTermination devicePrvGetRamTerminationStyle(void)
 {
 	return RamTerminationMirror;
 }
 
-uint_fast8_t deviceGetSocRev(void)
+static uint_fast8_t devicePrvGetSocRev(void)
 {
 	return 2;	//PXA27x
 }
 
-struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
+static struct Device* devicePrvSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
 {
 	static const struct NandSpecs nandSpecs = {
 		.bytesPerPage = 2112,
@@ -94,7 +94,7 @@ struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD
 	return dev;
 }
 
-void devicePeriodic(struct Device *dev, uint32_t cycles)
+static void devicePrvPeriodic(struct Device *dev, uint32_t cycles)
 {
 	if (!(cycles & 0x000007FFUL))
 		wm9712Lperiodic(dev->wm9712L);
@@ -103,12 +103,12 @@ void devicePeriodic(struct Device *dev, uint32_t cycles)
 		directNandPeriodic(dev->nand);
 }
 
-void deviceTouch(struct Device *dev, int x, int y)
+static void devicePrvTouch(struct Device *dev, int x, int y)
 {
 	wm9712LsetPen(dev->wm9712L, (x >= 0) ? 320 + 9 * x : -1, (y >= 0) ? 3800 - 8 * y : y, 1000);
 }
 
-void deviceKey(struct Device *dev, uint32_t key, bool down)
+static void devicePrvKey(struct Device *dev, uint32_t key, bool down)
 {
 	static const uint32_t map[3][4] = {
 		{SDLK_ESCAPE /* power*/, SDLK_F2 /* h2 = cal */, SDLK_UP, SDLK_RIGHT},
@@ -125,4 +125,6 @@ void deviceKey(struct Device *dev, uint32_t key, bool down)
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+DEVICE_REGISTER("PalmTX", socFamilyPxa);
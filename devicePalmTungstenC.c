@@ -10,32 +10,32 @@ struct Device {
 	struct UCB1400 *ucb1400;
 };
 
-bool deviceHasGrafArea(void)
+static bool devicePrvHasGrafArea(void)
 {
 	return false;
 }
 
-enum RomChipType deviceGetRomMemType(void)
+static enum RomChipType devicePrvGetRomMemType(void)
 {
 	return RomStrataFlash16x;
 }
 
-uint32_t deviceGetRamSize(void)
+static uint32_t devicePrvGetRamSize(void)
 {
 	return 64UL << 20; //TX rom also supports 128M
 }
 
-enum RamTermination deviceGetRamTerminationStyle(void)
+static enum RamTermination devicePrvGetRamTerminationStyle(void)
 {
 	return RamTerminationWriteIgnore;
 }
 
-uint_fast8_t deviceGetSocRev(void)
+static uint_fast8_t devicePrvGetSocRev(void)
 {
 	return 0;	//PXA25x
 }
 
-struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
+static struct Device* devicePrvSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
 {
 	struct ArmRam *wifiMemSpace1, *wifiMemSpace2;
 	struct Device *dev;
@@ -91,18 +91,20 @@ struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD
 	return dev;
 }
 
-void devicePeriodic(struct Device *dev, uint32_t cycles)
+static void devicePrvPeriodic(struct Device *dev, uint32_t cycles)
 {
 	if (!(cycles & 0x000007FFUL))
 		ucb1400periodic(dev->ucb1400);
 }
 
-void deviceTouch(struct Device *dev, int x, int y)
+static void devicePrvTouch(struct Device *dev, int x, int y)
 {
 	ucb1400setPen(dev->ucb1400, (x >= 0 && y >= 0) ? 320 + 2 * x : -1, (x >= 0 && y >= 0) ? 960 - 2 * y : -1);
 }
 
-void deviceKey(struct Device *dev, uint32_t key, bool down)
+static void devicePrvKey(struct Device *dev, uint32_t key, bool down)
 {
 	//nothing
-}
\ No newline at end of file
+}
+
+DEVICE_REGISTER("PalmTungstenC", socFamilyPxa);
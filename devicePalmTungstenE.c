@@ -28,32 +28,32 @@ struct Device {
 	struct Tsc210x *tsc210x;
 };
 
-bool deviceHasGrafArea(void)
+static bool devicePrvHasGrafArea(void)
 {
 	return true;
 }
 
-enum RomChipType deviceGetRomMemType(void)
+static enum RomChipType devicePrvGetRomMemType(void)
 {
 	return RomStrataFlash16x;
 }
 
-uint32_t deviceGetRamSize(void)
+static uint32_t devicePrvGetRamSize(void)
 {
 	return 32UL << 20;
 }
 
-enum RamTermination deviceGetRamTerminationStyle(void)
+static enum RamTermination devicePrvGetRamTerminationStyle(void)
 {
 	return RamTerminationMirror;
 }
 
-uint_fast8_t deviceGetSocRev(void)
+static uint_fast8_t devicePrvGetSocRev(void)
 {
 	return 0;
 }
 
-struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
+static struct Device* devicePrvSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
 {
 	struct ArmRam *weirdBusAccess;
 	struct Device *dev;
@@ -136,13 +136,13 @@ struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD
 	return dev;
 }
 
-void devicePeriodic(struct Device *dev, uint32_t cycles)
+static void devicePrvPeriodic(struct Device *dev, uint32_t cycles)
 {
 	if(!(cycles & 0x00007FFFUL))
 		tsc210xPeriodic(dev->tsc210x);
 }
 
-void deviceTouch(struct Device *dev, int x, int y)
+static void devicePrvTouch(struct Device *dev, int x, int y)
 {
 	x = x >= 0 ? 966 - x * 28 / 10 : x;
 	y = y >= 0 ? 31 + 22 * y / 10 : y;
@@ -150,7 +150,9 @@ void deviceTouch(struct Device *dev, int x, int y)
 	tsc210xPenInput(dev->tsc210x, x, y);
 }
 
-void deviceKey(struct Device *dev, uint32_t key, bool down)
+static void devicePrvKey(struct Device *dev, uint32_t key, bool down)
 {
 	//nothing
-}
\ No newline at end of file
+}
+
+DEVICE_REGISTER("PalmTungstenE", socFamilyOmap);
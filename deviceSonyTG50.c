@@ -233,32 +233,32 @@ struct Device {
 	struct TG50uc *uc;
 };
 
-bool deviceHasGrafArea(void)
+static bool devicePrvHasGrafArea(void)
 {
 	return false;
 }
 
-enum RomChipType deviceGetRomMemType(void)
+static enum RomChipType devicePrvGetRomMemType(void)
 {
 	return RomWriteError;
 }
 
-uint32_t deviceGetRamSize(void)
+static uint32_t devicePrvGetRamSize(void)
 {
 	return 17UL << 20;	//it probes over 32M so we say 17M here so that our mirror covers the probe
 }
 
-enum RamTermination deviceGetRamTerminationStyle(void)
+static enum RamTermination devicePrvGetRamTerminationStyle(void)
 {
 	return RamTerminationMirror;
 }
 
-uint_fast8_t deviceGetSocRev(void)
+static uint_fast8_t devicePrvGetSocRev(void)
 {
 	return 0;	//PXA25x
 }
 
-struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
+static struct Device* devicePrvSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD *vsd, FILE* nandFile)
 {
 	static const uint32_t keyMap[] = {
 		SDLK_ESCAPE, SDLK_F1, SDLK_F2, 0, SDLK_F3, 0, SDLK_F4, SDLK_F5,
@@ -320,18 +320,20 @@ struct Device* deviceSetup(struct SocPeriphs *sp, struct Keypad *kp, struct VSD
 	return dev;
 }
 
-void devicePeriodic(struct Device *dev, uint32_t cycles)
+static void devicePrvPeriodic(struct Device *dev, uint32_t cycles)
 {
 	if (!(cycles & 0x00007FFFUL))
 		ad7873Periodic(dev->ad7873);
 }
 
-void deviceTouch(struct Device *dev, int x, int y)
+static void devicePrvTouch(struct Device *dev, int x, int y)
 {
 	ad7873PenInput(dev->ad7873, (x >= 0 && y >= 0) ? 3200 - 10 * x : -1, (x >= 0 && y >= 0) ? 3200 - 10 * y : -1);
 }
 
-void deviceKey(struct Device *dev, uint32_t key, bool down)
+static void devicePrvKey(struct Device *dev, uint32_t key, bool down)
 {
 	tg50ucSetKeyPressed(dev->uc, key, down);
-}
\ No newline at end of file
+}
+
+DEVICE_REGISTER("SonyTG50", socFamilyPxa);
@@ -0,0 +1,678 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "SDL2/SDL.h"
+#ifdef __SSE2__
+	#include <emmintrin.h>
+	#include <tmmintrin.h>
+#endif
+#include "display.h"
+#include "shmio.h"
+#include "video.h"
+#include "util.h"
+
+
+#define DISPLAY_MAX_SINKS		8
+#define DISPLAY_IDLE_USEC		4000		//how often an exiting thread looks whether the main thread is done
+#define DISPLAY_STOP_WAITS		250			//and how many times, before it stops waiting
+#define DISPLAY_FRESH			0x80		//set in "mid" when it holds a frame not yet presented
+
+
+/*
+	Sinks that must stay on the main thread (SDL windows) are fed through a triple buffer: the emulator, which then
+	runs on a thread of its own, owns "back", the main thread owns "front" and "mid" is swapped atomically between
+	them, so neither ever waits for the other. A frame published before the last one was presented replaces it. The
+	main thread presents from displayPoll() and may wait for vsync there. All other sinks (recorders, shm, none) want
+	every frame as it is made and are handed the canvas right in displayPublish(). Without a main thread sink there
+	is no triple buffer and no second thread at all
+*/
+
+struct Display {
+	uint32_t w, h, winH;
+	uint16_t *canvas;
+	uint16_t *bufs[3];					//only with main thread sinks
+	uint8_t back;						//emulator thread only
+	uint8_t front;						//main thread only
+	atomic_uint_fast8_t mid;
+	bool mainOpen;						//main thread only
+	void *ctxs[DISPLAY_MAX_SINKS];
+	struct Display *next;
+};
+
+struct DisplaySinkUse {
+	const struct DisplaySink *sink;
+	const char *args;
+};
+
+
+static _Atomic(struct Display*) mDisplays = NULL;	//added to by the emulator, walked by the main thread
+static struct DisplaySinkUse mSinks[DISPLAY_MAX_SINKS];
+static uint_fast8_t mNumSinks = 0;
+static bool mHaveMain = false;
+static atomic_bool mMainLooping, mMainStop, mMainStopped;
+static pthread_t mMainThread;
+
+//4-bit channels to 5 and 6 bits, rounded
+static const uint8_t mExpand4to5[] = {0, 2, 4, 6, 8, 10, 12, 14, 17, 19, 21, 23, 25, 27, 29, 31};
+static const uint8_t mExpand4to6[] = {0, 4, 8, 13, 17, 21, 25, 29, 34, 38, 42, 46, 50, 55, 59, 63};
+
+
+
+///// SDL window sink
+
+struct DisplaySdl {
+	SDL_Renderer *renderer;
+	SDL_Window *window;
+	SDL_Texture *tex;
+	SDL_Rect dst;
+};
+
+static void* displayPrvSdlOpen(const char *args, uint32_t w, uint32_t h, uint32_t winH)
+{
+	struct DisplaySdl *sdl = (struct DisplaySdl*)calloc(1, sizeof(*sdl));
+
+	if (!sdl)
+		ERR("cannot alloc SDL display");
+
+	sdl->window = SDL_CreateWindow("uARM", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, w, winH, SDL_WINDOW_RESIZABLE);
+	if (!sdl->window)
+		ERR("Couldn't create window: %s\n", SDL_GetError());
+
+	//vsynced: only the main thread waits for it, the emulator never does
+	sdl->renderer = SDL_CreateRenderer(sdl->window, -1, SDL_RENDERER_PRESENTVSYNC);
+	if (!sdl->renderer)
+		ERR("Couldn't create renderer: %s\n", SDL_GetError());
+
+	//scaled to fit the window, mouse coordinates are scaled back for us
+	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+	SDL_RenderSetLogicalSize(sdl->renderer, w, winH);
+
+	sdl->tex = SDL_CreateTexture(sdl->renderer, SDL_PIXELFORMAT_RGB565, SDL_TEXTUREACCESS_STREAMING, w, h);
+	if (!sdl->tex)
+		ERR("Couldn't create screen texture: %s\n", SDL_GetError());
+
+	sdl->dst.x = 0;
+	sdl->dst.y = 0;
+	sdl->dst.w = w;
+	sdl->dst.h = h;
+
+	return sdl;
+}
+
+static void displayPrvSdlPresent(void *ctx, const uint16_t *pixels)
+{
+	struct DisplaySdl *sdl = (struct DisplaySdl*)ctx;
+
+	SDL_UpdateTexture(sdl->tex, NULL, pixels, sdl->dst.w * sizeof(uint16_t));
+	SDL_RenderClear(sdl->renderer);
+	SDL_RenderCopy(sdl->renderer, sdl->tex, NULL, &sdl->dst);
+	SDL_RenderPresent(sdl->renderer);
+}
+
+static void displayPrvSdlClose(void *ctx)
+{
+	struct DisplaySdl *sdl = (struct DisplaySdl*)ctx;
+
+	SDL_DestroyTexture(sdl->tex);
+	SDL_DestroyRenderer(sdl->renderer);
+	SDL_DestroyWindow(sdl->window);
+	free(sdl);
+}
+
+static const struct DisplaySink* displayPrvSdlSink(void)
+{
+	static const struct DisplaySink sink = {
+		.name = "sdl",
+		.help = "a window on the host (default)",
+		.open = displayPrvSdlOpen,
+		.present = displayPrvSdlPresent,
+		.close = displayPrvSdlClose,
+		.mainThread = true,
+	};
+	
+	return &sink;
+}
+
+
+///// headless sink: frames only live in the display's buffers
+
+static void* displayPrvNoneOpen(const char *args, uint32_t w, uint32_t h, uint32_t winH)
+{
+	static uint8_t dummy;
+
+	return &dummy;
+}
+
+static void displayPrvNoneNop(void *ctx)
+{
+	//nothing
+}
+
+static void displayPrvNonePresent(void *ctx, const uint16_t *pixels)
+{
+	//nothing
+}
+
+static const struct DisplaySink* displayPrvNoneSink(void)
+{
+	static const struct DisplaySink sink = {
+		.name = "none",
+		.help = "no output, for running headless",
+		.open = displayPrvNoneOpen,
+		.present = displayPrvNonePresent,
+		.close = displayPrvNoneNop,
+	};
+	
+	return &sink;
+}
+
+
+static const struct DisplaySink* (* const mKnownSinks[])(void) = {
+	displayPrvSdlSink,
+	displayPrvNoneSink,
+	shmioDisplaySink,
+	videoDisplaySink,
+};
+
+
+
+bool displayAddSink(const char *spec)
+{
+	const char *args = strchr(spec, ':');
+	size_t nameLen = args ? (size_t)(args++ - spec) : strlen(spec);
+	uint_fast8_t i;
+
+	if (mNumSinks == DISPLAY_MAX_SINKS)
+		return false;
+
+	for (i = 0; i < sizeof(mKnownSinks) / sizeof(*mKnownSinks); i++) {
+
+		const struct DisplaySink *sink = mKnownSinks[i]();
+
+		if (strlen(sink->name) != nameLen || strncmp(sink->name, spec, nameLen))
+			continue;
+
+		mSinks[mNumSinks].sink = sink;
+		mSinks[mNumSinks].args = args;
+		mNumSinks++;
+
+		return true;
+	}
+
+	return false;
+}
+
+void displayListSinks(FILE *f)
+{
+	uint_fast8_t i;
+
+	for (i = 0; i < sizeof(mKnownSinks) / sizeof(*mKnownSinks); i++)
+		fprintf(f, "\t%-16s %s\n", mKnownSinks[i]()->name, mKnownSinks[i]()->help);
+}
+
+void displaySinksConfigured(void)
+{
+	uint_fast8_t i;
+
+	if (!mNumSinks)
+		displayAddSink(displayPrvSdlSink()->name);
+
+	for (i = 0; i < mNumSinks; i++) {
+		if (mSinks[i].sink->prepare && !mSinks[i].sink->prepare(mSinks[i].args))
+			ERR("Couldn't set up display output '%s'\n", mSinks[i].sink->name);
+	}
+
+	for (i = 0; i < mNumSinks; i++)
+		mHaveMain = mHaveMain || mSinks[i].sink->mainThread;
+
+	for (i = 0; i < mNumSinks && mSinks[i].sink != displayPrvSdlSink(); i++);
+
+	//no window wanted - SDL still gets initialized (events, audio) so let it do that with no display around
+	if (i == mNumSinks)
+		setenv("SDL_VIDEODRIVER", "dummy", 0);
+}
+
+
+///// conversion kernels. simple loops with no cross-iteration state so the compiler can vectorize them
+
+static inline uint_fast16_t displayPrvRgb444to565(uint_fast16_t r, uint_fast16_t g, uint_fast16_t b)
+{
+	return (((uint_fast16_t)mExpand4to5[r]) << 11) | (((uint_fast16_t)mExpand4to6[g]) << 5) | mExpand4to5[b];
+}
+
+#ifdef __SSE2__
+
+	/*
+		Host vector versions of the palette and RGB565 kernels, the formats LCD controllers use most. Each does whole
+		bytes of source and says how many pixels that was, the plain C below does the rest of the row. Palettes of
+		256 entries are left to the plain C as well: without a gather, a table lookup per pixel is already the fastest
+	*/
+
+	static __m128i displayPrvSimdSelect(__m128i mask, __m128i clear, __m128i set)
+	{
+		return _mm_or_si128(_mm_andnot_si128(mask, clear), _mm_and_si128(mask, set));
+	}
+
+	static uint32_t displayPrvSimdPal1(uint16_t *dst, const uint8_t *src, uint32_t numPix, bool msb, const uint16_t *pal)
+	{
+		const __m128i bits = msb ? _mm_set_epi16(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80) : _mm_set_epi16(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+		const __m128i p0 = _mm_set1_epi16(pal[0]), p1 = _mm_set1_epi16(pal[1]);
+		uint32_t i;
+
+		for (i = 0; i + 8 <= numPix; i += 8) {
+
+			__m128i set = _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(src[i / 8]), bits), bits);
+
+			_mm_storeu_si128((__m128i*)(dst + i), displayPrvSimdSelect(set, p0, p1));
+		}
+
+		return i;
+	}
+
+	static uint32_t displayPrvSimdPal2(uint16_t *dst, const uint8_t *src, uint32_t numPix, bool msb, const uint16_t *pal)
+	{
+		//multiplying moves each lane's pixel to bits 6..7, since there is no per-lane shift
+		const __m128i mul = msb ? _mm_set_epi16(64, 16, 4, 1, 64, 16, 4, 1) : _mm_set_epi16(1, 4, 16, 64, 1, 4, 16, 64);
+		const __m128i p0 = _mm_set1_epi16(pal[0]), p1 = _mm_set1_epi16(pal[1]), p2 = _mm_set1_epi16(pal[2]), p3 = _mm_set1_epi16(pal[3]);
+		const __m128i one = _mm_set1_epi16(1), two = _mm_set1_epi16(2);
+		uint32_t i;
+
+		for (i = 0; i + 8 <= numPix; i += 8) {
+
+			__m128i v = _mm_set_epi16(src[i / 4 + 1], src[i / 4 + 1], src[i / 4 + 1], src[i / 4 + 1], src[i / 4], src[i / 4], src[i / 4], src[i / 4]);
+			__m128i idx = _mm_srli_epi16(_mm_mullo_epi16(v, mul), 6);
+			__m128i lo = _mm_cmpeq_epi16(_mm_and_si128(idx, one), one), hi = _mm_cmpeq_epi16(_mm_and_si128(idx, two), two);
+
+			_mm_storeu_si128((__m128i*)(dst + i), displayPrvSimdSelect(hi, displayPrvSimdSelect(lo, p0, p1), displayPrvSimdSelect(lo, p2, p3)));
+		}
+
+		return i;
+	}
+
+	//a 16-entry palette fits in a pair of byte shuffles. only called once the host has been seen to have SSSE3
+	static __attribute__((target("ssse3"))) uint32_t displayPrvSimdPal4(uint16_t *dst, const uint8_t *src, uint32_t numPix, bool msb, const uint16_t *pal)
+	{
+		const __m128i nibble = _mm_set1_epi8(0x0f);
+		uint8_t palLo[16], palHi[16];
+		__m128i tabLo, tabHi;
+		uint32_t i;
+
+		for (i = 0; i < 16; i++) {
+			palLo[i] = pal[i];
+			palHi[i] = pal[i] >> 8;
+		}
+		tabLo = _mm_loadu_si128((const __m128i*)palLo);
+		tabHi = _mm_loadu_si128((const __m128i*)palHi);
+
+		for (i = 0; i + 16 <= numPix; i += 16) {
+
+			__m128i v = _mm_loadl_epi64((const __m128i*)(src + i / 2)), top = _mm_and_si128(_mm_srli_epi16(v, 4), nibble), bottom = _mm_and_si128(v, nibble);
+			__m128i idx = msb ? _mm_unpacklo_epi8(top, bottom) : _mm_unpacklo_epi8(bottom, top);
+			__m128i lo = _mm_shuffle_epi8(tabLo, idx), hi = _mm_shuffle_epi8(tabHi, idx);
+
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi8(lo, hi));
+			_mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpackhi_epi8(lo, hi));
+		}
+
+		return i;
+	}
+
+	static uint32_t displayPrvSimdRgb565(uint16_t *dst, const uint8_t *src, uint32_t numPix, bool be)
+	{
+		uint32_t i;
+
+		for (i = 0; i + 8 <= numPix; i += 8) {
+
+			__m128i v = _mm_loadu_si128((const __m128i*)(src + i * 2));
+
+			if (be)
+				v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			_mm_storeu_si128((__m128i*)(dst + i), v);
+		}
+
+		return i;
+	}
+
+	static uint32_t displayPrvSimdSpan(uint16_t *dst, const uint8_t *src, uint32_t numPix, uint_fast8_t fmt, const uint16_t *pal)
+	{
+		bool msb = !!(fmt & DISPLAY_PIX_MSB_FIRST);
+
+		if (fmt & DISPLAY_PIX_PLAIN_C)
+			return 0;
+
+		switch (fmt & DISPLAY_PIX_FMT_MASK) {
+
+			case DisplayPixPal1:
+				return displayPrvSimdPal1(dst, src, numPix, msb, pal);
+
+			case DisplayPixPal2:
+				return displayPrvSimdPal2(dst, src, numPix, msb, pal);
+
+			case DisplayPixPal4:
+				return __builtin_cpu_supports("ssse3") ? displayPrvSimdPal4(dst, src, numPix, msb, pal) : 0;
+
+			case DisplayPixRgb565:
+				return displayPrvSimdRgb565(dst, src, numPix, !!(fmt & DISPLAY_PIX_BIG_ENDIAN));
+
+			default:
+				return 0;
+		}
+	}
+
+#endif
+
+void displayConvertSpan(uint16_t *dst, const uint8_t *src, uint32_t numPix, uint_fast8_t fmt, const uint16_t *pal)
+{
+	bool msb = !!(fmt & DISPLAY_PIX_MSB_FIRST), be = !!(fmt & DISPLAY_PIX_BIG_ENDIAN);
+	uint_fast16_t r, g, b;
+	uint32_t i, v, n;
+
+#ifdef __SSE2__
+	i = displayPrvSimdSpan(dst, src, numPix, fmt, pal);
+	dst += i;
+	src += displayRowBytes(fmt, i);
+	numPix -= i;
+#endif
+
+	switch (fmt & DISPLAY_PIX_FMT_MASK) {
+
+		case DisplayPixPal1:
+			if (msb) {
+				for (i = 0; i < numPix; i++)
+					dst[i] = pal[(src[i / 8] >> (7 - i % 8)) & 1];
+			}
+			else {
+				for (i = 0; i < numPix; i++)
+					dst[i] = pal[(src[i / 8] >> (i % 8)) & 1];
+			}
+			break;
+
+		case DisplayPixPal2:
+			if (msb) {
+				for (i = 0; i < numPix; i++)
+					dst[i] = pal[(src[i / 4] >> (6 - i % 4 * 2)) & 3];
+			}
+			else {
+				for (i = 0; i < numPix; i++)
+					dst[i] = pal[(src[i / 4] >> (i % 4 * 2)) & 3];
+			}
+			break;
+
+		case DisplayPixPal4:
+			if (msb) {
+				for (i = 0; i < numPix; i++)
+					dst[i] = pal[(src[i / 2] >> (4 - i % 2 * 4)) & 15];
+			}
+			else {
+				for (i = 0; i < numPix; i++)
+					dst[i] = pal[(src[i / 2] >> (i % 2 * 4)) & 15];
+			}
+			break;
+
+		case DisplayPixPal8:
+			for (i = 0; i < numPix; i++)
+				dst[i] = pal[src[i]];
+			break;
+
+		case DisplayPixRgb565:
+			if (be) {
+				for (i = 0; i < numPix; i++)
+					dst[i] = (src[i * 2 + 0] << 8) + src[i * 2 + 1];
+			}
+			else {
+				for (i = 0; i < numPix; i++)
+					dst[i] = src[i * 2 + 0] + (src[i * 2 + 1] << 8);
+			}
+			break;
+
+		case DisplayPixRgb444:
+			for (i = 0; i < numPix; i++) {
+				v = be ? (src[i * 2 + 0] << 8) + src[i * 2 + 1] : src[i * 2 + 0] + (src[i * 2 + 1] << 8);
+				dst[i] = displayPrvRgb444to565((v >> 8) & 15, (v >> 4) & 15, v & 15);
+			}
+			break;
+
+		case DisplayPixRgb444Packed:
+			for (i = 0, n = 0; i < numPix; i++, n += 3) {
+				if (msb) {
+					r = (src[(n + 0) / 2] >> ((n + 0) % 2 ? 0 : 4)) & 15;
+					g = (src[(n + 1) / 2] >> ((n + 1) % 2 ? 0 : 4)) & 15;
+					b = (src[(n + 2) / 2] >> ((n + 2) % 2 ? 0 : 4)) & 15;
+				}
+				else {
+					r = (src[(n + 0) / 2] >> ((n + 0) % 2 * 4)) & 15;
+					g = (src[(n + 1) / 2] >> ((n + 1) % 2 * 4)) & 15;
+					b = (src[(n + 2) / 2] >> ((n + 2) % 2 * 4)) & 15;
+				}
+				dst[i] = displayPrvRgb444to565(r, g, b);
+			}
+			break;
+
+		case DisplayPixRgb666:
+		case DisplayPixRgb888:
+			for (i = 0; i < numPix; i++) {
+				if (be)
+					v = (((uint32_t)src[i * 4 + 0]) << 24) + (((uint32_t)src[i * 4 + 1]) << 16) + (((uint32_t)src[i * 4 + 2]) << 8) + src[i * 4 + 3];
+				else
+					v = (((uint32_t)src[i * 4 + 3]) << 24) + (((uint32_t)src[i * 4 + 2]) << 16) + (((uint32_t)src[i * 4 + 1]) << 8) + src[i * 4 + 0];
+
+				if ((fmt & DISPLAY_PIX_FMT_MASK) == DisplayPixRgb666)
+					dst[i] = ((v >> 7) & 0xf800) | ((v >> 1) & 0x07e0) | ((v >> 1) & 0x001f);
+				else
+					dst[i] = ((v >> 8) & 0xf800) | ((v >> 5) & 0x07e0) | ((v >> 3) & 0x001f);
+			}
+			break;
+
+		default:
+			ERR("unknown pixel format 0x%02x\n", (unsigned)fmt);
+			break;
+	}
+}
+
+uint32_t displayRowBytes(uint_fast8_t fmt, uint32_t w)
+{
+	static const uint8_t bitsPerPixel[] = {
+		[DisplayPixPal1] = 1,
+		[DisplayPixPal2] = 2,
+		[DisplayPixPal4] = 4,
+		[DisplayPixPal8] = 8,
+		[DisplayPixRgb565] = 16,
+		[DisplayPixRgb444] = 16,
+		[DisplayPixRgb444Packed] = 12,
+		[DisplayPixRgb666] = 32,
+		[DisplayPixRgb888] = 32,
+	};
+
+	return (w * bitsPerPixel[fmt & DISPLAY_PIX_FMT_MASK] + 7) / 8;
+}
+
+
+///// the display itself
+
+static void displayPrvMainClose(void)
+{
+	struct Display *disp;
+	uint_fast8_t i;
+
+	for (disp = atomic_load(&mDisplays); disp; disp = disp->next) {
+
+		if (!disp->mainOpen)
+			continue;
+
+		for (i = 0; i < mNumSinks; i++) {
+			if (mSinks[i].sink->mainThread)
+				mSinks[i].sink->close(disp->ctxs[i]);
+		}
+		disp->mainOpen = false;
+	}
+}
+
+static void displayPrvStopAll(void)
+{
+	struct Display *disp;
+	uint_fast8_t i;
+
+	for (disp = atomic_load(&mDisplays); disp; disp = disp->next) {
+
+		for (i = 0; i < mNumSinks; i++) {
+			if (!mSinks[i].sink->mainThread)
+				mSinks[i].sink->close(disp->ctxs[i]);
+		}
+	}
+
+	//main thread sinks are closed by the main thread, which we ask to and give a while to do it
+	if (!atomic_load(&mMainLooping) || pthread_equal(pthread_self(), mMainThread))
+		displayPrvMainClose();
+	else {
+
+		atomic_store(&mMainStop, true);
+		for (i = 0; i < DISPLAY_STOP_WAITS && !atomic_load(&mMainStopped); i++)
+			usleep(DISPLAY_IDLE_USEC);
+	}
+}
+
+struct Display* displayInit(uint32_t w, uint32_t h, uint32_t winH)
+{
+	struct Display *disp = (struct Display*)malloc(sizeof(*disp));
+	uint_fast8_t i;
+
+	if (!disp)
+		ERR("cannot alloc display");
+
+	if (!mNumSinks)
+		displaySinksConfigured();
+
+	memset(disp, 0, sizeof (*disp));
+	disp->w = w;
+	disp->h = h;
+	disp->winH = winH;
+
+	disp->canvas = (uint16_t*)calloc(w * h, sizeof(uint16_t));
+	if (!disp->canvas)
+		ERR("cannot alloc display canvas");
+
+	for (i = 0; mHaveMain && i < 3; i++) {
+		disp->bufs[i] = (uint16_t*)calloc(w * h, sizeof(uint16_t));
+		if (!disp->bufs[i])
+			ERR("cannot alloc display buffer");
+	}
+	disp->back = 0;
+	atomic_init(&disp->mid, 1);
+	disp->front = 2;
+
+	fprintf(stderr, "SCREEN configured for %u x %u\n", (unsigned)w, (unsigned)h);
+
+	for (i = 0; i < mNumSinks; i++) {
+
+		if (mSinks[i].sink->mainThread)
+			continue;
+
+		disp->ctxs[i] = mSinks[i].sink->open(mSinks[i].args, w, h, winH);
+		if (!disp->ctxs[i])
+			ERR("Couldn't open display output '%s'\n", mSinks[i].sink->name);
+	}
+
+	if (!atomic_load(&mDisplays))
+		atexit(displayPrvStopAll);
+	disp->next = atomic_load(&mDisplays);
+	atomic_store(&mDisplays, disp);
+
+	return disp;
+}
+
+bool displayNeedsMainThread(void)
+{
+	return mHaveMain;
+}
+
+void displayFill(struct Display *disp, uint16_t color)
+{
+	uint32_t i;
+
+	for (i = 0; i < disp->w * disp->h; i++)
+		disp->canvas[i] = color;
+}
+
+void displayDrawRow(struct Display *disp, uint32_t row, const void *src, uint32_t srcW, uint_fast8_t fmt, const uint16_t *pal)
+{
+	uint16_t *dst = disp->canvas + row * disp->w;
+
+	if (row >= disp->h)
+		return;
+
+	//the guest may shrink the screen after we opened it, so never read past its row and blank what it no longer covers
+	if (srcW > disp->w)
+		srcW = disp->w;
+	displayConvertSpan(dst, (const uint8_t*)src, srcW, fmt, pal);
+	memset(dst + srcW, 0, (disp->w - srcW) * sizeof(uint16_t));
+}
+
+void displayPublish(struct Display *disp)
+{
+	uint_fast8_t i;
+
+	for (i = 0; i < mNumSinks; i++) {
+		if (!mSinks[i].sink->mainThread)
+			mSinks[i].sink->present(disp->ctxs[i], disp->canvas);
+	}
+
+	if (mHaveMain) {
+		memcpy(disp->bufs[disp->back], disp->canvas, disp->w * disp->h * sizeof(uint16_t));
+		disp->back = atomic_exchange(&disp->mid, disp->back | DISPLAY_FRESH) &~ DISPLAY_FRESH;
+	}
+}
+
+bool displayPoll(void)
+{
+	struct Display *disp;
+	bool shown = false;
+	uint_fast8_t i;
+
+	if (!atomic_load(&mMainLooping)) {
+		mMainThread = pthread_self();
+		atomic_store(&mMainLooping, true);
+	}
+
+	//another thread is exiting. we close our sinks and leave the rest to it
+	if (atomic_load(&mMainStop)) {
+		displayPrvMainClose();
+		atomic_store(&mMainStopped, true);
+		while (1)
+			pause();
+	}
+
+	for (disp = atomic_load(&mDisplays); disp; disp = disp->next) {
+
+		if (!disp->mainOpen) {
+
+			for (i = 0; i < mNumSinks; i++) {
+
+				if (!mSinks[i].sink->mainThread)
+					continue;
+
+				disp->ctxs[i] = mSinks[i].sink->open(mSinks[i].args, disp->w, disp->h, disp->winH);
+				if (!disp->ctxs[i])
+					ERR("Couldn't open display output '%s'\n", mSinks[i].sink->name);
+			}
+			disp->mainOpen = true;
+		}
+
+		if (!(atomic_load(&disp->mid) & DISPLAY_FRESH))
+			continue;
+
+		disp->front = atomic_exchange(&disp->mid, disp->front) &~ DISPLAY_FRESH;
+
+		for (i = 0; i < mNumSinks; i++) {
+			if (mSinks[i].sink->mainThread)
+				mSinks[i].sink->present(disp->ctxs[i], disp->bufs[disp->front]);
+		}
+		shown = true;
+	}
+
+	return shown;
+}
@@ -0,0 +1,67 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _DISPLAY_H_
+#define _DISPLAY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+struct Display;
+
+
+//framebuffer pixel formats LCD controllers hand us. output is always RGB565
+enum DisplayPixFmt {
+	DisplayPixPal1,
+	DisplayPixPal2,
+	DisplayPixPal4,
+	DisplayPixPal8,
+	DisplayPixRgb565,				//16 bits per pixel
+	DisplayPixRgb444,				//16 bits per pixel: 0000RRRRGGGGBBBB
+	DisplayPixRgb444Packed,			//12 bits per pixel, as a stream of nibbles: R, G, B, R, G, ...
+	DisplayPixRgb666,				//32 bits per pixel: 00000000000000RRRRRRGGGGGGBBBBBB
+	DisplayPixRgb888,				//32 bits per pixel: 00000000RRRRRRRRGGGGGGGGBBBBBBBB
+};
+
+#define DISPLAY_PIX_FMT_MASK		0x0f
+#define DISPLAY_PIX_MSB_FIRST		0x80	//for formats under 8bpp: first pixel is in the top bits of a byte (else bottom bits)
+#define DISPLAY_PIX_BIG_ENDIAN		0x40	//for 16 and 32 bit formats (else little endian)
+#define DISPLAY_PIX_PLAIN_C			0x20	//skip the host vector kernels, to check or time them against the plain C
+
+
+//a sink gets every published frame as it is made, on the emulator's thread, so it must not block. contexts are per-display
+struct DisplaySink {
+	const char *name;
+	const char *help;
+	bool (*prepare)(const char *args);										//once, from displaySinksConfigured(). may be NULL
+	void* (*open)(const char *args, uint32_t w, uint32_t h, uint32_t winH);	//NULL on failure
+	void (*present)(void *ctx, const uint16_t *pixels);
+	void (*close)(void *ctx);
+	bool mainThread;			//opened, presented and closed on the main thread instead, from displayPoll(). gets the newest frame only
+};
+
+//sinks are picked before any display exists. "name" or "name:args". with none picked, frames go to an SDL window
+bool displayAddSink(const char *spec);
+void displayListSinks(FILE *f);
+void displaySinksConfigured(void);	//call once all sinks are added
+
+//a w x h screen shown at the top of a w x winH area
+struct Display* displayInit(uint32_t w, uint32_t h, uint32_t winH);
+
+//the canvas persists between frames, so only changed rows need to be redrawn. publishing copies it out and never blocks
+//the display keeps the size it was opened at, rows of srcW pixels are cut or padded with black to fit it
+void displayFill(struct Display *disp, uint16_t color);
+void displayDrawRow(struct Display *disp, uint32_t row, const void *src, uint32_t srcW, uint_fast8_t fmt, const uint16_t *pal);
+void displayPublish(struct Display *disp);
+
+uint32_t displayRowBytes(uint_fast8_t fmt, uint32_t w);
+void displayConvertSpan(uint16_t *dst, const uint8_t *src, uint32_t numPix, uint_fast8_t fmt, const uint16_t *pal);
+
+//with main thread sinks picked, the emulator must run on a thread of its own while the main thread keeps calling
+//displayPoll(), which presents the newest frame to them and is true if it did. it does not return once the process exits
+bool displayNeedsMainThread(void);
+bool displayPoll(void);
+
+
+#endif
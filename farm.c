@@ -0,0 +1,275 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <sys/wait.h>
+#include <signal.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <time.h>
+#include "farm.h"
+#include "util.h"
+
+
+/*
+	A farm runs a list of emulator runs (a regression suite, say) on a pool of workers. The SoC keeps its state in
+	globals and has no teardown (see SoC.h), so a worker is a process: each job is this very binary run again with
+	the job's options, and a worker that finishes one takes the next job off the list, so busy workers never hold up
+	idle ones. ROM and SD base images are mapped, so all runs of one image share their pages.
+
+	Job file: one job per line, "NAME OPTION...", with options as on the command line, split at whitespace (there is
+	no quoting). Empty lines and lines starting with "#" are skipped. For example:
+
+		t3-boot		-d PalmTungstenT3 -r T3.rom -o none -a none -t -P t3-boot.trace
+		z71-app		-d PalmZire71 -r Z71.rom -o shm:z71-app -a none -s app.img --sd-overlay z71-app.delta
+
+	Each job's console (the debug serial port with the default "-u stdio", and its messages) is streamed to our
+	stdout a line at a time, prefixed with its name. Frames go wherever the job's "-o" and "--record-video" send
+	them. How each job ended is printed to stderr
+*/
+
+#define FARM_MAX_ARGS			64
+#define FARM_MAX_WORKERS		256
+#define FARM_LINE_MAX			1024		//longer console lines are split
+#define FARM_POLL_MSEC			100			//how often we look at time limits when jobs are quiet
+
+
+struct FarmJob {
+	char *name;
+	char *argv[FARM_MAX_ARGS + 2];
+	pid_t pid;
+	int fd;
+	uint64_t startedAt;
+	bool killed;
+	char line[FARM_LINE_MAX];
+	uint32_t lineLen;
+};
+
+
+static uint64_t farmPrvNanoTime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static struct FarmJob* farmPrvLoad(const char *self, const char *jobFileName, uint32_t *numJobsP)
+{
+	uint32_t numJobs = 0, numAlloced = 0, lineNo = 0, i;
+	struct FarmJob *jobs = NULL, *job;
+	char line[4096], *tok;
+	FILE *f;
+
+	f = fopen(jobFileName, "r");
+	if (!f) {
+
+		fprintf(stderr, "Cannot open job file '%s'\n", jobFileName);
+		return NULL;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+
+		lineNo++;
+		tok = strtok(line, " \t\r\n");
+		if (!tok || tok[0] == '#')
+			continue;
+
+		if (numJobs == numAlloced) {
+
+			numAlloced = numAlloced ? numAlloced * 2 : 64;
+			jobs = (struct FarmJob*)realloc(jobs, sizeof(struct FarmJob) * numAlloced);
+			if (!jobs)
+				ERR("cannot alloc farm jobs\n");
+		}
+		job = &jobs[numJobs++];
+		memset(job, 0, sizeof(*job));
+		job->fd = -1;
+		job->name = strdup(tok);
+		job->argv[0] = (char*)self;
+
+		for (i = 1; (tok = strtok(NULL, " \t\r\n")) != NULL; i++) {
+
+			if (i > FARM_MAX_ARGS) {
+
+				fprintf(stderr, "Job file '%s' line %u has over %u options\n", jobFileName, lineNo, FARM_MAX_ARGS);
+				fclose(f);
+				return NULL;
+			}
+			job->argv[i] = strdup(tok);
+		}
+	}
+	fclose(f);
+
+	if (!numJobs) {
+
+		fprintf(stderr, "Job file '%s' has no jobs\n", jobFileName);
+		return NULL;
+	}
+
+	*numJobsP = numJobs;
+	return jobs;
+}
+
+static void farmPrvStart(struct FarmJob *job, const char *self)
+{
+	int pipeFds[2], nullFd;
+
+	//only this job's end goes to its process, not the ones of the jobs already running
+	if (pipe(pipeFds) || fcntl(pipeFds[0], F_SETFD, FD_CLOEXEC))
+		ERR("cannot create farm pipe\n");
+
+	fflush(stdout);
+	fflush(stderr);
+
+	job->pid = fork();
+	if (job->pid < 0)
+		ERR("cannot fork farm job\n");
+
+	if (!job->pid) {
+
+		//the console is a pipe and there is nobody to type into it
+		nullFd = open("/dev/null", O_RDONLY);
+		if (nullFd < 0 || dup2(nullFd, 0) < 0 || dup2(pipeFds[1], 1) < 0 || dup2(pipeFds[1], 2) < 0)
+			_exit(127);
+		close(nullFd);
+		close(pipeFds[0]);
+		close(pipeFds[1]);
+		signal(SIGPIPE, SIG_DFL);
+		setpgid(0, 0);		//so a time limit also gets whatever the job started (benchmarks fork)
+
+		execv("/proc/self/exe", job->argv);
+		execvp(self, job->argv);
+		_exit(127);
+	}
+
+	close(pipeFds[1]);
+	job->fd = pipeFds[0];
+	job->startedAt = farmPrvNanoTime();
+	fprintf(stderr, "farm: %s started\n", job->name);
+}
+
+static void farmPrvFlushLine(struct FarmJob *job)
+{
+	printf("%s: %.*s\n", job->name, (int)job->lineLen, job->line);
+	job->lineLen = 0;
+}
+
+//false once the job closed its end, which it does by exiting
+static bool farmPrvRead(struct FarmJob *job)
+{
+	char buf[4096];
+	ssize_t i, len;
+
+	len = read(job->fd, buf, sizeof(buf));
+	if (len < 0)
+		return errno == EINTR;
+
+	for (i = 0; i < len; i++) {
+
+		if (buf[i] == '\n')
+			farmPrvFlushLine(job);
+		else {
+			job->line[job->lineLen++] = buf[i];
+			if (job->lineLen == sizeof(job->line))
+				farmPrvFlushLine(job);
+		}
+	}
+	fflush(stdout);
+
+	return len > 0;
+}
+
+//true if it exited with 0
+static bool farmPrvReap(struct FarmJob *job)
+{
+	double secs = (farmPrvNanoTime() - job->startedAt) / 1000000000.0;
+	int status;
+
+	if (job->lineLen)
+		farmPrvFlushLine(job);
+	fflush(stdout);
+
+	close(job->fd);
+	job->fd = -1;
+
+	if (waitpid(job->pid, &status, 0) != job->pid)
+		ERR("cannot wait for farm job '%s'\n", job->name);
+
+	if (job->killed)
+		fprintf(stderr, "farm: %s hit the time limit after %.1f sec\n", job->name, secs);
+	else if (WIFEXITED(status))
+		fprintf(stderr, "farm: %s exited with %d after %.1f sec\n", job->name, (signed char)WEXITSTATUS(status), secs);
+	else
+		fprintf(stderr, "farm: %s died of signal %d after %.1f sec\n", job->name, WTERMSIG(status), secs);
+
+	return !job->killed && WIFEXITED(status) && !WEXITSTATUS(status);
+}
+
+bool farmRun(const char *self, const char *jobFileName, uint32_t numWorkers, uint32_t maxSecs)
+{
+	uint32_t numJobs, next = 0, numRunning = 0, numFailed = 0, i, n;
+	struct FarmJob *jobs, *running[FARM_MAX_WORKERS];
+	struct pollfd fds[FARM_MAX_WORKERS];
+	long numCpus;
+
+	jobs = farmPrvLoad(self, jobFileName, &numJobs);
+	if (!jobs)
+		return false;
+
+	if (!numWorkers) {
+		numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+		numWorkers = numCpus > 0 ? numCpus : 1;
+	}
+	if (numWorkers > FARM_MAX_WORKERS)
+		numWorkers = FARM_MAX_WORKERS;
+
+	//whoever reads our output may stop early, which should not kill us with jobs still running
+	signal(SIGPIPE, SIG_IGN);
+
+	while (next < numJobs || numRunning) {
+
+		while (next < numJobs && numRunning < numWorkers) {
+
+			farmPrvStart(&jobs[next], self);
+			running[numRunning++] = &jobs[next++];
+		}
+
+		for (i = 0; i < numRunning; i++) {
+			fds[i].fd = running[i]->fd;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+
+		if (poll(fds, numRunning, FARM_POLL_MSEC) < 0)
+			continue;
+
+		for (i = 0, n = 0; i < numRunning; i++) {
+
+			struct FarmJob *job = running[i];
+
+			if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && !farmPrvRead(job)) {
+
+				if (!farmPrvReap(job))
+					numFailed++;
+				continue;
+			}
+
+			if (maxSecs && !job->killed && farmPrvNanoTime() - job->startedAt > maxSecs * 1000000000ULL) {
+
+				kill(-job->pid, SIGKILL);
+				job->killed = true;
+			}
+			running[n++] = job;
+		}
+		numRunning = n;
+	}
+
+	fprintf(stderr, "farm: %u of %u jobs failed\n", numFailed, numJobs);
+
+	return !numFailed;
+}
@@ -0,0 +1,15 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _FARM_H_
+#define _FARM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+//runs every job in the file as an emulator process of its own, at most numWorkers (0 for one per host CPU) at a time,
+//killing any that run over maxSecs (0 for no limit). job lines are "NAME OPTION...", see farm.c. true if all exited with 0
+bool farmRun(const char *self, const char *jobFileName, uint32_t numWorkers, uint32_t maxSecs);
+
+
+#endif
@@ -0,0 +1,582 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#define _GNU_SOURCE		//accept4, ptys
+
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <arpa/inet.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "hostio.h"
+#include "util.h"
+#include "SoC.h"
+
+
+#define HOSTIO_MAX_ENDPOINTS	8
+#define HOSTIO_RING_SIZE		0x10000		//power of 2
+#define HOSTIO_RECHECK_MSEC		10			//how often we look at things epoll cannot tell us about
+
+
+enum HostIoRole {
+	HostIoRoleWake,
+	HostIoRoleListen,
+	HostIoRoleIn,
+	HostIoRoleOut,
+	HostIoRoleInOut,
+};
+
+//single producer, single consumer. indices run freely and are only reduced to positions on use
+struct HostIoRing {
+	atomic_uint_fast32_t head, tail;
+	uint8_t buf[HOSTIO_RING_SIZE];
+};
+
+struct HostIo {
+	struct HostIoRing rx, tx;			//rx is filled by our thread, tx by the emulator
+	int inFd, outFd, listenFd, ptySlaveFd;
+	uint32_t inEvts, outEvts;			//what epoll watches them for
+	bool inPolled, outPolled;			//epoll cannot watch these (regular files), we just try them
+	bool isSocket;
+	atomic_bool hasReader;				//someone is draining tx
+	atomic_bool txWaiting;				//the emulator is waiting on spaceFd for room in tx
+	int spaceFd;						//eventfd our thread signals when tx drains or loses its reader
+	int savedOutFl;						//fd flags to put back on exit if we had to change the original fd
+	char *unixPath;
+	uint8_t idx;
+};
+
+
+static struct HostIo *mEndpoints[HOSTIO_MAX_ENDPOINTS];
+static atomic_uint_fast8_t mNumEndpoints = 0;
+static int mEpollFd = -1, mWakeFd = -1;
+static atomic_bool mStop = false;
+static pthread_t mThread;
+
+
+
+static uint32_t hostIoPrvRingUsed(struct HostIoRing *r)
+{
+	return atomic_load(&r->head) - atomic_load(&r->tail);
+}
+
+static void hostIoPrvCtl(int op, int fd, uint32_t *curEvtsP, uint32_t evts, uint8_t idx, enum HostIoRole role)
+{
+	struct epoll_event evt = {.events = evts, .data.u64 = (((uint64_t)idx) << 8) | role, };
+
+	if (op == EPOLL_CTL_MOD && *curEvtsP == evts)
+		return;
+
+	if (epoll_ctl(mEpollFd, op, fd, &evt))
+		ERR("epoll_ctl failed: %d\n", errno);
+	*curEvtsP = evts;
+}
+
+//returns false if epoll cannot watch this kind of fd
+static bool hostIoPrvAdd(int fd, uint32_t *curEvtsP, uint8_t idx, enum HostIoRole role)
+{
+	struct epoll_event evt = {.events = 0, .data.u64 = (((uint64_t)idx) << 8) | role, };
+
+	if (!epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &evt)) {
+		*curEvtsP = 0;
+		return true;
+	}
+
+	if (errno != EPERM)
+		ERR("epoll_ctl failed: %d\n", errno);
+
+	return false;
+}
+
+//only our thread calls this once an endpoint is published
+static void hostIoPrvWatch(struct HostIo *io)
+{
+	uint32_t in = 0, out = 0;
+
+	if (io->inFd >= 0 && !io->inPolled && hostIoPrvRingUsed(&io->rx) != HOSTIO_RING_SIZE)
+		in = EPOLLIN;
+	if (io->outFd >= 0 && !io->outPolled && hostIoPrvRingUsed(&io->tx))
+		out = EPOLLOUT;
+
+	if (io->inFd >= 0 && io->inFd == io->outFd)
+		hostIoPrvCtl(EPOLL_CTL_MOD, io->inFd, &io->inEvts, in | out, io->idx, HostIoRoleInOut);
+	else {
+		if (io->inFd >= 0 && !io->inPolled)
+			hostIoPrvCtl(EPOLL_CTL_MOD, io->inFd, &io->inEvts, in, io->idx, HostIoRoleIn);
+		if (io->outFd >= 0 && !io->outPolled)
+			hostIoPrvCtl(EPOLL_CTL_MOD, io->outFd, &io->outEvts, out, io->idx, HostIoRoleOut);
+	}
+}
+
+static void hostIoPrvSignalSpace(struct HostIo *io)
+{
+	uint64_t one = 1;
+
+	if (atomic_exchange(&io->txWaiting, false) && write(io->spaceFd, &one, sizeof(one)) < 0) {
+		//counter is saturated, so the writer will see it anyways
+	}
+}
+
+static void hostIoPrvDisconnect(struct HostIo *io, bool in, bool out)
+{
+	if (io->inFd >= 0 && io->inFd == io->outFd) {		//a client socket goes as a whole
+
+		epoll_ctl(mEpollFd, EPOLL_CTL_DEL, io->inFd, NULL);
+		close(io->inFd);
+		io->inFd = -1;
+		io->outFd = -1;
+		atomic_store(&io->hasReader, false);
+		hostIoPrvSignalSpace(io);
+		return;
+	}
+
+	//stdio: stop using whichever side failed, but leave it open
+	if (in && io->inFd >= 0) {
+		if (!io->inPolled)
+			epoll_ctl(mEpollFd, EPOLL_CTL_DEL, io->inFd, NULL);
+		io->inFd = -1;
+	}
+	if (out && io->outFd >= 0) {
+		if (!io->outPolled)
+			epoll_ctl(mEpollFd, EPOLL_CTL_DEL, io->outFd, NULL);
+		io->outFd = -1;
+		atomic_store(&io->hasReader, false);
+		hostIoPrvSignalSpace(io);
+	}
+}
+
+static void hostIoPrvPumpRx(struct HostIo *io)
+{
+	struct HostIoRing *r = &io->rx;
+	uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	uint32_t pos = head % HOSTIO_RING_SIZE, len = HOSTIO_RING_SIZE - (head - atomic_load(&r->tail));
+	ssize_t now;
+
+	if (len > HOSTIO_RING_SIZE - pos)
+		len = HOSTIO_RING_SIZE - pos;
+	if (!len || io->inFd < 0)
+		return;
+
+	now = read(io->inFd, r->buf + pos, len);
+	if (now > 0)
+		atomic_store(&r->head, head + now);
+	else if (!now || (errno != EAGAIN && errno != EINTR))
+		hostIoPrvDisconnect(io, true, false);
+}
+
+static void hostIoPrvPumpTx(struct HostIo *io)
+{
+	struct HostIoRing *r = &io->tx;
+	uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	uint32_t pos = tail % HOSTIO_RING_SIZE, len = atomic_load(&r->head) - tail;
+	ssize_t now;
+
+	if (len > HOSTIO_RING_SIZE - pos)
+		len = HOSTIO_RING_SIZE - pos;
+	if (!len || io->outFd < 0)
+		return;
+
+	if (io->isSocket)
+		now = send(io->outFd, r->buf + pos, len, MSG_NOSIGNAL);
+	else
+		now = write(io->outFd, r->buf + pos, len);
+
+	if (now > 0) {
+		atomic_store(&r->tail, tail + now);
+		hostIoPrvSignalSpace(io);
+	}
+	else if (now < 0 && errno != EAGAIN && errno != EINTR)
+		hostIoPrvDisconnect(io, false, true);
+}
+
+static void hostIoPrvAccept(struct HostIo *io)
+{
+	int fd = accept4(io->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+	if (fd < 0)
+		return;
+
+	if (io->inFd >= 0)		//newest client wins
+		hostIoPrvDisconnect(io, true, true);
+
+	io->inFd = fd;
+	io->outFd = fd;
+	hostIoPrvAdd(fd, &io->inEvts, io->idx, HostIoRoleInOut);
+	atomic_store(&io->hasReader, true);
+}
+
+static void* hostIoPrvThread(void *unused)
+{
+	struct epoll_event evts[16];
+	uint_fast8_t i, num;
+	int n, timeout = -1;
+	uint64_t dummy;
+
+	while (!atomic_load(&mStop)) {
+
+		n = epoll_wait(mEpollFd, evts, sizeof(evts) / sizeof(*evts), timeout);
+		num = atomic_load(&mNumEndpoints);
+
+		while (n-- > 0) {
+
+			enum HostIoRole role = (enum HostIoRole)(evts[n].data.u64 & 0xff);
+			uint32_t idx = evts[n].data.u64 >> 8, e = evts[n].events;
+			struct HostIo *io = mEndpoints[idx];
+
+			if (role == HostIoRoleWake) {
+				if (read(mWakeFd, &dummy, sizeof(dummy)) < 0) {
+					//nothing to do, it was just a wakeup
+				}
+				continue;
+			}
+			if (idx >= num)			//not published yet. it will show up again
+				continue;
+
+			switch (role) {
+				case HostIoRoleListen:
+					hostIoPrvAccept(io);
+					break;
+
+				case HostIoRoleIn:
+					if (e & (EPOLLIN | EPOLLHUP | EPOLLERR))
+						hostIoPrvPumpRx(io);
+					break;
+
+				case HostIoRoleOut:
+					if (e & (EPOLLHUP | EPOLLERR))
+						hostIoPrvDisconnect(io, false, true);
+					else if (e & EPOLLOUT)
+						hostIoPrvPumpTx(io);
+					break;
+
+				case HostIoRoleInOut:
+					if (e & EPOLLOUT)
+						hostIoPrvPumpTx(io);
+					if (e & EPOLLIN)
+						hostIoPrvPumpRx(io);
+					else if (e & (EPOLLHUP | EPOLLERR))
+						hostIoPrvDisconnect(io, true, true);
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		timeout = -1;
+		for (i = 0; i < num; i++) {
+
+			struct HostIo *io = mEndpoints[i];
+
+			if (io->inPolled)
+				hostIoPrvPumpRx(io);
+			if (io->outPolled)
+				hostIoPrvPumpTx(io);
+
+			hostIoPrvWatch(io);
+
+			//a full rx ring or an fd epoll cannot watch needs us to come back on our own
+			if ((io->inFd >= 0 && (io->inPolled || hostIoPrvRingUsed(&io->rx) == HOSTIO_RING_SIZE)) || (io->outFd >= 0 && io->outPolled && hostIoPrvRingUsed(&io->tx)))
+				timeout = HOSTIO_RECHECK_MSEC;
+		}
+	}
+
+	return NULL;
+}
+
+static void hostIoPrvWake(void)
+{
+	uint64_t one = 1;
+
+	if (write(mWakeFd, &one, sizeof(one)) < 0) {
+		//counter is saturated, so a wakeup is pending anyways
+	}
+}
+
+static void hostIoPrvStop(void)
+{
+	uint_fast8_t i, num = atomic_load(&mNumEndpoints);
+	uint32_t tries;
+
+	atomic_store(&mStop, true);
+	hostIoPrvWake();
+	pthread_join(mThread, NULL);
+
+	//whatever the guest said last is often the interesting part
+	for (i = 0; i < num; i++) {
+
+		struct HostIo *io = mEndpoints[i];
+
+		for (tries = 0; tries < 64 && io->outFd >= 0 && hostIoPrvRingUsed(&io->tx); tries++)
+			hostIoPrvPumpTx(io);
+
+		if (io->unixPath)
+			unlink(io->unixPath);
+		if (io->savedOutFl >= 0)
+			fcntl(STDOUT_FILENO, F_SETFL, io->savedOutFl);
+	}
+}
+
+static void hostIoPrvStart(void)
+{
+	uint32_t dummy;
+
+	mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+	mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (mEpollFd < 0 || mWakeFd < 0)
+		ERR("cannot set up serial I/O\n");
+
+	hostIoPrvAdd(mWakeFd, &dummy, 0, HostIoRoleWake);
+	hostIoPrvCtl(EPOLL_CTL_MOD, mWakeFd, &dummy, EPOLLIN, 0, HostIoRoleWake);
+
+	if (pthread_create(&mThread, NULL, hostIoPrvThread, NULL))
+		ERR("cannot start serial I/O thread\n");
+
+	atexit(hostIoPrvStop);
+}
+
+//our thread must never block on stdout. we get our own non-blocking open of it where we can, so the shell and
+//our own stdio see no change, else we flip the flag on the shared one and put it back on exit
+static void hostIoPrvStdoutNonblocking(struct HostIo *io)
+{
+	char path[32];
+	int fd, fl;
+
+	sprintf(path, "/proc/self/fd/%d", STDOUT_FILENO);
+	fd = open(path, O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+	if (fd >= 0) {
+		io->outFd = fd;
+		return;
+	}
+
+	fl = fcntl(STDOUT_FILENO, F_GETFL);
+	if (fl >= 0 && !(fl & O_NONBLOCK) && !fcntl(STDOUT_FILENO, F_SETFL, fl | O_NONBLOCK))
+		io->savedOutFl = fl;
+}
+
+static bool hostIoPrvOpenPty(struct HostIo *io)
+{
+	struct termios tio;
+	const char *name;
+	int fd;
+
+	fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0 || grantpt(fd) || unlockpt(fd) || !(name = ptsname(fd)))
+		return false;
+
+	//we hold the slave side open so the master does not hang up every time a user closes it
+	io->ptySlaveFd = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (io->ptySlaveFd < 0)
+		return false;
+
+	if (!tcgetattr(io->ptySlaveFd, &tio)) {
+		cfmakeraw(&tio);
+		tcsetattr(io->ptySlaveFd, TCSANOW, &tio);
+	}
+
+	io->inFd = fd;
+	io->outFd = fd;
+	fprintf(stderr, "serial port is at %s\n", name);
+
+	return true;
+}
+
+static bool hostIoPrvListen(struct HostIo *io, int domain, const struct sockaddr *sa, socklen_t saLen)
+{
+	int one = 1;
+
+	io->listenFd = socket(domain, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (io->listenFd < 0)
+		return false;
+
+	setsockopt(io->listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	if (bind(io->listenFd, sa, saLen) || listen(io->listenFd, 1)) {
+		close(io->listenFd);
+		return false;
+	}
+
+	io->isSocket = true;
+
+	return true;
+}
+
+static bool hostIoPrvOpenUnix(struct HostIo *io, const char *path)
+{
+	struct sockaddr_un sa = {.sun_family = AF_UNIX, };
+
+	if (strlen(path) >= sizeof(sa.sun_path))
+		return false;
+	strcpy(sa.sun_path, path);
+	unlink(path);
+
+	if (!hostIoPrvListen(io, AF_UNIX, (struct sockaddr*)&sa, sizeof(sa)))
+		return false;
+
+	io->unixPath = strdup(path);
+	fprintf(stderr, "serial port listening at %s\n", path);
+
+	return true;
+}
+
+static bool hostIoPrvOpenTcp(struct HostIo *io, const char *portStr)
+{
+	struct sockaddr_in sa = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK), };
+	char *end;
+	long port = strtol(portStr, &end, 0);
+
+	if (*end || port <= 0 || port > 0xffff)
+		return false;
+	sa.sin_port = htons(port);
+
+	if (!hostIoPrvListen(io, AF_INET, (struct sockaddr*)&sa, sizeof(sa)))
+		return false;
+
+	fprintf(stderr, "serial port listening at 127.0.0.1:%ld\n", port);
+
+	return true;
+}
+
+struct HostIo* hostIoOpen(const char *spec)
+{
+	uint_fast8_t idx = atomic_load(&mNumEndpoints);
+	struct HostIo *io;
+	bool ok;
+
+	if (idx == HOSTIO_MAX_ENDPOINTS)
+		return NULL;
+
+	io = (struct HostIo*)calloc(1, sizeof(*io));
+	if (!io)
+		ERR("cannot alloc serial endpoint\n");
+
+	io->idx = idx;
+	io->inFd = -1;
+	io->outFd = -1;
+	io->listenFd = -1;
+	io->ptySlaveFd = -1;
+	io->savedOutFl = -1;
+	io->spaceFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (io->spaceFd < 0)
+		ERR("cannot set up serial I/O\n");
+
+	if (!strcmp(spec, "stdio")) {
+		io->inFd = STDIN_FILENO;
+		io->outFd = STDOUT_FILENO;
+		ok = true;
+	}
+	else if (!strcmp(spec, "pty"))
+		ok = hostIoPrvOpenPty(io);
+	else if (!strncmp(spec, "unix:", 5))
+		ok = hostIoPrvOpenUnix(io, spec + 5);
+	else if (!strncmp(spec, "tcp:", 4))
+		ok = hostIoPrvOpenTcp(io, spec + 4);
+	else
+		ok = false;
+
+	if (!ok) {
+		close(io->spaceFd);
+		free(io);
+		return NULL;
+	}
+
+	if (mEpollFd < 0)
+		hostIoPrvStart();
+
+	if (io->listenFd >= 0) {
+		uint32_t evts;
+
+		hostIoPrvAdd(io->listenFd, &evts, idx, HostIoRoleListen);
+		hostIoPrvCtl(EPOLL_CTL_MOD, io->listenFd, &evts, EPOLLIN, idx, HostIoRoleListen);
+	}
+	else if (io->inFd == io->outFd)
+		hostIoPrvAdd(io->inFd, &io->inEvts, idx, HostIoRoleInOut);
+	else {
+		struct stat st;
+
+		//regular files cannot block for long and a fresh open of one would not share its offset
+		if (!fstat(io->outFd, &st) && !S_ISREG(st.st_mode))
+			hostIoPrvStdoutNonblocking(io);
+
+		io->inPolled = !hostIoPrvAdd(io->inFd, &io->inEvts, idx, HostIoRoleIn);
+		io->outPolled = !hostIoPrvAdd(io->outFd, &io->outEvts, idx, HostIoRoleOut);
+	}
+
+	atomic_init(&io->hasReader, io->outFd >= 0);
+
+	//publish. our thread picks it up on its next pass
+	mEndpoints[idx] = io;
+	atomic_store(&mNumEndpoints, idx + 1);
+	hostIoPrvWake();
+
+	return io;
+}
+
+void hostIoListEndpoints(FILE *f)
+{
+	fprintf(f, "\tstdio            the terminal uARM runs in (default)\n");
+	fprintf(f, "\tpty              a new pseudo-terminal\n");
+	fprintf(f, "\tunix:PATH        a UNIX socket listening at PATH\n");
+	fprintf(f, "\ttcp:PORT         a TCP listener on 127.0.0.1\n");
+}
+
+int hostIoRead(struct HostIo *io)
+{
+	struct HostIoRing *r = &io->rx;
+	uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	uint8_t chr;
+
+	if (tail == atomic_load_explicit(&r->head, memory_order_acquire))
+		return CHAR_NONE;
+
+	chr = r->buf[tail % HOSTIO_RING_SIZE];
+	atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+
+	//if we just made room in a ring that was full, our thread will get to it on its own soon
+
+	return chr;
+}
+
+void hostIoWrite(struct HostIo *io, uint8_t chr)
+{
+	struct HostIoRing *r = &io->tx;
+	uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	struct pollfd pfd = {.fd = io->spaceFd, .events = POLLIN, };
+	uint64_t dummy;
+
+	//full. like the blocking writes this replaces, we wait for a reader, but with no reader at all we drop
+	while (head - atomic_load_explicit(&r->tail, memory_order_acquire) == HOSTIO_RING_SIZE) {
+		
+		if (!atomic_load(&io->hasReader))
+			return;
+		
+		//announce ourselves before the last look, so a drain that races with us still signals
+		atomic_store(&io->txWaiting, true);
+		if (head - atomic_load(&r->tail) != HOSTIO_RING_SIZE)
+			break;
+		hostIoPrvWake();
+		
+		//sleeps until our thread makes room or the reader goes away. the timeout only covers shutdown
+		if (poll(&pfd, 1, HOSTIO_RECHECK_MSEC) > 0 && read(io->spaceFd, &dummy, sizeof(dummy)) < 0) {
+			//someone else already cleared it
+		}
+	}
+	atomic_store(&io->txWaiting, false);
+
+	r->buf[head % HOSTIO_RING_SIZE] = chr;
+	atomic_store(&r->head, head + 1);
+
+	//only if our thread had drained everything before this char might it be asleep with no interest in this ring
+	if (atomic_load(&r->tail) == head)
+		hostIoPrvWake();
+}
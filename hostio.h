@@ -0,0 +1,32 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _HOSTIO_H_
+#define _HOSTIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+struct HostIo;
+
+
+/*
+	Host ends of emulated serial ports. The emulator side only ever touches in-memory rings, a thread of ours moves
+	the data to and from the host. Endpoints:
+		stdio			stdin & stdout
+		pty				a new pseudo-terminal, its name is printed
+		unix:PATH		a UNIX socket listening at PATH
+		tcp:PORT		a TCP listener on the loopback interface
+	Sockets take one client at a time, a new one replaces the old. Output with no one to read it is dropped once
+	the ring fills
+*/
+
+struct HostIo* hostIoOpen(const char *spec);
+void hostIoListEndpoints(FILE *f);
+
+int hostIoRead(struct HostIo *io);			//CHAR_NONE if nothing is waiting
+void hostIoWrite(struct HostIo *io, uint8_t chr);
+
+
+#endif
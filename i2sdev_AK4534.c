@@ -3,6 +3,7 @@
 #include "i2sdev_AK4534.h"
 #include <string.h>
 #include <stdlib.h>
+#include "audio.h"
 #include "util.h"
 
 
@@ -113,6 +114,11 @@ static uint_fast8_t ak4534prvI2cHandler(void *userData, enum ActionI2C stimulus,
 }
 
 
+static void ak4534prvI2sTx(void *userData, const uint32_t *frames, uint32_t num, uint32_t rate)
+{
+	audioPlayFrames(frames, num, rate);
+}
+
 struct AK4534* ak4534Init(struct SocI2c *i2c, struct SocI2s *i2s, struct SocGpio *gpio)
 {
 	struct AK4534 *ak = (struct AK4534*)malloc(sizeof(*ak));
@@ -134,5 +140,7 @@ struct AK4534* ak4534Init(struct SocI2c *i2c, struct SocI2s *i2s, struct SocGpio
 	if (!socI2cDeviceAdd(i2c, ak4534prvI2cHandler, ak))
 		ERR("cannot add TSC2101 to I2C\n");
 	
+	socI2sClientAdd(i2s, ak4534prvI2sTx, ak);
+	
 	return ak;
 }
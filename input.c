@@ -0,0 +1,383 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "SDL2/SDL.h"
+#include "display.h"
+#include "input.h"
+#include "shmio.h"
+#include "util.h"
+#include "SoC.h"
+
+
+/*
+	Trace file format: the magic, then records of:
+		uleb128		ticks since the previous record of the same stream
+		uint8		type (enum InputEvtType, or TRACE_TYPE_SERIAL)
+		payload:	touch:	sleb128 x, sleb128 y
+					key:	uleb128 key, uint8 down
+					serial:	sleb128 char (may be CHAR_CTL_C)
+
+	Touch and key events are timed in inputPoll() calls, serial data in serial read calls. Both happen at fixed
+	points in emulated time, so replaying them at the same counts reproduces the run exactly
+*/
+
+#define TRACE_MAGIC				"uARMtrc1"
+#define TRACE_TYPE_SERIAL		0x80
+#define HOST_QUEUE_LEN			64		//host events not yet taken by inputPoll()
+
+enum InputStream {
+	InputStreamEvents,
+	InputStreamSerial,
+	InputStreamNum,
+};
+
+struct TraceRec {
+	uint64_t tick;
+	uint8_t type;
+	int32_t a, b;
+};
+
+
+static FILE *mRecord = NULL;
+static struct TraceRec *mPlayRecs = NULL;
+static uint32_t mPlayNumRecs = 0, mPlayPos[InputStreamNum];
+static uint64_t mTicks[InputStreamNum], mLastRecTick[InputStreamNum];
+static bool mMouseDown = false, mReplaying = false;
+static pthread_mutex_t mHostLock = PTHREAD_MUTEX_INITIALIZER;
+static struct InputEvt mHostQueue[HOST_QUEUE_LEN];
+static uint32_t mHostHead = 0, mHostTail = 0;
+
+
+
+static enum InputStream inputPrvTypeToStream(uint8_t type)
+{
+	return type == TRACE_TYPE_SERIAL ? InputStreamSerial : InputStreamEvents;
+}
+
+static void inputPrvPutUleb(uint64_t val)
+{
+	do {
+		fputc((val & 0x7f) | (val >= 0x80 ? 0x80 : 0), mRecord);
+		val >>= 7;
+	} while (val);
+}
+
+static void inputPrvPutSleb(int64_t val)
+{
+	inputPrvPutUleb(((uint64_t)val << 1) ^ (uint64_t)(val >> 63));	//zigzag
+}
+
+static bool inputPrvGetUleb(FILE *f, uint64_t *valP)
+{
+	uint64_t val = 0;
+	unsigned shift = 0;
+	int c;
+
+	do {
+		if ((c = fgetc(f)) == EOF || shift > 63)
+			return false;
+		val |= (uint64_t)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+
+	*valP = val;
+	return true;
+}
+
+static bool inputPrvGetSleb(FILE *f, int32_t *valP)
+{
+	uint64_t val;
+
+	if (!inputPrvGetUleb(f, &val))
+		return false;
+
+	*valP = (int32_t)((val >> 1) ^ -(val & 1));
+	return true;
+}
+
+static void inputPrvRecord(enum InputStream stream, uint8_t type, int32_t a, int32_t b)
+{
+	if (!mRecord)
+		return;
+
+	inputPrvPutUleb(mTicks[stream] - mLastRecTick[stream]);
+	mLastRecTick[stream] = mTicks[stream];
+	fputc(type, mRecord);
+
+	switch (type) {
+		case InputEvtTouch:
+			inputPrvPutSleb(a);
+			inputPrvPutSleb(b);
+			break;
+
+		case InputEvtKey:
+			inputPrvPutUleb((uint32_t)a);
+			fputc(b, mRecord);
+			break;
+
+		case TRACE_TYPE_SERIAL:
+			inputPrvPutSleb(a);
+			break;
+	}
+	fflush(mRecord);
+}
+
+//returns the next record of the given stream due at the current tick, if any
+static const struct TraceRec* inputPrvReplay(enum InputStream stream)
+{
+	const struct TraceRec *rec;
+
+	while (mPlayPos[stream] < mPlayNumRecs && inputPrvTypeToStream(mPlayRecs[mPlayPos[stream]].type) != stream)
+		mPlayPos[stream]++;
+
+	if (mPlayPos[stream] == mPlayNumRecs)
+		return NULL;
+
+	rec = &mPlayRecs[mPlayPos[stream]];
+	if (rec->tick != mTicks[stream])
+		return NULL;
+
+	mPlayPos[stream]++;
+	return rec;
+}
+
+static void inputPrvRecordClose(void)
+{
+	fclose(mRecord);
+	mRecord = NULL;
+}
+
+bool inputTraceRecord(const char *path)
+{
+	mRecord = fopen(path, "wb");
+	if (!mRecord)
+		return false;
+
+	fwrite(TRACE_MAGIC, 1, strlen(TRACE_MAGIC), mRecord);
+	atexit(inputPrvRecordClose);
+
+	return true;
+}
+
+bool inputTracePlay(const char *path)
+{
+	uint64_t delta, key, lastTick[InputStreamNum] = {};
+	char magic[sizeof(TRACE_MAGIC) - 1];
+	uint32_t numAlloced = 0;
+	struct TraceRec rec;
+	bool ok = true;
+	int c, down;
+	FILE *f;
+
+	f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	if (fread(magic, 1, sizeof(magic), f) != sizeof(magic) || memcmp(magic, TRACE_MAGIC, sizeof(magic))) {
+
+		fprintf(stderr, "'%s' is not an input trace\n", path);
+		fclose(f);
+		return false;
+	}
+
+	while (ok && inputPrvGetUleb(f, &delta) && (c = fgetc(f)) != EOF) {
+
+		rec.type = c;
+		rec.a = 0;
+		rec.b = 0;
+
+		switch (rec.type) {
+			case InputEvtTouch:
+				ok = inputPrvGetSleb(f, &rec.a) && inputPrvGetSleb(f, &rec.b);
+				break;
+
+			case InputEvtKey:
+				ok = inputPrvGetUleb(f, &key) && (down = fgetc(f)) != EOF;
+				rec.a = key;
+				rec.b = down;
+				break;
+
+			case TRACE_TYPE_SERIAL:
+				ok = inputPrvGetSleb(f, &rec.a);
+				break;
+
+			default:
+				ok = false;
+				break;
+		}
+		if (!ok)
+			break;
+
+		lastTick[inputPrvTypeToStream(rec.type)] += delta;
+		rec.tick = lastTick[inputPrvTypeToStream(rec.type)];
+
+		if (mPlayNumRecs == numAlloced) {
+
+			numAlloced = numAlloced ? numAlloced * 2 : 256;
+			mPlayRecs = (struct TraceRec*)realloc(mPlayRecs, sizeof(struct TraceRec) * numAlloced);
+			if (!mPlayRecs)
+				ERR("cannot alloc input trace\n");
+		}
+		mPlayRecs[mPlayNumRecs++] = rec;
+	}
+	fclose(f);
+	mReplaying = true;
+
+	if (!ok)
+		fprintf(stderr, "input trace '%s' is truncated, replaying the first %u events\n", path, mPlayNumRecs);
+
+	return true;
+}
+
+bool inputIsReplaying(void)
+{
+	return mReplaying;
+}
+
+static bool inputPrvTranslate(const SDL_Event *event, struct InputEvt *evt)
+{
+	switch (event->type) {
+
+		case SDL_QUIT:
+			evt->type = InputEvtQuit;
+			return true;
+
+		case SDL_MOUSEBUTTONDOWN:
+			if (event->button.button != SDL_BUTTON_LEFT)
+				break;
+			mMouseDown = true;
+			evt->type = InputEvtTouch;
+			evt->x = event->button.x;
+			evt->y = event->button.y;
+			return true;
+
+		case SDL_MOUSEBUTTONUP:
+			if (event->button.button != SDL_BUTTON_LEFT)
+				break;
+			mMouseDown = false;
+			evt->type = InputEvtTouch;
+			evt->x = -1;
+			evt->y = -1;
+			return true;
+
+		case SDL_MOUSEMOTION:
+			if (!mMouseDown)
+				break;
+			evt->type = InputEvtTouch;
+			evt->x = event->motion.x;
+			evt->y = event->motion.y;
+			return true;
+
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+			evt->type = InputEvtKey;
+			evt->key = event->key.keysym.sym;
+			evt->down = event->type == SDL_KEYDOWN;
+			return true;
+	}
+
+	return false;
+}
+
+void inputPumpHost(uint32_t waitMsec)
+{
+	struct InputEvt evt;
+	SDL_Event event;
+	bool have;
+
+	for (have = waitMsec ? SDL_WaitEventTimeout(&event, waitMsec) : SDL_PollEvent(&event); have; have = SDL_PollEvent(&event)) {
+
+		if (!inputPrvTranslate(&event, &evt))
+			continue;
+
+		//full only if the emulator stopped polling (say, in the debugger). newer events are dropped
+		pthread_mutex_lock(&mHostLock);
+		if ((mHostTail + 1) % HOST_QUEUE_LEN != mHostHead) {
+			mHostQueue[mHostTail] = evt;
+			mHostTail = (mHostTail + 1) % HOST_QUEUE_LEN;
+		}
+		pthread_mutex_unlock(&mHostLock);
+	}
+}
+
+static bool inputPrvPollHost(struct InputEvt *evt)
+{
+	bool ret;
+
+	//with a window, the main thread reads host events and queues them for us
+	if (!displayNeedsMainThread())
+		inputPumpHost(0);
+
+	if (shmioInputPoll(evt))
+		return true;
+
+	pthread_mutex_lock(&mHostLock);
+	ret = mHostHead != mHostTail;
+	if (ret) {
+		*evt = mHostQueue[mHostHead];
+		mHostHead = (mHostHead + 1) % HOST_QUEUE_LEN;
+	}
+	pthread_mutex_unlock(&mHostLock);
+
+	return ret;
+}
+
+bool inputPoll(struct InputEvt *evt)
+{
+	const struct TraceRec *rec;
+	bool ret;
+
+	if (mReplaying) {
+
+		//while replaying, the host only gets to quit
+		if (inputPrvPollHost(evt) && evt->type == InputEvtQuit)
+			ret = true;
+		else if ((rec = inputPrvReplay(InputStreamEvents)) != NULL) {
+
+			evt->type = (enum InputEvtType)rec->type;
+			evt->x = rec->a;
+			evt->y = rec->b;
+			evt->key = rec->a;
+			evt->down = !!rec->b;
+			ret = true;
+		}
+		else
+			ret = false;
+	}
+	else {
+
+		ret = inputPrvPollHost(evt);
+		if (ret && evt->type == InputEvtTouch)
+			inputPrvRecord(InputStreamEvents, InputEvtTouch, evt->x, evt->y);
+		else if (ret && evt->type == InputEvtKey)
+			inputPrvRecord(InputStreamEvents, InputEvtKey, evt->key, evt->down);
+	}
+
+	mTicks[InputStreamEvents]++;
+
+	return ret;
+}
+
+bool inputTraceSerialReplay(int *chrP)
+{
+	const struct TraceRec *rec;
+
+	if (!mReplaying)
+		return false;
+
+	rec = inputPrvReplay(InputStreamSerial);
+	*chrP = rec ? rec->a : CHAR_NONE;
+	mTicks[InputStreamSerial]++;
+
+	return true;
+}
+
+void inputTraceSerialRecord(int chr)
+{
+	if (chr != CHAR_NONE)
+		inputPrvRecord(InputStreamSerial, TRACE_TYPE_SERIAL, chr, 0);
+	mTicks[InputStreamSerial]++;
+}
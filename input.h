@@ -0,0 +1,41 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _INPUT_H_
+#define _INPUT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+enum InputEvtType {
+	InputEvtQuit,
+	InputEvtTouch,		//x, y (both negative for pen up)
+	InputEvtKey,		//key (SDL keycode), down
+};
+
+struct InputEvt {
+	enum InputEvtType type;
+	int32_t x, y;
+	uint32_t key;
+	bool down;
+};
+
+
+//record all external inputs to a trace file, or replay them from one instead of using the host's
+bool inputTraceRecord(const char *path);
+bool inputTracePlay(const char *path);
+bool inputIsReplaying(void);
+
+//reads host (SDL) events for inputPoll(). with a window (see displayNeedsMainThread()) the main thread calls it in its
+//loop, waiting up to waitMsec for one. otherwise inputPoll() calls it itself
+void inputPumpHost(uint32_t waitMsec);
+
+//SoCs call this at fixed cycle intervals. returns at most one event. the call count is the timebase for touch & key events
+bool inputPoll(struct InputEvt *evt);
+
+//frontend's serial read hooks. the call count is the timebase for serial data
+bool inputTraceSerialReplay(int *chrP);	//true if replaying (and *chrP is set)
+void inputTraceSerialRecord(int chr);
+
+
+#endif
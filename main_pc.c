@@ -3,6 +3,7 @@
 #include "SoC.h"
 
 #include <sys/time.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -11,80 +12,188 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/select.h>
+#include <sys/mman.h>
 #include <signal.h>
 #include <termios.h>
 #include <getopt.h>
 #include "device.h"
+#include "bench.h"
+#include "farm.h"
+#include "input.h"
+#include "speed.h"
+#include "display.h"
+#include "audio.h"
+#include "hostio.h"
+#include "sdstore.h"
+#include "soc_UART.h"
+#include "ROM.h"
 
-#define SD_SECTOR_SIZE		(512ULL)
+#define MAX_UART_MAPS		8
+#define MAIN_IDLE_MSEC		4		//how long the main thread waits for a host event when there was no frame to show
 
-static FILE* mSdCard = NULL;
+struct UartMap {
+	const char *uartName;
+	struct HostIo *io;
+	bool bulk, used;
+};
+
+static struct SdStore* mSdStore = NULL;
+static struct HostIo* mSerial = NULL;
+static struct UartMap mUartMaps[MAX_UART_MAPS];
+static uint_fast8_t mNumUartMaps = 0;
+static char mUartNames[64] = "";
 
 
 
 int socExtSerialReadChar(void)
 {
-	struct timeval tv;
-	fd_set set;
-	char c;
-	int i, ret = CHAR_NONE;
-	
-	tv.tv_sec = 0;
-	tv.tv_usec = 0;
+	int ret;
 	
-	FD_ZERO(&set);
-	FD_SET(0, &set);
+	if (inputTraceSerialReplay(&ret))
+		return ret;
 	
-	i = select(1, &set, NULL, NULL, &tv);
-	if(i == 1 && 1 == read(0, &c, 1)){
-		
-		ret = c;
-	}
+	ret = hostIoRead(mSerial);
+	inputTraceSerialRecord(ret);
 
 	return ret;
 }
 
 void socExtSerialWriteChar(int chr)
 {
+	char str[32];
+	int i, len;
+	
 	if (!(chr & 0xFF00))
-		printf("%c", chr);
-	else
-		printf("<<~~ EC_0x%x ~~>>", chr);
+		hostIoWrite(mSerial, chr);
+	else {
+		len = snprintf(str, sizeof(str), "<<~~ EC_0x%x ~~>>", chr);
+		for (i = 0; i < len; i++)
+			hostIoWrite(mSerial, str[i]);
+	}
+}
+
+static uint_fast16_t prvUartHostRead(void *userData)
+{
+	int chr = hostIoRead((struct HostIo*)userData);
+	
+	return chr == CHAR_NONE ? UART_CHAR_NONE : (uint_fast16_t)chr;
+}
+
+static void prvUartHostWrite(uint_fast16_t chr, void *userData)
+{
+	if (chr < 0x100)	//breaks and errors have no place in a byte stream
+		hostIoWrite((struct HostIo*)userData, chr);
+}
+
+void socExtSerialAttach(struct SocUart *uart, const char *name)
+{
+	uint_fast8_t i;
+	
+	if (strlen(mUartNames) + strlen(name) + 2 < sizeof(mUartNames))
+		sprintf(mUartNames + strlen(mUartNames), "%s%s", mUartNames[0] ? " " : "", name);
+	
+	for (i = 0; i < mNumUartMaps; i++) {
+		
+		if (strcmp(mUartMaps[i].uartName, name))
+			continue;
+		
+		socUartSetFuncs(uart, prvUartHostRead, prvUartHostWrite, mUartMaps[i].io);
+		socUartSetBulk(uart, mUartMaps[i].bulk);
+		mUartMaps[i].used = true;
+	}
+}
 
-	fflush(stdout);	
+//UART=ENDPOINT[,bulk]
+static bool prvUartMapAdd(char *spec)
+{
+	char *endpoint = strchr(spec, '='), *opt;
+	struct UartMap *map;
+	
+	if (!endpoint || mNumUartMaps == MAX_UART_MAPS)
+		return false;
+	
+	map = &mUartMaps[mNumUartMaps];
+	*endpoint++ = 0;
+	opt = strrchr(endpoint, ',');
+	if (opt && !strcmp(opt, ",bulk")) {
+		*opt = 0;
+		map->bulk = true;
+	}
+	
+	map->uartName = spec;
+	map->io = hostIoOpen(endpoint);
+	if (!map->io) {
+		
+		fprintf(stderr, "Cannot open serial port endpoint '%s'\n", endpoint);
+		return false;
+	}
+	mNumUartMaps++;
+	
+	return true;
 }
 
 static void usage(const char *self)
 {
-	fprintf(stderr, "USAGE: %s {-r ROMFILE.bin | --x} [-g gdbPort] [-s SDCARD_IMG.bin] [-n NAND.bin]\n",
+	fprintf(stderr, "USAGE: %s {-r ROMFILE.bin | --x | -b WORKLOAD[,MINSTRS] | --farm JOBFILE[,WORKERS[,SECS]]} [-d DEVICE] [-g gdbPort] [--rom-overlay FILE] [-s SDCARD_IMG.bin [--sd-cache MB] [--sd-overlay DELTA.bin [--sd-commit]]] [-n NAND.bin] [-R TRACE.bin | -P TRACE.bin] [-t] [-u SERIAL] [-U UART=SERIAL[,bulk]]... [-o OUTPUT[:ARGS]]... [--record-video FILE [--dedup-video]] [-a AUDIO[:ARGS]]\n",
 					self);
+	fprintf(stderr, "Devices supported by this build:\n");
+	deviceListSupported(stderr);
+	fprintf(stderr, "Benchmark workloads (or \"all\"):\n");
+	benchListWorkloads(stderr);
+	fprintf(stderr, "Serial port endpoints:\n");
+	hostIoListEndpoints(stderr);
+	fprintf(stderr, "Display outputs (default \"sdl\"):\n");
+	displayListSinks(stderr);
+	fprintf(stderr, "Audio outputs (default \"sdl\"):\n");
+	audioListSinks(stderr);
 	exit(-1);
 }
 
-static bool prvSdSectorR(uint32_t secNum, void *buf)
+static bool prvSdSectorR(uint32_t secNum, void *buf, uint32_t numSecs)
 {
-	return fseeko(mSdCard, SD_SECTOR_SIZE * secNum, SEEK_SET) == 0 && fread(buf, 1, SD_SECTOR_SIZE, mSdCard) == SD_SECTOR_SIZE;
+	return sdStoreRead(mSdStore, secNum, buf, numSecs);
 }
 
-static bool prvSdSectorW(uint32_t secNum, const void *buf)
+static bool prvSdSectorW(uint32_t secNum, const void *buf, uint32_t numSecs)
 {
-	return fseeko(mSdCard, SD_SECTOR_SIZE * secNum, SEEK_SET) == 0 && fwrite(buf, 1, SD_SECTOR_SIZE, mSdCard) == SD_SECTOR_SIZE;
+	return sdStoreWrite(mSdStore, secNum, buf, numSecs);
+}
+
+static void* prvEmuThread(void *soc)
+{
+	socRun((struct SoC*)soc);
+	
+	return NULL;
 }
 
 int main(int argc, char** argv)
 {
 	uint32_t romLen = 0, sdSecs = 0;
-	const char *self = argv[0];
-	bool noRomMode = false;
+	static const struct option longOpts[] = {
+		{"record-video", required_argument, NULL, 'V'},
+		{"dedup-video", no_argument, NULL, 'D'},
+		{"sd-cache", required_argument, NULL, 'C'},
+		{"sd-overlay", required_argument, NULL, 'O'},
+		{"sd-commit", no_argument, NULL, 'M'},
+		{"rom-overlay", required_argument, NULL, 'L'},
+		{"farm", required_argument, NULL, 'F'},
+		{},
+	};
+	const char *self = argv[0], *devName = NULL, *benchName = NULL, *recordName = NULL, *replayName = NULL, *videoName = NULL, *serialName = "stdio", *sdName = NULL, *sdDeltaName = NULL, *nandName = NULL, *romOverlayName = NULL, *farmName = NULL;
+	bool videoDedup = false, haveOutputs = false, sdCommit = false;
+	uint64_t benchInstrs = BENCH_DEFAULT_INSTRS, sdCache = SDSTORE_DEFAULT_CACHE;
+	uint32_t farmWorkers = 0, farmSecs = 0;
+	bool noRomMode = false, turbo = false;
 	FILE* nandFile = NULL;
 	FILE* romFile = NULL;
 	uint8_t *rom = NULL;
 	int gdbPort = -1;
 	uint64_t sdSize;
 	struct SoC *soc;
+	pthread_t emuThread;
 	int c;
 	
-	while ((c = getopt(argc, argv, "g:s:r:n:hx")) != -1) switch (c) {
+	while ((c = getopt_long(argc, argv, "g:s:r:n:d:b:R:P:o:a:u:U:htx", longOpts, NULL)) != -1) switch (c) {
 		
 		case 'g':	//gdb port
 			gdbPort = optarg ? atoi(optarg) : -1;
@@ -93,24 +202,21 @@ int main(int argc, char** argv)
 			break;
 		
 		case 's':	//sd card
-			if (optarg)
-				mSdCard = fopen(optarg, "r+b");
-			if (!mSdCard)
+			sdName = optarg;
+			break;
+		
+		case 'C':	//sd card cache size
+			sdCache = strtoull(optarg, NULL, 0) << 20;
+			if (!sdCache || (sdCache >> 32))
 				usage(self);
-			
-			fseeko(mSdCard, 0, SEEK_END);
-			sdSize = ftello(mSdCard);
-			if (sdSize % SD_SECTOR_SIZE) {
-				fprintf(stderr, "SD card image not a multiple of %u bytes\n", (unsigned)SD_SECTOR_SIZE);
-				exit(-4);
-			}
-			sdSize /= SD_SECTOR_SIZE;
-			if (sdSize >> 32) {
-				fprintf(stderr, "SD card too big: %llu sectors\n", (unsigned long long)sdSize);
-				exit(-5);
-			}
-			sdSecs = sdSize;
-			fprintf(stderr, "opened %lu-sector sd card image\n", (long)sdSecs);
+			break;
+		
+		case 'O':	//sd card writes go to a delta instead
+			sdDeltaName = optarg;
+			break;
+		
+		case 'M':	//fold the delta into the image and exit
+			sdCommit = true;
 			break;
 		
 		case 'r':	//ROM
@@ -118,13 +224,82 @@ int main(int argc, char** argv)
 				romFile = fopen(optarg, "rb");
 			break;
 		
+		case 'L':	//flash ROM changes go here
+			romOverlayName = optarg;
+			break;
+		
 		case 'x':	//NO_ROM mode
 			noRomMode = true;
 			break;
 		
 		case 'n':	//NAND
-			if (optarg)
-				nandFile = fopen(optarg, "r+b");
+			nandName = optarg;
+			break;
+		
+		case 'd':	//device
+			devName = optarg;
+			break;
+		
+		case 'b':	//benchmark
+			benchName = strtok(optarg, ",");
+			if ((optarg = strtok(NULL, ",")) != NULL)
+				benchInstrs = strtoull(optarg, NULL, 0) * 1000000ULL;
+			if (!benchName || !benchInstrs)
+				usage(self);
+			break;
+		
+		case 'F':	//run a list of jobs, each in a process of its own
+			farmName = strtok(optarg, ",");
+			if ((optarg = strtok(NULL, ",")) != NULL)
+				farmWorkers = atoi(optarg);
+			if (optarg && (optarg = strtok(NULL, ",")) != NULL)
+				farmSecs = atoi(optarg);
+			if (!farmName)
+				usage(self);
+			break;
+		
+		case 'R':	//record input trace
+			recordName = optarg;
+			break;
+		
+		case 'P':	//replay input trace
+			replayName = optarg;
+			break;
+		
+		case 't':	//turbo: do not throttle to real time
+			turbo = true;
+			break;
+		
+		case 'o':	//display output
+			haveOutputs = true;
+			if (!displayAddSink(optarg)) {
+				fprintf(stderr, "Unknown display output '%s'\n", optarg);
+				usage(self);
+			}
+			break;
+		
+		case 'a':	//audio output
+			if (!audioSetSink(optarg)) {
+				fprintf(stderr, "Unknown audio output '%s'\n", optarg);
+				usage(self);
+			}
+			break;
+		
+		case 'u':	//serial port endpoint
+			serialName = optarg;
+			break;
+		
+		case 'U':	//map a UART to the host
+			if (!prvUartMapAdd(optarg))
+				usage(self);
+			break;
+		
+		case 'V':	//record video
+			videoName = optarg;
+			break;
+		
+		case 'D':	//drop repeated frames from the video
+			videoDedup = true;
 			break;
 		
 		default:
@@ -132,33 +307,157 @@ int main(int argc, char** argv)
 			break;
 	}
 	
-	if ((romFile && noRomMode) || (!romFile && !noRomMode))
+	if (farmName)
+		exit(farmRun(self, farmName, farmWorkers, farmSecs) ? 0 : -9);
+	
+	if (sdCommit) {
+		
+		if (!sdName || !sdDeltaName)
+			usage(self);
+		exit(sdStoreCommit(sdName, sdDeltaName) ? 0 : -6);
+	}
+	
+	if (sdDeltaName && !sdName)
+		usage(self);
+	
+	if (!benchName && ((romFile && noRomMode) || (!romFile && !noRomMode)))
+		usage(self);
+	
+	if (recordName && replayName)
+		usage(self);
+	
+	//changes are saved unless the image is read-only or we are benchmarking, where every run must start from the same state
+	if (nandName) {
+		
+		nandFile = benchName ? NULL : fopen(nandName, "r+b");
+		if (!nandFile)
+			nandFile = fopen(nandName, "rb");
+		if (!nandFile) {
+			perror("cannot open NAND image");
+			exit(-7);
+		}
+	}
+	
+	if (sdName) {
+		
+		mSdStore = sdStoreOpen(sdName, sdDeltaName, sdCache);
+		if (!mSdStore)
+			usage(self);
+		
+		sdSize = sdStoreGetSize(mSdStore);
+		if (sdSize % SDSTORE_SECTOR_SIZE) {
+			fprintf(stderr, "SD card image not a multiple of %u bytes\n", (unsigned)SDSTORE_SECTOR_SIZE);
+			exit(-4);
+		}
+		sdSize /= SDSTORE_SECTOR_SIZE;
+		if (sdSize >> 32) {
+			fprintf(stderr, "SD card too big: %llu sectors\n", (unsigned long long)sdSize);
+			exit(-5);
+		}
+		sdSecs = sdSize;
+		fprintf(stderr, "opened %lu-sector sd card image with a %lu MB cache%s%s\n", (long)sdSecs, (long)(sdCache >> 20),
+			sdDeltaName ? ", writes go to " : "", sdDeltaName ? sdDeltaName : "");
+	}
+	
+	if (videoName) {
+		
+		char *spec = (char*)malloc(strlen(videoName) + 16);
+		
+		//recording is in addition to whatever output we would otherwise have
+		if (!haveOutputs)
+			displayAddSink("sdl");
+		
+		sprintf(spec, "video:%s%s", videoDedup ? "dedup:" : "", videoName);
+		if (!displayAddSink(spec))
+			usage(self);
+	}
+	else if (videoDedup)
+		usage(self);
+	
+	displaySinksConfigured();
+	
+	mSerial = hostIoOpen(serialName);
+	if (!mSerial) {
+		
+		fprintf(stderr, "Cannot open serial port endpoint '%s'\n", serialName);
+		usage(self);
+	}
+	
+	if (recordName && !inputTraceRecord(recordName)) {
+		
+		fprintf(stderr, "Cannot create input trace '%s'\n", recordName);
+		exit(-6);
+	}
+	
+	if (replayName && !inputTracePlay(replayName)) {
+		
+		fprintf(stderr, "Cannot read input trace '%s'\n", replayName);
+		exit(-6);
+	}
+	
+	if (!deviceSelect(devName)) {
+		
+		fprintf(stderr, devName ? "Unknown device '%s'\n" : "Device must be specified\n", devName);
 		usage(self);
+	}
+	
+	if (benchName) {
+		
+		if (!benchRun(benchName, benchInstrs, nandFile))
+			usage(self);
+		
+		return 0;
+	}
 	
+	//a private mapping: shared with every other instance using this image until the guest writes to flash
 	if (romFile) {
 		fseek(romFile, 0, SEEK_END);
 		romLen = ftell(romFile);
-		rewind(romFile);
-	
-		rom = (uint8_t*)malloc(romLen);
-		if (!rom) {
-			
-			fprintf(stderr, "CANNOT ALLOC ROM\n");
-			exit(-2);
-		}
 		
-		if (romLen != fread(rom, 1, romLen, romFile)) {
+		rom = (uint8_t*)mmap(NULL, romLen, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(romFile), 0);
+		if (rom == MAP_FAILED) {
 			
-			fprintf(stderr, "CANNOT READ ROM\n");
+			fprintf(stderr, "CANNOT MAP ROM\n");
 			exit(-2);
 		}
 		fclose(romFile);
 	}
 	
-	fprintf(stderr, "Read %u bytes of ROM\n", romLen);
+	fprintf(stderr, "Mapped %u bytes of ROM\n", romLen);
+	
+	if (romOverlayName)
+		romSetOverlay(romOverlayName);
+	
+	speedSetRealTime(!turbo && !replayName);		//a replay does not depend on host time, so it runs flat out
 	
 	soc = socInit((void**)&rom, &romLen, romLen ? 1 : 0, sdSecs, prvSdSectorR, prvSdSectorW, nandFile, gdbPort, deviceGetSocRev());
-	socRun(soc);
+	
+	for (c = 0; c < mNumUartMaps; c++) {
+		
+		if (mUartMaps[c].used)
+			continue;
+		
+		fprintf(stderr, "No UART named '%s' here. There are: %s\n", mUartMaps[c].uartName, mUartNames);
+		exit(-7);
+	}
+	
+	audioStart();
+	
+	if (!displayNeedsMainThread()) {
+		
+		socRun(soc);
+		return 0;
+	}
+	
+	//SDL wants its window and events on the thread that initialized it, so the emulator gets a thread of its own
+	if (pthread_create(&emuThread, NULL, prvEmuThread, soc)) {
+		
+		fprintf(stderr, "Cannot start the emulator thread\n");
+		exit(-8);
+	}
+	
+	while (1)
+		inputPumpHost(displayPoll() ? 0 : MAIN_IDLE_MSEC);
 	
 	return 0;
 }
@@ -1,13 +1,22 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
-#include "nand.h"
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include "nand.h"
 #include "util.h"
 #include "mem.h"
 #include "CPU.h"
 
 
+#define NAND_WRITEBACK_SEC		1		//changed blocks reach the image within this long
 
 
 enum K9nandState {
@@ -55,8 +64,20 @@ struct NAND {
 	
 	//data
 	uint8_t *data;		//stores inverted data (so 0-init is valid)
+	uint32_t dataSz;
+	atomic_uint_fast64_t *dirty;	//per block, only if data is a shared mapping of the image
+	uint32_t blocksWritten;
 };
 
+
+//one NAND image may be kept up to date by a background thread
+static struct NAND *mWbNand = NULL;
+static pthread_mutex_t mWbLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mWbCond = PTHREAD_COND_INITIALIZER;
+static pthread_t mWbThread;
+static bool mWbStop = false;
+
+
 void nandSecondReadyCbkSet(struct NAND* nand, NandReadyCbk readyCbk, void *readyCbkData)
 {
 	nand->readyCbk[1] = readyCbk;
@@ -106,6 +127,114 @@ static uint32_t nandPrvGetByteAddr(struct NAND* nand)
 	return nandPrvGetAddrValLE(nand, 0, nand->byteAddrBytes);
 }
 
+static void nandPrvMarkDirty(struct NAND *nand, uint32_t page)
+{
+	uint32_t block = page >> nand->pagesPerBlockLg2;
+	
+	if (nand->dirty)
+		atomic_fetch_or_explicit(&nand->dirty[block / 64], 1ULL << (block % 64), memory_order_relaxed);
+}
+
+//msync each run of changed blocks. the emulator keeps writing meanwhile, anything it marks after we look waits for the next pass
+static void nandPrvWriteBack(struct NAND *nand)
+{
+	uintptr_t blockBytes = nand->bytesPerPage << nand->pagesPerBlockLg2, pageMask = sysconf(_SC_PAGESIZE) - 1, start, end;
+	uint32_t i, first, num;
+	uint64_t bits;
+	
+	for (i = 0; i < (nand->blocksPerDevice + 63) / 64; i++) {
+		
+		bits = atomic_exchange(&nand->dirty[i], 0);
+		while (bits) {
+			
+			first = __builtin_ctzll(bits);
+			num = ~(bits >> first) ? __builtin_ctzll(~(bits >> first)) : 64;
+			bits &= (first + num == 64) ? ((1ULL << first) - 1) : ~(((1ULL << num) - 1) << first);
+			
+			start = (uintptr_t)nand->data + (i * 64 + first) * blockBytes;
+			end = start + num * blockBytes;
+			start &= ~pageMask;
+			end = (end + pageMask) & ~pageMask;
+			if (msync((void*)start, end - start, MS_SYNC))
+				perror("NAND write-back failed");
+			nand->blocksWritten += num;
+		}
+	}
+}
+
+static void* nandPrvWriteBackThread(void *param)
+{
+	struct NAND *nand = (struct NAND*)param;
+	struct timespec ts;
+	
+	pthread_mutex_lock(&mWbLock);
+	while (!mWbStop) {
+		
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += NAND_WRITEBACK_SEC;
+		if (pthread_cond_timedwait(&mWbCond, &mWbLock, &ts) != ETIMEDOUT)
+			continue;
+		
+		pthread_mutex_unlock(&mWbLock);
+		nandPrvWriteBack(nand);
+		pthread_mutex_lock(&mWbLock);
+	}
+	pthread_mutex_unlock(&mWbLock);
+	
+	return NULL;
+}
+
+static void nandPrvWriteBackStop(void)
+{
+	pthread_mutex_lock(&mWbLock);
+	mWbStop = true;
+	pthread_cond_signal(&mWbCond);
+	pthread_mutex_unlock(&mWbLock);
+	pthread_join(mWbThread, NULL);
+	
+	nandPrvWriteBack(mWbNand);
+	if (mWbNand->blocksWritten)
+		fprintf(stderr, "NAND: %lu blocks written back\n", (unsigned long)mWbNand->blocksWritten);
+}
+
+//the image is mapped, not read, so startup does no I/O. opened for writing, the mapping is shared and changed
+//blocks go back to the file as they change. read-only, it is private and changes are lost at exit
+static bool nandPrvMapImage(struct NAND *nand, FILE *nandFile)
+{
+	int fd = fileno(nandFile);
+	bool persist = (fcntl(fd, F_GETFL) & O_ACCMODE) == O_RDWR && !mWbNand;
+	struct stat st;
+	void *data;
+	
+	if (fstat(fd, &st) || (uint64_t)st.st_size < nand->dataSz) {
+		fprintf(stderr, "Cannot read nand. got %lu, wanted %lu\n", (unsigned long)st.st_size, (unsigned long)nand->dataSz);
+		return false;
+	}
+	
+	data = mmap(NULL, nand->dataSz, PROT_READ | PROT_WRITE, persist ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		perror("Cannot map nand");
+		return false;
+	}
+	nand->data = (uint8_t*)data;
+	
+	if (persist) {
+		
+		nand->dirty = (atomic_uint_fast64_t*)calloc((nand->blocksPerDevice + 63) / 64, sizeof(atomic_uint_fast64_t));
+		if (!nand->dirty)
+			ERR("cannot alloc NAND dirty map\n");
+		
+		mWbNand = nand;
+		if (pthread_create(&mWbThread, NULL, nandPrvWriteBackThread, nand))
+			ERR("cannot start NAND write-back thread\n");
+		atexit(nandPrvWriteBackStop);
+	}
+	
+	fprintf(stderr, "mapped %u bytes of nand%s\n", (unsigned)nand->dataSz, persist ? ", changes are saved" : "");
+	
+	return true;
+}
+
 static bool nandPrvBlockErase(struct NAND* nand)
 {
 	uint32_t addr = nandPrvGetPageAddr(nand, 0);
@@ -115,6 +244,7 @@ static bool nandPrvBlockErase(struct NAND* nand)
 	
 	//fprintf(stderr, " NAND ERASE BLOCK %u\n", addr / NAND_PAGES_PER_BLOCK);
 	memset(nand->data + addr * nand->bytesPerPage, 0xff, nand->bytesPerPage << nand->pagesPerBlockLg2);
+	nandPrvMarkDirty(nand, addr);
 	
 	return true;
 }
@@ -130,6 +260,7 @@ static bool nandPrvPageProgram(struct NAND* nand)
 	//	if (nand->data[nand->pageNo * NAND_PAGE_SIZE + i] != nand->pageBuf[i])
 	//		fprintf(stderr, "write fail for page %u af ofst %u. wrote 0x%02x, read 0x%02x\n", nand->pageNo, i, nand->pageBuf[i], nand->data[nand->pageNo * NAND_PAGE_SIZE + i]);
 	}
+	nandPrvMarkDirty(nand, nand->pageNo);
 	
 	return true;
 }
@@ -443,22 +574,19 @@ struct NAND* nandInit(FILE *nandFile, const struct NandSpecs *specs, NandReadyCb
 	if (!nand->pageBuf)
 		ERR("canont allcoate NAND page buffer\n");
 	
-	nand->data = (uint8_t*)malloc(nandSz);
-	if (!nand->data)
-		ERR("canont allcoate NAND data buffer\n");
-	
+	nand->dataSz = nandSz;
 	if (nandFile) {
-		t = fread(nand->data, 1, nandSz, nandFile);
-		if (nandSz != t) {
-			fprintf(stderr, "Cannot read nand. got %lu, wanted %lu\n", (unsigned long)t, (unsigned long)nandSz);
+		if (!nandPrvMapImage(nand, nandFile)) {
 			free(nand);
 			return NULL;
 		}
-		else
-			fprintf(stderr, "read %u bytes of nand\n", (unsigned)nandSz);
 	}
-	else if (!nandFile)
+	else {
+		nand->data = (uint8_t*)malloc(nandSz);
+		if (!nand->data)
+			ERR("canont allcoate NAND data buffer\n");
 		memset(nand->data, 0xff, nandSz);
+	}
 	
 	nandPrvBusy(nand, 1);		//we start busy for a little bit
 	
@@ -113,8 +113,8 @@ void omap32kTmrPeriodic(struct Omap32kTmr *tmr)
 				tmr->cr &=~ 1;
 			if (tmr->cr & 4) {
 				//edge
-				socIcInt(tmr->ic, OMAP_I_TIMER32K, true);
-				socIcInt(tmr->ic, OMAP_I_TIMER32K, false);
+				omapIcInt(tmr->ic, OMAP_I_TIMER32K, true);
+				omapIcInt(tmr->ic, OMAP_I_TIMER32K, false);
 			}
 		}
 	}
@@ -23,8 +23,8 @@ struct OmapCamera {
 
 static void omapCameraPrvRecalcIrqAndDma(struct OmapCamera *cam)
 {
-	socIcInt(cam->ic, OMAP_I_CAMERA, false);
-	socDmaExternalReq(cam->dma, DMA_REQ_CAMERA_RX, false);
+	omapIcInt(cam->ic, OMAP_I_CAMERA, false);
+	omapDmaExternalReq(cam->dma, DMA_REQ_CAMERA_RX, false);
 }
 
 
@@ -5,6 +5,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <limits.h>
+#include "endian.h"
 #include "util.h"
 #include "mem.h"
 
@@ -17,6 +18,7 @@
 #define OMAP_DMA_CHS_SIZE		0x300
 
 #define NUM_CHANNELS			9
+#define MAX_BULK				8
 
 struct DmaChannelCfg {
 	
@@ -24,6 +26,11 @@ struct DmaChannelCfg {
 	uint16_t cen, cfn, cfi, cei;
 };
 
+struct DmaStride {
+	int32_t elem;			//address step after each element
+	int32_t frame;			//after the last one of a frame
+};
+
 struct DmaChannel {
 	uint16_t csdp, ccr, csr, cpc;
 	uint8_t cicr;
@@ -42,15 +49,29 @@ struct DmaChannel {
 	uint32_t curDstAddr;	//we cannot modify active.{src,dst} since in case of repetitive xfer we need them as is
 	bool waitingForEndProg;
 	
+	//addressing modes, worked out once per configuration
+	struct DmaStride srcStride, dstStride;
+	
 	//to help with efficiency
 	uint8_t irqNo;
 	struct DmaChannel *friendChannel;
 };
 
+struct DmaBulk {
+	SocDmaBulkF f;
+	void *userData;
+	uint8_t reqNum;
+	bool toPeriph;
+};
+
 struct SocDma {
 
 	struct SocIc *ic;
 	struct ArmMem *mem;
+	struct ArmRam *ram;
+	
+	struct DmaBulk bulk[MAX_BULK];
+	uint8_t numBulk;
 	
 	uint32_t pendingReqs;
 	struct DmaChannel ch[NUM_CHANNELS];
@@ -100,6 +121,42 @@ static bool socDmaPrvCtrlMemAccessF(void* userData, uint32_t pa, uint_fast8_t si
 	return true;
 }
 
+static void socDmaPrvStridePlan(struct DmaStride *st, const struct DmaChannelCfg *cfg, uint_fast8_t accessSz, uint_fast8_t mode)
+{
+	switch (mode) {
+		case 0:	//constant addr
+			st->elem = 0;
+			st->frame = 0;
+			break;
+		
+		case 1:	//post-increment
+			st->elem = accessSz;
+			st->frame = accessSz;
+			break;
+		
+		case 2:	//single-indexed
+			st->elem = accessSz - 2 + (int32_t)(int16_t)cfg->cei;
+			st->frame = st->elem;
+			break;
+		
+		case 3:	//double-indexed
+			st->elem = accessSz - 1 + (int32_t)(int16_t)cfg->cei;
+			st->frame = accessSz - 1 + (int32_t)(int16_t)cfg->cfi;
+			break;
+		
+		default:
+			__builtin_unreachable();
+	}
+}
+
+static void socDmaPrvChannelPlan(struct DmaChannel *ch)
+{
+	uint_fast8_t accessSz = 1 << (ch->csdp & 3);
+	
+	socDmaPrvStridePlan(&ch->srcStride, &ch->active, accessSz, (ch->ccr >> 12) & 3);
+	socDmaPrvStridePlan(&ch->dstStride, &ch->active, accessSz, (ch->ccr >> 14) & 3);
+}
+
 static void socDmaPrvChannelInitialize(struct SocDma *dma, struct DmaChannel *ch, bool copyCfg)	//also handles re-initializing
 {
 	if (copyCfg)
@@ -111,6 +168,7 @@ static void socDmaPrvChannelInitialize(struct SocDma *dma, struct DmaChannel *ch
 	
 	ch->curSrcAddr = ch->active.src;
 	ch->curDstAddr = ch->active.dst;
+	socDmaPrvChannelPlan(ch);
 	
 	if (0)
 	if (ch - dma->ch != 7) {
@@ -150,8 +208,10 @@ static bool socDmaPrvChsMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 	switch (pa) {
 		
 		case 0x00 / 2:
-			if (write)
+			if (write) {
 				ch->csdp = val & 0xffff;
+				socDmaPrvChannelPlan(ch);
+			}
 			else
 				val = ch->csdp;
 			break;
@@ -180,6 +240,8 @@ static bool socDmaPrvChsMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 					ch->ccr &=~ 0x0800;
 					socDmaPrvChannelInitialize(dma, ch, true);
 				}
+				
+				socDmaPrvChannelPlan(ch);
 			}
 			else
 				val = ch->ccr;
@@ -283,40 +345,153 @@ static bool socDmaPrvChsMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 	return true;
 }
 
-static uint32_t socDmaPrvAdjustAddress(struct SocDma *dma, struct DmaChannel *ch, uint32_t addr, uint_fast8_t accessSz, uint_fast8_t mode)
+//host pointer to num elements stepping by stride from addr, if they are all in RAM
+static uint8_t* socDmaPrvRamSpan(struct SocDma *dma, uint32_t addr, int32_t stride, uint32_t num, uint_fast8_t accessSz)
 {
-	switch (mode) {
-		 case 0:	//constant addr
-		 	break;
-		 
-		 case 1:	//post-increment
-		 	addr += accessSz;
-		 	break;
-		 
-		 case 2:	//single-indexed
-		 	addr += accessSz - 1 + (int32_t)(int16_t)ch->active.cei - 1;
-		 	break;
-		 
-		 case 3:	//double-indexed
-		 	if (ch->curElemIdx)
-		 		addr += accessSz - 1 + (int32_t)(int16_t)ch->active.cei;
-		 	else
-		 		addr += accessSz - 1 + (int32_t)(int16_t)ch->active.cfi;
-		 	break;
-		 
-		 default:
-		 	__builtin_unreachable();
+	int64_t span = (int64_t)stride * (num - 1);
+	uint32_t lo = span < 0 ? addr + span : addr;
+	uint8_t *ptr;
+	
+	ptr = (uint8_t*)ramGetPtr(dma->ram, lo, (span < 0 ? -span : span) + accessSz);
+	
+	return ptr ? ptr + (addr - lo) : NULL;
+}
+
+static void socDmaPrvElemFromRam(void *dst, const uint8_t *ram, uint_fast8_t accessSz)
+{
+	if (accessSz == 4)
+		*(uint32_t*)dst = le32toh(*(const uint32_t*)ram);
+	else if (accessSz == 2)
+		*(uint16_t*)dst = le16toh(*(const uint16_t*)ram);
+	else
+		*(uint8_t*)dst = *ram;
+}
+
+static void socDmaPrvElemToRam(uint8_t *ram, const void *src, uint_fast8_t accessSz)
+{
+	if (accessSz == 4)
+		*(uint32_t*)ram = htole32(*(const uint32_t*)src);
+	else if (accessSz == 2)
+		*(uint16_t*)ram = htole16(*(const uint16_t*)src);
+	else
+		*ram = *(const uint8_t*)src;
+}
+
+//num elements, none past the end of the current frame. sides in RAM go through host pointers: contiguous rows are one
+//memmove, strided ones a plain loop, and only a side that is not RAM (a peripheral FIFO, usually) costs a memAccess per element
+static void socDmaPrvChannelXferRow(struct SocDma *dma, struct DmaChannel *ch, uint32_t num, uint_fast8_t accessSz)
+{
+	int32_t srcStep = ch->srcStride.elem, dstStep = ch->dstStride.elem;
+	bool frameEnded = ch->curElemIdx + num == ch->active.cen;
+	uint32_t i, maxIdx, numInFrame = num - frameEnded;
+	uint8_t *src, *dst;
+	uint32_t xferBuf;
+	
+	src = socDmaPrvRamSpan(dma, ch->curSrcAddr, srcStep, num, accessSz);
+	dst = socDmaPrvRamSpan(dma, ch->curDstAddr, dstStep, num, accessSz);
+	
+	if (src && dst && srcStep == accessSz && dstStep == accessSz && (dst <= src || dst >= src + num * accessSz))	//an overlapping copy upwards replicates, element by element
+		memmove(dst, src, num * accessSz);
+	else if (src && dst) {
+		for (i = 0; i < num; i++)
+			memmove(dst + (int32_t)i * dstStep, src + (int32_t)i * srcStep, accessSz);
+	}
+	else for (i = 0; i < num; i++) {
+		
+		uint32_t srcAddr = ch->curSrcAddr + (int32_t)i * srcStep, dstAddr = ch->curDstAddr + (int32_t)i * dstStep;
+		
+		if (src)
+			socDmaPrvElemFromRam(&xferBuf, src + (int32_t)i * srcStep, accessSz);
+		else if (!memAccess(dma->mem, srcAddr, accessSz, false, &xferBuf))
+			ERR("DMA ch %u bus error on read at 0x%08lx\n", (unsigned)(ch - dma->ch), (unsigned long)srcAddr);
+		
+		if (dst)
+			socDmaPrvElemToRam(dst + (int32_t)i * dstStep, &xferBuf, accessSz);
+		else if (!memAccess(dma->mem, dstAddr, accessSz, true, &xferBuf))
+			ERR("DMA ch %u bus error on write at 0x%08lx\n", (unsigned)(ch - dma->ch), (unsigned long)dstAddr);
+	}
+	
+	if (dst)
+		ramDirtyMark(dma->ram, dstStep < 0 ? ch->curDstAddr + (int32_t)(num - 1) * dstStep : ch->curDstAddr, (dstStep < 0 ? -dstStep : dstStep) * (num - 1) + accessSz);
+	
+	ch->curSrcAddr += (int32_t)(num - 1) * srcStep + (frameEnded ? ch->srcStride.frame : srcStep);
+	ch->curDstAddr += (int32_t)(num - 1) * dstStep + (frameEnded ? ch->dstStride.frame : dstStep);
+	
+	//status as if each element had been done on its own
+	maxIdx = ch->curElemIdx + numInFrame;	//highest element index seen after an element that did not end the frame
+	if (numInFrame && ch->curFrameIdx == ch->active.cfn - 1)
+		ch->csr |= 0x10 & ch->cicr;
+	if ((numInFrame && maxIdx >= ch->active.cen / 2u) || (frameEnded && !(ch->active.cen / 2)))
+		ch->csr |= 0x04 & ch->cicr;
+	
+	ch->curElemIdx += num;
+	if (frameEnded) {
+		ch->curElemIdx = 0;
+		ch->csr |= 0x08 & ch->cicr;
+		if (++ch->curFrameIdx == ch->active.cfn)
+			ch->curFrameIdx = 0;
+		if (ch->curFrameIdx == ch->active.cfn - 1)
+			ch->csr |= 0x10 & ch->cicr;
+	}
+}
+
+//a synchronized channel between RAM and a peripheral with a bulk handler moves as much of the block as the peripheral has in one go
+static bool socDmaPrvChannelDoBulk(struct SocDma *dma, struct DmaChannel *ch, uint_fast8_t reqNum, uint_fast8_t accessSz)	//false if nothing moved
+{
+	uint32_t total = (uint32_t)ch->active.cen * ch->active.cfn, pos = (uint32_t)ch->curFrameIdx * ch->active.cen + ch->curElemIdx;
+	const struct DmaBulk *bulk = NULL;
+	uint32_t i, memAddr, nElems;
+	bool frameEnded;
+	uint8_t *ptr;
+	
+	for (i = 0; i < dma->numBulk && !bulk; i++) {
+		if (dma->bulk[i].reqNum == reqNum)
+			bulk = &dma->bulk[i];
+	}
+	if (!bulk || pos >= total)
+		return false;
+	
+	//memory side must be post-incrementing, peripheral side constant
+	if (((ch->ccr >> (bulk->toPeriph ? 12 : 14)) & 3) != 1 || ((ch->ccr >> (bulk->toPeriph ? 14 : 12)) & 3) != 0)
+		return false;
+	
+	memAddr = bulk->toPeriph ? ch->curSrcAddr : ch->curDstAddr;
+	ptr = (uint8_t*)ramGetPtr(dma->ram, memAddr, (total - pos) * accessSz);
+	if (!ptr)
+		return false;
+	
+	nElems = bulk->f(bulk->userData, ptr, (total - pos) * accessSz, accessSz) / accessSz;
+	if (!nElems)
+		return false;
+	
+	if (bulk->toPeriph)
+		ch->curSrcAddr += nElems * accessSz;
+	else {
+		ramDirtyMark(dma->ram, memAddr, nElems * accessSz);
+		ch->curDstAddr += nElems * accessSz;
 	}
 	
-	return addr;
+	//leave the state and status the element-at-a-time path would have
+	frameEnded = ch->curElemIdx + nElems >= ch->active.cen;
+	pos += nElems;
+	ch->curElemIdx = pos % ch->active.cen;
+	ch->curFrameIdx = (pos == total) ? 0 : pos / ch->active.cen;
+	
+	if (frameEnded)
+		ch->csr |= 0x08 & ch->cicr;
+	if (ch->curFrameIdx == ch->active.cfn - 1)
+		ch->csr |= 0x10 & ch->cicr;
+	if (frameEnded || ch->curElemIdx >= ch->active.cen / 2)
+		ch->csr |= 0x04 & ch->cicr;
+	
+	return true;
 }
 
 static void socDmaPrvChannelActIfNeeded(struct SocDma *dma, struct DmaChannel *ch)
 {
 	uint_fast8_t reqNum = ch->ccr & 0x1f, accessSz = ch->csdp & 3 /* lg2 */;
-	uint_fast16_t i, nElems;
 	bool entire = true;		//make memory-to-memory xfers instant
-	char xferBuf[4];
+	uint32_t nElems, now;
 	
 	//bursting appears not mandatory so we do not do it
 	//packing appears not mandatory so we do not do it
@@ -345,7 +520,7 @@ static void socDmaPrvChannelActIfNeeded(struct SocDma *dma, struct DmaChannel *c
 	
 	//sort out how much to xfer
 	if (entire)	//mem to mem xfers are instant
-		nElems = ch->active.cen * ch->active.cfn;
+		nElems = (uint32_t)ch->active.cen * ch->active.cfn;
 	else if (ch->ccr & 0x20)//transfer a frame
 		nElems = ch->active.cen;
 	else					//transfer an element
@@ -353,28 +528,20 @@ static void socDmaPrvChannelActIfNeeded(struct SocDma *dma, struct DmaChannel *c
 	
 	//fprintf(stderr, "DMA ch %lu: xferring %u %u-byte elems from 0x%08x to 0x%08x\n", ch - dma->ch, (unsigned)nElems, accessSz, ch->curSrcAddr, ch->curDstAddr);
 	
-	for (i = 0; i < nElems; i++) {
-		
-		if (!memAccess(dma->mem, ch->curSrcAddr, accessSz, false, xferBuf)) 
-			ERR("DMA ch %u bus error on read at 0x%08lx\n", (unsigned)(ch - dma->ch), (unsigned long)ch->curSrcAddr);
-		else if (!memAccess(dma->mem, ch->curDstAddr, accessSz, true, xferBuf))
-			ERR("DMA ch %u bus error on write at 0x%08lx\n", (unsigned)(ch - dma->ch), (unsigned long)ch->curDstAddr);
-		
-		if (++ch->curElemIdx == ch->active.cen) {
-			ch->curElemIdx = 0;
-			ch->csr |= 0x08 & ch->cicr;
-			if (++ch->curFrameIdx == ch->active.cfn)
-				ch->curFrameIdx = 0;
-		}
+	if (reqNum && socDmaPrvChannelDoBulk(dma, ch, reqNum, accessSz))
+		nElems = 0;
 	
-		ch->curSrcAddr = socDmaPrvAdjustAddress(dma, ch, ch->curSrcAddr, accessSz, (ch->ccr >> 12) & 3);
-		ch->curDstAddr = socDmaPrvAdjustAddress(dma, ch, ch->curDstAddr, accessSz, (ch->ccr >> 14) & 3);
-		
-		if (ch->curFrameIdx == ch->active.cfn - 1)
-			ch->csr |= 0x10 & ch->cicr;
+	if (!ch->active.cen)	//nothing to move
+		nElems = 0;
+	
+	//a row at a time
+	while (nElems) {
 		
-		if (ch->curElemIdx >= ch->active.cen / 2)
-			ch->csr |= 0x04 & ch->cicr;
+		now = ch->active.cen - ch->curElemIdx;
+		if (now > nElems)
+			now = nElems;
+		socDmaPrvChannelXferRow(dma, ch, now, accessSz);
+		nElems -= now;
 	}
 	
 	if (!ch->curElemIdx && !ch->curFrameIdx) {
@@ -401,10 +568,10 @@ static void socDmaPrvChannelActIfNeeded(struct SocDma *dma, struct DmaChannel *c
 	}
 	
 update_irq:
-	socIcInt(dma->ic, ch->irqNo, (ch->csr & 0x3f) || (ch->friendChannel && (ch->friendChannel->csr & 0x3f)));
+	omapIcInt(dma->ic, ch->irqNo, (ch->csr & 0x3f) || (ch->friendChannel && (ch->friendChannel->csr & 0x3f)));
 }
 
-struct SocDma* socDmaInit(struct ArmMem *physMem, struct SocIc *ic)
+struct SocDma* omapDmaInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic)
 {
 	static const uint8_t irqNos[] = {OMAP_I_DMA_CH0_CH6, OMAP_I_DMA_CH1_CH7, OMAP_I_DMA_CH2_CH8, OMAP_I_DMA_CH3, OMAP_I_DMA_CH4, OMAP_I_DMA_CH5, OMAP_I_DMA_CH0_CH6, OMAP_I_DMA_CH1_CH7, OMAP_I_DMA_CH2_CH8};
 	struct SocDma *dma = (struct SocDma*)malloc(sizeof(*dma));
@@ -416,6 +583,7 @@ struct SocDma* socDmaInit(struct ArmMem *physMem, struct SocIc *ic)
 	memset(dma, 0, sizeof (*dma));
 	dma->ic = ic;
 	dma->mem = physMem;
+	dma->ram = ram;
 	dma->gcr = 8;
 	
 	for (i = 0; i < NUM_CHANNELS; i++) {
@@ -438,7 +606,7 @@ struct SocDma* socDmaInit(struct ArmMem *physMem, struct SocIc *ic)
 	return dma;
 }
 
-void socDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested)
+void omapDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested)
 {
 	if (chNum < sizeof(dma->pendingReqs) * CHAR_BIT) {
 		if (requested)
@@ -448,7 +616,21 @@ void socDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested)
 	}
 }
 
-void socDmaPeriodic(struct SocDma* dma)
+void omapDmaSetBulkHandler(struct SocDma* dma, uint_fast8_t chNum, bool toPeriph, SocDmaBulkF f, void *userData)
+{
+	struct DmaBulk *bulk;
+	
+	if (dma->numBulk == MAX_BULK)
+		ERR("too many DMA bulk handlers\n");
+	
+	bulk = &dma->bulk[dma->numBulk++];
+	bulk->f = f;
+	bulk->userData = userData;
+	bulk->reqNum = chNum;
+	bulk->toPeriph = toPeriph;
+}
+
+void omapDmaPeriodic(struct SocDma* dma)
 {
 	uint_fast8_t i;
 	
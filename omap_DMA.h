@@ -36,6 +36,11 @@
 #define DMA_REQ_USB_FUNC_TX_2	31
 
 
+struct SocDma* omapDmaInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic);
+void omapDmaPeriodic(struct SocDma* dma);
+void omapDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested);
+void omapDmaSetBulkHandler(struct SocDma* dma, uint_fast8_t chNum, bool toPeriph, SocDmaBulkF f, void *userData);
+
 
 #endif
 
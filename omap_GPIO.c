@@ -1,7 +1,7 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
 #include "omap_IC.h"
-#include "soc_GPIO.h"
+#include "omap_GPIO.h"
 #include <string.h>
 #include <stdlib.h>
 #include "util.h"
@@ -80,14 +80,14 @@ static void socGpioPrvRecalc(struct SocGpio *gpio, struct OmapGpioBank *bank)
 		
 		if (intCause &~ bank->prevIntSta) {
 			//edge
-			socIcInt(gpio->ic, bank->irqNo, true);
-			socIcInt(gpio->ic, bank->irqNo, false);
+			omapIcInt(gpio->ic, bank->irqNo, true);
+			omapIcInt(gpio->ic, bank->irqNo, false);
 		}
 		bank->prevIntSta = bank->intSta;
 	}
 	else {
 		//level
-		socIcInt(gpio->ic, bank->irqNo, !!intCause);
+		omapIcInt(gpio->ic, bank->irqNo, !!intCause);
 	}
 	
 	//notify emulator users
@@ -368,7 +368,7 @@ static bool socGpioPrvSharedMemAccessF(void* userData, uint32_t pa, uint_fast8_t
 	return true;
 }
 
-struct SocGpio* socGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev)
+struct SocGpio* omapGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev)
 {
 	struct SocGpio *gpio = (struct SocGpio*)malloc(sizeof(*gpio));
 	
@@ -413,7 +413,7 @@ struct SocGpio* socGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8
 	return gpio;
 }
 
-void socGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
+void omapGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
 {
 	struct OmapGpioBank *bank;
 	uint_fast16_t old;
@@ -440,7 +440,7 @@ void socGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
 		socGpioPrvRecalc(gpio, bank);
 }
 
-enum SocGpioState socGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
+enum SocGpioState omapGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
 {
 	struct OmapGpioBank *bank;
 	uint_fast16_t old;
@@ -465,7 +465,7 @@ enum SocGpioState socGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
 	return (bank->latches & (1UL << gpioNum)) ? SocGpioStateHigh : SocGpioStateLow;
 }
 
-void socGpioSetNotif(struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData)
+void omapGpioSetNotif(struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData)
 {
 	struct OmapGpioBank *bank;
 	
@@ -484,7 +484,7 @@ void socGpioSetNotif(struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNoti
 	bank->notifD[gpioNum] = userData;
 }
 
-void socGpioSetDirsChangedNotif(struct SocGpio *gpio, GpioDirsChangedF notifF, void *userData)
+void omapGpioSetDirsChangedNotif(struct SocGpio *gpio, GpioDirsChangedF notifF, void *userData)
 {
 	gpio->dirNotifF = notifF;
 	gpio->dirNotifD = userData;
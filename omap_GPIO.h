@@ -0,0 +1,16 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _OMAP_GPIO_H_
+#define _OMAP_GPIO_H_
+
+#include "soc_GPIO.h"
+
+
+struct SocGpio* omapGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev);
+enum SocGpioState omapGpioGetState(struct SocGpio* gpio, uint_fast8_t gpioNum);
+void omapGpioSetState(struct SocGpio* gpio, uint_fast8_t gpioNum, bool on);
+void omapGpioSetNotif(struct SocGpio* gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData);
+void omapGpioSetDirsChangedNotif(struct SocGpio* gpio, GpioDirsChangedF notifF, void *userData);
+
+
+#endif
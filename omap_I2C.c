@@ -2,7 +2,7 @@
 
 #include "omap_DMA.h"
 #include "omap_IC.h"
-#include "soc_I2C.h"
+#include "omap_I2C.h"
 #include <string.h>
 #include <stdlib.h>
 #include "util.h"
@@ -35,7 +35,7 @@ struct SocI2c {
 	uint16_t dcountOrig, fifoVal, prevStat;
 };
 
-bool socI2cDeviceAdd(struct SocI2c *i2c, I2cDeviceActionF actF, void *userData)
+bool omapI2cDeviceAdd(struct SocI2c *i2c, I2cDeviceActionF actF, void *userData)
 {
 	uint_fast8_t i;
 	
@@ -65,14 +65,14 @@ static void socI2cPrvRecalcIrq(struct SocI2c *i2c)
 	
 	if (newHighs & effectiveIe & 0x001f) {
 		//edge
-		socIcInt(i2c->ic, i2c->irqNo, true);
-		socIcInt(i2c->ic, i2c->irqNo, false);
+		omapIcInt(i2c->ic, i2c->irqNo, true);
+		omapIcInt(i2c->ic, i2c->irqNo, false);
 	}
 	
 	i2c->prevStat = i2c->stat;
 	
-	socDmaExternalReq(i2c->dma, DMA_REQ_I2C_RX, (i2c->buf & 0x8000) && (i2c->stat & 0x0008));
-	socDmaExternalReq(i2c->dma, DMA_REQ_I2C_TX, (i2c->buf & 0x0080) && (i2c->stat & 0x0010));
+	omapDmaExternalReq(i2c->dma, DMA_REQ_I2C_RX, (i2c->buf & 0x8000) && (i2c->stat & 0x0008));
+	omapDmaExternalReq(i2c->dma, DMA_REQ_I2C_TX, (i2c->buf & 0x0080) && (i2c->stat & 0x0010));
 }
 
 static void socI2cPrvReset(struct SocI2c *i2c)
@@ -423,7 +423,7 @@ static bool socI2cPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 	return ret;
 }
 
-struct SocI2c* socI2cInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint32_t irqNo)
+struct SocI2c* omapI2cInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint32_t irqNo)
 {
 	struct SocI2c *i2c = (struct SocI2c*)malloc(sizeof(*i2c));
 	
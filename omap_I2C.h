@@ -0,0 +1,13 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _OMAP_I2C_H_
+#define _OMAP_I2C_H_
+
+#include "soc_I2C.h"
+
+
+struct SocI2c* omapI2cInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint32_t irqNo);
+bool omapI2cDeviceAdd(struct SocI2c *i2c, I2cDeviceActionF actF, void *userData);
+
+
+#endif
@@ -87,7 +87,7 @@ static void socIcPrvRecalc(struct SocIc *ic, struct OmapIc *oic)
 	}
 	else {
 		//fprintf(stderr, "IRQ: 2nd LVL IRQ %s. highest prio %d for irq %d\n", nowIrq ? "ON" : "OFF", highestIrqPrio, highestIrqNo);
-		socIcInt(ic, OMAP_I_LEVEL_2, nowIrq);
+		omapIcInt(ic, OMAP_I_LEVEL_2, nowIrq);
 	}
 
 	oic->wasFiq = nowFiq;
@@ -209,7 +209,7 @@ static bool socIcPrvLv2memAccessF(void* userData, uint32_t pa, uint_fast8_t size
 	return socIcPrvMemAccessF(ic, &ic->level2, pa - OMAP_IC_LV2_BASE, size, write, buf);
 }
 
-struct SocIc* socIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev)
+struct SocIc* omapIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev)
 {
 	struct SocIc *ic = (struct SocIc*)malloc(sizeof(*ic));
 	uint_fast8_t i;
@@ -261,7 +261,7 @@ static void socIcPrvInt(struct SocIc *ic, struct OmapIc *oic, uint_fast8_t local
 	socIcPrvRecalc(ic, oic);
 }
 
-void socIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise)		//interrupt caused by emulated hardware
+void omapIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise)		//interrupt caused by emulated hardware
 {
 	//int8 for compiler quieting
 	if ((int8_t)intNum >= OMAP_LV1_MIN && intNum <= OMAP_LV1_MAX)
@@ -74,6 +74,9 @@
 #define OMAP_I_McBSP2_OVERFLOW	OMAP_LV2_IRQ(31)
 
 
+struct SocIc* omapIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev);
+void omapIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise);
+
 
 #endif
 
@@ -2,9 +2,10 @@
 
 #include "omap_LCD.h"
 #include "omap_IC.h"
-#include "SDL2/SDL.h"
+#include "display.h"
 #include <string.h>
 #include <stdlib.h>
+#include "speed.h"
 #include "util.h"
 #include "mem.h"
 
@@ -23,9 +24,9 @@ enum OmapLcdState {
 };
 
 struct OmapLcd {
-	SDL_Surface *mScreen;
-	SDL_Window *mWindow;
+	struct Display *disp;
 	struct ArmMem *mem;
+	struct ArmRam *ram;
 	struct SocIc *ic;
 	
 	//dma configs
@@ -44,6 +45,12 @@ struct OmapLcd {
 	uint8_t fetchData	: 1;
 	uint16_t pal[256];
 	uint32_t curAddr;
+	
+	//what we last drew
+	uint16_t drawnPal[256];
+	uint32_t drawnAddr;
+	uint8_t drawnDepth;
+	bool redrawAll;
 };
 
 static void omapLcdPrvIrqsRecalc(struct OmapLcd *lcd)
@@ -56,7 +63,7 @@ static void omapLcdPrvIrqsRecalc(struct OmapLcd *lcd)
 		irq = true;
 	else if ((lcd->status & 0x40) && (lcd->ctrl & 0x10))		//pallete loaded
 		irq = true;
-	socIcInt(lcd->ic, OMAP_I_LCD, irq);
+	omapIcInt(lcd->ic, OMAP_I_LCD, irq);
 	
 	//LCD DMA irq
 	irq = false;
@@ -64,40 +71,21 @@ static void omapLcdPrvIrqsRecalc(struct OmapLcd *lcd)
 		irq = true;
 	else if ((lcd->dmaCtrl & 0x30) && (lcd->ctrl & 0x02))		//frame done
 		irq = true;
-	socIcInt(lcd->ic, OMAP_I_DMA_CH_LCD, irq);
+	omapIcInt(lcd->ic, OMAP_I_DMA_CH_LCD, irq);
 }
 
-static uint16_t* omapLcdPrvGetFb(struct OmapLcd *lcd)
+static void omapLcdPrvOpenDisplay(struct OmapLcd *lcd)
 {
 	uint32_t w = (lcd->timing[0] & 0x3ff) + 1;
 	uint32_t h = (lcd->timing[1] & 0x3ff) + 1;
 	
-	if (!lcd->mWindow) {
-		
-		uint32_t winH = h;
-		
-		if (lcd->hardGrafArea && w == h)
-			winH += 3 * w / 8;
-		
-		fprintf(stderr, "SCREEN configured for %u x %u\n", (unsigned)w, (unsigned)h);
-		lcd->mWindow = SDL_CreateWindow("uARM", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, w, winH, 0);
-		if (lcd->mWindow == NULL)
-			ERR("Couldn't create window: %s\n", SDL_GetError());
-		
-		lcd->mScreen = SDL_CreateRGBSurface(0, w, h, 16, 0xf800, 0x07e0, 0x001f, 0x0000);
-		if (lcd->mScreen == NULL)
-			ERR("Couldn't create screen surface: %s\n", SDL_GetError());
-	}
-	
-	SDL_LockSurface(lcd->mScreen);
-	return (uint16_t*)lcd->mScreen->pixels;
+	if (!lcd->disp)
+		lcd->disp = displayInit(w, h, (lcd->hardGrafArea && w == h) ? h + 3 * w / 8 : h);
 }
 
 static void omapLcdPrvReleaseFb(struct OmapLcd *lcd)
 {
-	SDL_UnlockSurface(lcd->mScreen);
-	SDL_BlitSurface(lcd->mScreen, NULL, SDL_GetWindowSurface(lcd->mWindow), NULL);
-	SDL_UpdateWindowSurface(lcd->mWindow);
+	displayPublish(lcd->disp);
 }
 
 static bool omapLcdPrvReadWord(struct OmapLcd *lcd, uint32_t addr, uint16_t *wordP)
@@ -115,11 +103,15 @@ static bool omapLcdPrvReadWord(struct OmapLcd *lcd, uint32_t addr, uint16_t *wor
 
 void omapLcdPeriodic(struct OmapLcd *lcd)
 {
-	uint32_t i, num, addr = lcd->curAddr, r, c, v;
+	static const uint8_t fmts[] = {DisplayPixPal1, DisplayPixPal2, DisplayPixPal4, DisplayPixPal8};
+	uint32_t i, num, addr = lcd->curAddr, r, c, v, rowWords, frameAddr, srcW;
 	uint32_t w = (lcd->timing[0] & 0x3ff) + 1;
 	uint32_t h = (lcd->timing[1] & 0x3ff) + 1;
-	uint_fast8_t j;
-	uint16_t *dst;
+	uint8_t rowBuf[1024 * 2];
+	const uint8_t *src;
+	uint_fast8_t fmt;
+	uint16_t data;
+	bool all;
 	
 	switch (lcd->state) {			//on and doing things
 		
@@ -197,7 +189,6 @@ void omapLcdPeriodic(struct OmapLcd *lcd)
 		case OmapLcdFetchingData:
 		
 			num = w * h;
-			dst = omapLcdPrvGetFb(lcd);
 			
 			switch (lcd->curDepth) {
 				case 0:	//1bpp (maybe unsupported)
@@ -216,46 +207,60 @@ void omapLcdPeriodic(struct OmapLcd *lcd)
 				default:
 					break;
 			}
-			for (i = 0; i < num; i++, addr += sizeof(uint16_t)) {
-				
-				uint16_t data;
+			rowWords = num / h;
+			
+			//pixels a row of whole halfwords holds, "w" may not fill the last one
+			srcW = rowWords * (16 >> (lcd->curDepth < 4 ? lcd->curDepth : 4));
+			if (srcW > w)
+				srcW = w;
+			
+			//only rows written since we last drew need converting, unless something else changed
+			all = lcd->redrawAll || lcd->drawnAddr != addr || lcd->drawnDepth != lcd->curDepth || memcmp(lcd->drawnPal, lcd->pal, sizeof(lcd->pal));
+			if (!all && !ramDirtyTest(lcd->ram, addr, num * sizeof(uint16_t)))
+				goto frame_done;
+			
+			if (speedShouldSkipFrame())	//behind real time - do not draw this one
+				goto frame_done;
+			
+			frameAddr = addr;
+			omapLcdPrvOpenDisplay(lcd);
+			
+			//pixels are packed msb-first in bytes, those in little-endian halfwords
+			fmt = (lcd->curDepth < 4) ? (fmts[lcd->curDepth] | DISPLAY_PIX_MSB_FIRST) : DisplayPixRgb565;
+			
+			for (r = 0; r < h; r++) {
 				
-				if (!omapLcdPrvReadWord(lcd, addr, &data))
-					return;
+				addr = frameAddr + r * rowWords * sizeof(uint16_t);
+				if (!all && !ramDirtyTest(lcd->ram, addr, rowWords * sizeof(uint16_t)))
+					continue;
 				
-				switch (lcd->curDepth) {
-					case 0:			//1bpp
-						data = __builtin_bswap16(data);
-						for (j = 0; j < 16; j++, data <<= 1)
-							*dst++ = lcd->pal[data >> 15];
-						break;
-					
-					case 1:			//2bpp
-						data = __builtin_bswap16(data);
-						for (j = 0; j < 16; j += 2, data <<= 2)
-							*dst++ = lcd->pal[data >> 14];
-						break;
-					
-					case 2:			//4bpp
-						data = __builtin_bswap16(data);
-						for (j = 0; j < 16; j += 4, data <<= 4)
-							*dst++ = lcd->pal[data >> 12];
-						break;
+				src = ramGetPtr(lcd->ram, addr, rowWords * sizeof(uint16_t));
+				if (!src) {
 					
-					case 3:			//8bpp
-						*dst++ = lcd->pal[data & 0xff];
-						*dst++ = lcd->pal[data >> 8];
-						break;
-					
-					default:
-						*dst++ = data;
-						break;
+					for (i = 0; i < rowWords; i++) {
+						if (!omapLcdPrvReadWord(lcd, addr + i * sizeof(uint16_t), &data))
+							return;
+						rowBuf[i * 2 + 0] = data;
+						rowBuf[i * 2 + 1] = data >> 8;
+					}
+					src = rowBuf;
+				}
+				
+				displayDrawRow(lcd->disp, r, src, srcW, fmt, lcd->pal);
 			}
-		}
+			addr = frameAddr + num * sizeof(uint16_t);
+			
+			ramDirtyClear(lcd->ram, frameAddr, num * sizeof(uint16_t));
+			memcpy(lcd->drawnPal, lcd->pal, sizeof(lcd->pal));
+			lcd->drawnDepth = lcd->curDepth;
+			lcd->drawnAddr = frameAddr;
+			lcd->redrawAll = false;
+			omapLcdPrvReleaseFb(lcd);
+		
+		frame_done:
 		lcd->state = OmapLcdResting;
 		lcd->status |= 0x01;	//done
 		lcd->dmaCtrl |= 1 << (lcd->whichFrame ? 4 : 3);
-		omapLcdPrvReleaseFb(lcd);
 		break;
 	}
 	lcd->curAddr = addr;
@@ -286,6 +291,7 @@ static bool omapLcdPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 					lcd->status |= 0x01;
 				
 				lcd->ctrl = val & 0x01fff39bul;
+				lcd->redrawAll = true;
 			}
 			else
 				val = (lcd->ctrl & 0xfffffffeul) | (lcd->curEna ? 1 : 0);
@@ -294,8 +300,10 @@ static bool omapLcdPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 		case 0x04 / 4:
 		case 0x08 / 4:
 		case 0x0c / 4:
-			if (write)
+			if (write) {
 				lcd->timing[pa - 0x04 / 4] = val;
+				lcd->redrawAll = true;
+			}
 			else
 				val = lcd->timing[pa - 0x04 / 4];
 			break;
@@ -380,7 +388,7 @@ static bool omapLcdPrvDmaMemAccessF(void* userData, uint32_t pa, uint_fast8_t si
 	return true;
 }
 
-struct OmapLcd* omapLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardGrafArea)
+struct OmapLcd* omapLcdInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic, bool hardGrafArea)
 {
 	struct OmapLcd *lcd = (struct OmapLcd*)malloc(sizeof(*lcd));
 	
@@ -390,7 +398,9 @@ struct OmapLcd* omapLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardG
 	memset(lcd, 0, sizeof (*lcd));
 	lcd->hardGrafArea = hardGrafArea;
 	lcd->mem = physMem;
+	lcd->ram = ram;
 	lcd->ic = ic;
+	lcd->redrawAll = true;
 	
 	if (!memRegionAdd(physMem, OMAP_LCD_BASE, OMAP_LCD_SIZE, omapLcdPrvMemAccessF, lcd))
 		ERR("cannot add LCD to MEM\n");
@@ -398,6 +408,7 @@ struct OmapLcd* omapLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardG
 	if (!memRegionAdd(physMem, OMAP_LCD_DMA_BASE, OMAP_LCD_DMA_SIZE, omapLcdPrvDmaMemAccessF, lcd))
 		ERR("cannot add LCD DMA to MEM\n");
 	
+	ramDirtyTrack(ram);
 	omapLcdPrvIrqsRecalc(lcd);
 	
 	return lcd;
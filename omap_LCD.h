@@ -6,12 +6,13 @@
 #include "soc_DMA.h"
 #include "soc_IC.h"
 #include "mem.h"
+#include "RAM.h"
 
 struct OmapLcd;
 
 
 
-struct OmapLcd* omapLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardGrafArea);
+struct OmapLcd* omapLcdInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic, bool hardGrafArea);
 void omapLcdPeriodic(struct OmapLcd *lcd);
 
 
@@ -49,9 +49,9 @@ static void omapMmcPrvRecalcIrqAndDma(struct OmapMmc *mmc)
 		txTrigger = false;
 	}
 	
-	socIcInt(mmc->ic, OMAP_I_MMC, mmc->stat & mmc->ie);
-	socDmaExternalReq(mmc->dma, DMA_REQ_MMC_RX, rxTrigger);
-	socDmaExternalReq(mmc->dma, DMA_REQ_MMC_TX, txTrigger);
+	omapIcInt(mmc->ic, OMAP_I_MMC, mmc->stat & mmc->ie);
+	omapDmaExternalReq(mmc->dma, DMA_REQ_MMC_RX, rxTrigger);
+	omapDmaExternalReq(mmc->dma, DMA_REQ_MMC_TX, txTrigger);
 }
 
 static void omapMmcPrvDataXferAdvance(struct OmapMmc *mmc)
@@ -206,6 +206,96 @@ static bool omapMmcPrvFifoR(struct OmapMmc *mmc, uint_fast16_t *valP)
 	return true;
 }
 
+static uint32_t omapMmcPrvWholeBlocks(struct OmapMmc *mmc, uint32_t bytes)	//how many blocks can skip the buffer
+{
+	uint32_t num = bytes / VSD_SECTOR_SIZE, left;
+	
+	if (mmc->blen != VSD_SECTOR_SIZE)
+		return 0;
+	left = vsdDataBlocksLeft(mmc->vsd);
+	if (num > mmc->nblk)
+		num = mmc->nblk;
+	
+	return num < left ? num : left;
+}
+
+//DMA draining the buffer: what is in it, then whole blocks straight from the card into RAM
+static uint32_t omapMmcPrvDmaRx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct OmapMmc *mmc = (struct OmapMmc*)userData;
+	uint8_t *dst = (uint8_t*)buf;
+	uint32_t done = 0, now;
+	
+	if (itemSz != 2)	//the data register is 16 bits wide
+		return 0;
+	
+	while (done < len && mmc->dataXferActive && (mmc->cmd & 0x8000) && mmc->bufferBytes) {
+		
+		now = len - done < mmc->bufferBytes ? len - done : mmc->bufferBytes;
+		memcpy(dst + done, mmc->buffer, now);
+		memmove(mmc->buffer, mmc->buffer + now, mmc->bufferBytes -= now);
+		done += now;
+		if (mmc->bufferBytes)
+			break;
+		
+		now = omapMmcPrvWholeBlocks(mmc, len - done);
+		if (now) {
+			if (vsdDataXferBlocks(mmc->vsd, dst + done, now) != SdDataOk) {
+				mmc->stat |= 0x0040;
+				break;
+			}
+			mmc->nblk -= now;
+			done += now * VSD_SECTOR_SIZE;
+		}
+		omapMmcPrvDataXferAdvance(mmc);
+	}
+	
+	if (done)
+		omapMmcPrvRecalcIrqAndDma(mmc);
+	
+	return done;
+}
+
+//DMA filling the buffer: whole blocks go straight to the card, the rest through the buffer
+static uint32_t omapMmcPrvDmaTx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct OmapMmc *mmc = (struct OmapMmc*)userData;
+	const uint8_t *src = (const uint8_t*)buf;
+	uint32_t done = 0, now;
+	
+	if (itemSz != 2)	//the data register is 16 bits wide
+		return 0;
+	
+	while (done < len && mmc->dataXferActive && !(mmc->cmd & 0x8000)) {
+		
+		if (!mmc->bufferBytes && (now = omapMmcPrvWholeBlocks(mmc, len - done)) != 0) {
+			
+			if (vsdDataXferBlocks(mmc->vsd, (void*)(src + done), now) != SdDataOk) {
+				mmc->stat |= 0x0020;
+				break;
+			}
+			mmc->nblk -= now;
+			done += now * VSD_SECTOR_SIZE;
+			continue;
+		}
+		
+		now = mmc->blen - mmc->bufferBytes;
+		if (now > len - done)
+			now = len - done;
+		memcpy(mmc->buffer + mmc->bufferBytes, src + done, now);
+		mmc->bufferBytes += now;
+		done += now;
+		
+		if (mmc->bufferBytes == mmc->blen)
+			omapMmcPrvDataXferAdvance(mmc);
+	}
+	
+	if (done)
+		omapMmcPrvRecalcIrqAndDma(mmc);
+	
+	return done;
+}
+
 static bool omapMmcPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* buf)
 {
 	struct OmapMmc *mmc = (struct OmapMmc*)userData;
@@ -387,6 +477,9 @@ struct OmapMmc *omapMmcInit(struct ArmMem *physMem, struct SocIc *ic, struct Soc
 	
 	mmc->syst = 0x2000;
 	
+	omapDmaSetBulkHandler(dma, DMA_REQ_MMC_RX, false, omapMmcPrvDmaRx, mmc);
+	omapDmaSetBulkHandler(dma, DMA_REQ_MMC_TX, true, omapMmcPrvDmaTx, mmc);
+	
 	if (!memRegionAdd(physMem, OMAP_MMC_BASE, OMAP_MMC_SIZE, omapMmcPrvMemAccessF, mmc))
 		ERR("cannot add MMC to MEM\n");
 	
@@ -1,24 +1,25 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
 #include "omap_McBSP.h"
+#include "omap_DMA.h"
 #include <string.h>
 #include <stdlib.h>
+#include "endian.h"
 #include "util.h"
 
 
 
-enum OmapMcBspPipeStateType {
-	OmapMcBspPipeInReset,
-	OmapMcBspPipeWaitForFrame,
-	OmapMcBspPipePostFrameDelay,
-	OmapMcBspPipePhase1,
-	OmapMcBspPipePhase2,
-};
+#define OMAP_McBSP_SIZE			0x40
+#define OMAP_McBSP_QUEUE		128			//words DMA can stage ahead of the shifters, each way
+#define OMAP_McBSP_MAX_FRAMES	64			//most frames moved per periodic call. a bigger backlog is dropped
+#define OMAP_McBSP_CLKS_HZ		12000000UL	//what the sample rate generator divides, with CLKSM set
+#define OMAP_McBSP_EXT_FS_HZ	44100		//frame rate assumed when the other end drives frame sync
+
 
-struct OmapMcBspPipeState {
-	enum OmapMcBspPipeStateType state;
-	uint_fast8_t wordIdx;
-	uint_fast8_t bitIdx;
+struct OmapMcBspQueue {
+	uint32_t words[OMAP_McBSP_QUEUE];
+	uint8_t readPtr;
+	uint8_t numItems;
 };
 
 struct OmapMcBsp {
@@ -28,29 +29,26 @@ struct OmapMcBsp {
 	uint32_t base;
 	uint8_t irqNoTx, irqNoRx, dmaNoTx, dmaNoRx;
 	
+	//frame clock: how often we are called and the fraction of a frame left over
+	uint32_t periodicHz, clkRem;
+	
 	//data holding regs
-	uint32_t drr, rbr, rsr, dxr, xsr;
+	uint32_t drr, dxr, xsr;
 	
 	//configs
 	uint16_t spcr1, spcr2, rcr1, rcr2, xcr1, xcr2, srgr1, srgr2, mcr1, mcr2, pcr;
 	uint16_t rcer[8], xcer[8];
 	
-	//state
-	uint32_t rbrFull			: 1;
-	uint32_t drrFull			: 1;
-	uint32_t rsrBits			: 5;		///xxx: set
-	uint32_t xsrBits			: 5;		///xxx: set
-	uint32_t curTxWordBitLen	: 6;		///xxx: set
-	uint32_t curRxWordBitLen	: 6;		///xxx: set
-	
-	struct OmapMcBspPipeState rxState;
-	struct OmapMcBspPipeState txState;
+	//words move a frame at a time, not a bit at a time, so DMA stages them here
+	struct OmapMcBspQueue txQ, rxQ;
 };
 
 
 //XXX: XEMPTY Bit reset state shoudl be ???
 
-#define OMAP_McBSP_SIZE		0x40
+static uint32_t mExpand[4][256];	//8-bit words by RCOMPAND
+
+
 
 static uint_fast8_t omapMcBspPrvBitRev8(uint_fast8_t val)
 {
@@ -123,14 +121,11 @@ static uint32_t omapMcBspPrvCompandCompress(struct OmapMcBsp *sp, uint32_t val,
 	return ret;
 }
 
-static uint32_t omapMcBspPrvCompandExpand(struct OmapMcBsp *sp, uint32_t val, uint_fast8_t rxBitLen)
+static uint32_t omapMcBspPrvCompandExpandCalc(uint_fast8_t mode, uint32_t val)
 {
 	uint32_t ret = 0;
 	
-	if (rxBitLen != 8)
-		return val;
-	
-	switch ((sp->rcr2 >> 3) & 3) {		//RCOMPAND
+	switch (mode) {		//RCOMPAND
 		case 0:	//nothing
 			ret = val;
 			break;
@@ -175,139 +170,165 @@ static uint_fast8_t omapMcBspPrvBitLenUnpack(struct OmapMcBsp *sp, uint_fast8_t
 {
 	if (val < 5)
 		return 4 * (val + 2);
-	else if (val == 4)
+	else if (val == 5)
 		return 32;
 	
 	ERR("bit length %u not decodeable\n", val);
 	return 0;
 }
 
-static uint_fast8_t omapMcBspPrvTxGoToDataPhase(struct OmapMcBsp *sp, struct OmapMcBspPipeState *ps, bool second)
+//words in a frame, both phases
+static uint32_t omapMcBspPrvFrameWords(uint16_t cr1, uint16_t cr2)
 {
-	ps->state = second ? OmapMcBspPipePhase2 : OmapMcBspPipePhase1;
-	ps->wordIdx = 0;
-	return omapMcBspPrvBitLenUnpack(sp, ((second ? sp->xcr2 : sp->xcr1) >> 5) & 7);
+	uint32_t ret = ((cr1 >> 8) & 0x7f) + 1;
+	
+	if (cr2 & 0x8000)
+		ret += ((cr2 >> 8) & 0x7f) + 1;
+	
+	return ret;
 }
 
-//XXX: xempty needs to be adjusted when data written to buffer
-static void omapMcBspPrvGetXsrIfNeeded(struct OmapMcBsp *sp)
+static void omapMcBspPrvQueuePut(struct OmapMcBspQueue *q, uint32_t val)
 {
-	uint_fast8_t wordsThisPhase;
-	
-	if (sp->xsrBits)
-		return;
-	
-	//sort out if we are about to go to a new phase
-	switch (sp->txState.state) {
-		case OmapMcBspPipePhase1:
-			wordsThisPhase = ((sp->xcr1 >> 8) & 0x7f) + 1;
-			break;
-		
-		case OmapMcBspPipePhase2:
-			wordsThisPhase = ((sp->xcr2 >> 8) & 0x7f) + 1;
-			break;
-		
-		default:
-			ERR("phase %u does not transmit\n", sp->txState.state);
-			break;
-	}
+	q->words[(q->readPtr + q->numItems++) % OMAP_McBSP_QUEUE] = val;
+}
+
+static uint32_t omapMcBspPrvQueueGet(struct OmapMcBspQueue *q)
+{
+	uint32_t ret = q->words[q->readPtr];
 	
-	sp->txState.wordIdx++;
+	q->readPtr = (q->readPtr + 1) % OMAP_McBSP_QUEUE;
+	q->numItems--;
 	
-	if (sp->txState.wordIdx > wordsThisPhase)
-		ERR("word index overflow\n");
-	else if (sp->txState.wordIdx == wordsThisPhase) {
-		
-		if (sp->txState.state == OmapMcBspPipePhase2 || !(sp->xcr2 & 0x8000)) {
-			
-			sp->txState.state = OmapMcBspPipeWaitForFrame;
-			return;
-		}
-		sp->curTxWordBitLen = omapMcBspPrvTxGoToDataPhase(sp, &sp->txState, true);
-	}
+	return ret;
+}
+
+static void omapMcBspPrvUpdateStatus(struct OmapMcBsp *sp)
+{
+	bool txOn = !!(sp->spcr2 & 0x0001), rxOn = !!(sp->spcr1 & 0x0001);
 	
-	//we got here because we just shifted out the last bit in XSR
-	if (sp->spcr2 & 2)	//transmitter was ready for data, but none arrived	
-		sp->spcr2 &=~ 4;		//we have run empty
-	else {
-		sp->spcr2 &=~ 2;
-		sp->xsr = omapMcBspPrvCompandCompress(sp, sp->dxr, sp->curTxWordBitLen);
-	}
+	sp->spcr2 &=~ 0x0006;
+	if (txOn && sp->txQ.numItems < OMAP_McBSP_QUEUE)
+		sp->spcr2 |= 0x0002;	//XRDY
+	if (sp->txQ.numItems)
+		sp->spcr2 |= 0x0004;	//not XEMPTY
 	
-	if (!(sp->spcr2 & 4)) {		//we are empty
-		
-		sp->xsr = 0;
-		fprintf(stderr, "McBsp@0x%08lx: TX underrun\n", (unsigned long)sp->base);
-	}
+	sp->spcr1 &=~ 0x0002;
+	if (rxOn && sp->rxQ.numItems)
+		sp->spcr1 |= 0x0002;	//RRDY
 	
-	sp->xsr <<= 32 - sp->curTxWordBitLen;	//move data to top bits for transmission
-	sp->xsrBits = sp->curTxWordBitLen;
+	//a port in reset still gets DMA and drops what it is given, so guests that start DMA first do not stall
+	omapDmaExternalReq(sp->dma, sp->dmaNoTx, !txOn || (sp->spcr2 & 0x0002));
+	omapDmaExternalReq(sp->dma, sp->dmaNoRx, !rxOn || (sp->spcr1 & 0x0002));
 	
 	omapMcBspPrvUpdateIrqs(sp);
 }
 
-static bool omapMcBspPrvCalcTxBit(struct OmapMcBsp *sp)
+//frames due since the last call, at the rate the sample rate generator (or the other end) runs frame sync at
+static uint32_t omapMcBspPrvFramesDue(struct OmapMcBsp *sp)
 {
-	bool ret;
+	uint32_t fs = OMAP_McBSP_EXT_FS_HZ, due;
+	uint64_t t;
 	
-	//xxx check for transmitter reset
+	if ((sp->srgr2 & 0x1000) && (sp->pcr & 0x0800) && (sp->srgr2 & 0x2000)) {	//FSGM, FSXM, CLKSM: all ours
+		
+		if (!(sp->spcr2 & 0x0040))	//sample rate generator in reset
+			return 0;
+		fs = OMAP_McBSP_CLKS_HZ / ((sp->srgr1 & 0xff) + 1) / ((sp->srgr2 & 0x0fff) + 1);
+	}
 	
-	omapMcBspPrvGetXsrIfNeeded(sp);
+	t = (uint64_t)sp->clkRem + fs;
+	due = t / sp->periodicHz;
+	sp->clkRem = t % sp->periodicHz;
 	
-	ret = !!(sp->xsr >> 31);
-	sp->xsr <<= 1;
-	sp->xsrBits--;
+	return due < OMAP_McBSP_MAX_FRAMES ? due : OMAP_McBSP_MAX_FRAMES;
+}
+
+static void omapMcBspPrvTxFrames(struct OmapMcBsp *sp, uint32_t frames)
+{
+	uint32_t num = frames * omapMcBspPrvFrameWords(sp->xcr1, sp->xcr2), now = sp->txQ.numItems;
 	
-	omapMcBspPrvGetXsrIfNeeded(sp);
+	if (now > num)
+		now = num;
 	
-	return ret;
+	//nobody listens, so only the last word is left in XSR
+	if (now) {
+		sp->txQ.readPtr = (sp->txQ.readPtr + now - 1) % OMAP_McBSP_QUEUE;
+		sp->txQ.numItems -= now - 1;
+		sp->xsr = omapMcBspPrvCompandCompress(sp, omapMcBspPrvQueueGet(&sp->txQ), omapMcBspPrvBitLenUnpack(sp, (sp->xcr1 >> 5) & 7));
+	}
 }
 
-static void omapMcBspPrvSetRbrIfNeeded(struct OmapMcBsp *sp)
+static void omapMcBspPrvRxFrames(struct OmapMcBsp *sp, uint32_t frames)
 {
-	if (sp->rsrBits != sp->curRxWordBitLen)
-		return;
+	uint32_t num = frames * omapMcBspPrvFrameWords(sp->rcr1, sp->rcr2), room = OMAP_McBSP_QUEUE - sp->rxQ.numItems, word = 0, i;
+	
+	//nobody drives our receive line, so every word is all zeroes, expanded if it is 8 bits
+	if (omapMcBspPrvBitLenUnpack(sp, (sp->rcr1 >> 5) & 7) == 8)
+		word = mExpand[(sp->rcr2 >> 3) & 3][word];
+	
+	if (num > room) {
+		
+		num = room;
+		sp->spcr1 |= 0x0004;	//RFULL
+	}
 	
-	//TODO: copy to rbr
+	for (i = 0; i < num; i++)
+		omapMcBspPrvQueuePut(&sp->rxQ, word);
 }
 
-static void omapMcBspPrvAcceptRxBit(struct OmapMcBsp *sp, bool hi)
+static uint32_t omapMcBspPrvDmaTx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
 {
-	//xxx check for receiver reset
+	struct OmapMcBsp *sp = (struct OmapMcBsp*)userData;
+	const uint16_t *src = (const uint16_t*)buf;
+	uint32_t done;
+	
+	if (itemSz != 2 || !(sp->spcr2 & 0x0001))
+		return 0;
+	
+	for (done = 0; done < len / 2 && sp->txQ.numItems < OMAP_McBSP_QUEUE; done++)
+		omapMcBspPrvQueuePut(&sp->txQ, (sp->dxr & 0xffff0000ul) + le16toh(src[done]));
 	
-	sp->rsr <<= 1;
-	if (hi)
-		sp->rsr++;
-	sp->rsrBits++;
+	if (done)
+		omapMcBspPrvUpdateStatus(sp);
 	
-	omapMcBspPrvSetRbrIfNeeded(sp);
+	return done * 2;
 }
 
-static void omapMcBspPrvDoBit(struct OmapMcBsp *sp)
+static uint32_t omapMcBspPrvDmaRx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
 {
-	bool tx = omapMcBspPrvCalcTxBit(sp);
-	bool rx = false;	//for now
+	struct OmapMcBsp *sp = (struct OmapMcBsp*)userData;
+	uint16_t *dst = (uint16_t*)buf;
+	uint32_t done;
 	
-	omapMcBspPrvAcceptRxBit(sp, rx);
+	if (itemSz != 2 || !(sp->spcr1 & 0x0001))
+		return 0;
 	
-	omapMcBspPrvUpdateIrqs(sp);
+	for (done = 0; done < len / 2 && sp->rxQ.numItems; done++) {
+		
+		sp->drr = omapMcBspPrvQueueGet(&sp->rxQ);
+		dst[done] = htole16(sp->drr);
+	}
+	
+	if (done) {
+		sp->spcr1 &=~ 0x0004;	//room again, as for a DRR1 read
+		omapMcBspPrvUpdateStatus(sp);
+	}
+	
+	return done * 2;
 }
 
 void omapMcBspPeriodic(struct OmapMcBsp *sp)
 {
-	uint_fast8_t i;
-	
-	//XXX: consider phases
+	uint32_t frames = omapMcBspPrvFramesDue(sp);
 	
-//	for (i = 0; i < 4; i++)	//all word sizes are multiples of 4
-//		omapMcBspPrvDoBit(sp);
+	if (frames && (sp->spcr2 & 0x0001))
+		omapMcBspPrvTxFrames(sp, frames);
 	
-	//for now, request DMA forever
-	if (!(sp->spcr1 & 0x0001))
-		socDmaExternalReq(sp->dma, sp->dmaNoRx, true);
+	if (frames && (sp->spcr1 & 0x0001))
+		omapMcBspPrvRxFrames(sp, frames);
 	
-	if (!(sp->spcr2 & 0x0001))
-		socDmaExternalReq(sp->dma, sp->dmaNoTx, true);
+	omapMcBspPrvUpdateStatus(sp);
 }
 
 static bool omapMcBspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* buf)
@@ -335,22 +356,19 @@ static bool omapMcBspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 			if (write)
 				return false;
 			else
-				val = sp->drr >> 16;
+				val = (sp->rxQ.numItems ? sp->rxQ.words[sp->rxQ.readPtr] : sp->drr) >> 16;
 			break;
 		
 		case 0x02 / 2:	//DRR1
 			if (write)
 				return false;
 			else {
-				val = sp->drr & 0xffff;
-				if (sp->rbrFull) {
-					sp->drr = omapMcBspPrvCompandExpand(sp, sp->rbr, sp->curRxWordBitLen);
-					sp->rbrFull = false;
+				if (sp->rxQ.numItems) {
+					sp->drr = omapMcBspPrvQueueGet(&sp->rxQ);
+					sp->spcr1 &=~ 4;	//room again
 				}
-				else
-					sp->drrFull = false;
-
-				omapMcBspPrvUpdateIrqs(sp);
+				val = sp->drr & 0xffff;
+				omapMcBspPrvUpdateStatus(sp);
 			}
 			break;
 		
@@ -364,9 +382,13 @@ static bool omapMcBspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 		case 0x06 / 2:	//DXR1
 			if (write) {
 				sp->dxr = (sp->dxr & 0xffff0000ul) + val;
-				sp->spcr2 |= 4;		//no longer empty
-				sp->spcr2 &=~ 2;	//no longer ready for more data
-				omapMcBspPrvUpdateIrqs(sp);
+				if (!(sp->spcr2 & 1))	//in reset
+					;
+				else if (sp->txQ.numItems < OMAP_McBSP_QUEUE)
+					omapMcBspPrvQueuePut(&sp->txQ, sp->dxr);
+				else					//overwrites what was last written
+					sp->txQ.words[(sp->txQ.readPtr + OMAP_McBSP_QUEUE - 1) % OMAP_McBSP_QUEUE] = sp->dxr;
+				omapMcBspPrvUpdateStatus(sp);
 			}
 			else
 				return false;
@@ -381,7 +403,6 @@ static bool omapMcBspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 					//todo
 				}
 				else if (!(sp->spcr2 & 0x80) && (val & 0x80)) {	//frame sync logic remove from reset
-					sp->rxState.state = OmapMcBspPipeWaitForFrame;
 					
 					//todo
 				}
@@ -391,15 +412,17 @@ static bool omapMcBspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 					//todo
 				}
 				else if (!(sp->spcr2 & 0x40) && (val & 0x40)) {	//sample rate generator remove from reset
-					sp->rxState.state = OmapMcBspPipeWaitForFrame;
 					
 					//todo
 				}
 				
+				if ((sp->spcr2 & 1) && !(val & 1))	//transmitter reset drops all that was queued
+					sp->txQ.numItems = 0;
+				
 				sp->spcr2 &= 0x0006;
 				sp->spcr2 = val & 0x03f9;
 				
-				omapMcBspPrvUpdateIrqs(sp);
+				omapMcBspPrvUpdateStatus(sp);
 			}
 			else
 				val = sp->spcr2;
@@ -409,15 +432,10 @@ static bool omapMcBspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 		
 			if (write) {
 				
-				if ((sp->spcr1 & 1) && !(val & 1))	//receiver reset
-					sp->rxState.state = OmapMcBspPipeInReset;
-				else if (!(sp->spcr1 & 1) && (val & 1)) {	//receiver remove from reset
-					sp->rxState.state = OmapMcBspPipeWaitForFrame;
+				if (!(sp->spcr1 & 1) && (val & 1)) {	//receiver remove from reset
 				
 					sp->spcr1 &=~ 0x000e;
-					sp->rbrFull = 0;
-					sp->drrFull = 0;
-					sp->rsrBits = 0;
+					sp->rxQ.numItems = 0;
 				}
 				sp->spcr1 &= 0x0006;
 				sp->spcr1 |= val & 0xf8b9;
@@ -425,7 +443,7 @@ static bool omapMcBspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 				if (val & 0x8000)
 					ERR("loopback not supported\n");
 				
-				omapMcBspPrvUpdateIrqs(sp);
+				omapMcBspPrvUpdateStatus(sp);
 			}
 			else
 				val = sp->spcr1;
@@ -587,9 +605,10 @@ static bool omapMcBspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t siz
 	return true;
 }
 
-struct OmapMcBsp* omapMcBspInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint8_t irqNoTx, uint8_t irqNoRx, uint8_t dmaNoTx, uint8_t dmaNoRx)
+struct OmapMcBsp* omapMcBspInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint8_t irqNoTx, uint8_t irqNoRx, uint8_t dmaNoTx, uint8_t dmaNoRx, uint32_t periodicHz)
 {
 	struct OmapMcBsp *sp = (struct OmapMcBsp*)malloc(sizeof(*sp));
+	uint_fast16_t i, j;
 	
 	if (!sp)
 		ERR("cannot alloc McBSP @ 0x%08lx", (unsigned long)base);
@@ -602,9 +621,18 @@ struct OmapMcBsp* omapMcBspInit(struct ArmMem *physMem, struct SocIc *ic, struct
 	sp->dmaNoTx = dmaNoTx;
 	sp->dmaNoRx = dmaNoRx;
 	sp->base = base;
+	sp->periodicHz = periodicHz;
+	
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 256; j++)
+			mExpand[i][j] = omapMcBspPrvCompandExpandCalc(i, j);
+	}
 	
 	if (!memRegionAdd(physMem, base, OMAP_McBSP_SIZE, omapMcBspPrvMemAccessF, sp))
 		ERR("cannot add McBSP @ 0x%08lx to MEM\n", (unsigned long)base);
 	
+	omapDmaSetBulkHandler(dma, dmaNoTx, true, omapMcBspPrvDmaTx, sp);
+	omapDmaSetBulkHandler(dma, dmaNoRx, false, omapMcBspPrvDmaRx, sp);
+	
 	return sp;
 }
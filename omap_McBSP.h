@@ -13,7 +13,7 @@
 struct OmapMcBsp;
 
 
-struct OmapMcBsp* omapMcBspInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint8_t irqNoTx, uint8_t irqNoRx, uint8_t dmaNoTx, uint8_t dmaNoRx);
+struct OmapMcBsp* omapMcBspInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint8_t irqNoTx, uint8_t irqNoRx, uint8_t dmaNoTx, uint8_t dmaNoRx, uint32_t periodicHz);	//how often omapMcBspPeriodic() is called
 void omapMcBspPeriodic(struct OmapMcBsp *sp);
 
 
@@ -32,7 +32,7 @@ static void omapRtcPrvIrqUpdate(struct OmapRtc *rtc, bool sendEvtIrqs)
 	bool tick = false;
 	
 	if (!(rtc->intr & 8) || !(rtc->sta & 0x40))
-		socIcInt(rtc->ic, OMAP_I_RTC_ALM, false);
+		omapIcInt(rtc->ic, OMAP_I_RTC_ALM, false);
 
 	if (sendEvtIrqs && (rtc->intr & 4)) {
 		switch (rtc->intr & 3){
@@ -55,8 +55,8 @@ static void omapRtcPrvIrqUpdate(struct OmapRtc *rtc, bool sendEvtIrqs)
 		}
 		if (tick) {
 			//edge
-			socIcInt(rtc->ic, OMAP_I_RTC_TICK, true);
-			socIcInt(rtc->ic, OMAP_I_RTC_TICK, false);
+			omapIcInt(rtc->ic, OMAP_I_RTC_TICK, true);
+			omapIcInt(rtc->ic, OMAP_I_RTC_TICK, false);
 		}
 	}
 }
@@ -350,7 +350,7 @@ void omapRtcPeriodic(struct OmapRtc *rtc)
 		rtc->sta |= 0x40;
 		
 		if (rtc->intr & 8)
-			socIcInt(rtc->ic, OMAP_I_RTC_ALM, true);
+			omapIcInt(rtc->ic, OMAP_I_RTC_ALM, true);
 	}
 	
 	omapRtcPrvIrqUpdate(rtc, true);
@@ -119,8 +119,8 @@ void omapTmrPeriodic(struct OmapTmr *tmr)
 			else
 				tmr->ctrl &=~ 1;
 			if (tmr->irqNo >= 0) {
-				socIcInt(tmr->ic, tmr->irqNo, true);		//edge triggered
-				socIcInt(tmr->ic, tmr->irqNo, false);
+				omapIcInt(tmr->ic, tmr->irqNo, true);		//edge triggered
+				omapIcInt(tmr->ic, tmr->irqNo, false);
 			}
 		}
 	}
@@ -23,6 +23,10 @@
 #define OMAP_UART3_BASE		0xFFFB9800UL		//supports IR
 
 
+struct SocUart* omapUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t baseAddr, uint8_t irq);
+void omapUartProcess(struct SocUart *uart);
+void omapUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void *userData);
+void omapUartSetBulk(struct SocUart *uart, bool bulk);
 
 
 #endif
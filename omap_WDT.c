@@ -136,8 +136,8 @@ void omapWdtPeriodic(struct OmapWdt *wdt)
 				else
 					wdt->ctrl &=~ 0x0080;
 				//edge triggered
-				socIcInt(wdt->ic, OMAP_I_WDT, true);
-				socIcInt(wdt->ic, OMAP_I_WDT, false);
+				omapIcInt(wdt->ic, OMAP_I_WDT, true);
+				omapIcInt(wdt->ic, OMAP_I_WDT, false);
 			}
 		}
 	}
@@ -52,13 +52,13 @@ static void socUwirePrvTransact(struct SocUwire *uw)
 	if (uw->sr5 & 0x02) {
 		if (bitsTx) {
 			//edge
-			socIcInt(uw->ic, OMAP_I_uWIRE_TX, true);
-			socIcInt(uw->ic, OMAP_I_uWIRE_TX, false);
+			omapIcInt(uw->ic, OMAP_I_uWIRE_TX, true);
+			omapIcInt(uw->ic, OMAP_I_uWIRE_TX, false);
 		}
 		if (bitsRx) {
 			//edge
-			socIcInt(uw->ic, OMAP_I_uWIRE_RX, true);
-			socIcInt(uw->ic, OMAP_I_uWIRE_RX, false);
+			omapIcInt(uw->ic, OMAP_I_uWIRE_RX, true);
+			omapIcInt(uw->ic, OMAP_I_uWIRE_RX, false);
 		}
 	}
 }
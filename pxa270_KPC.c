@@ -78,7 +78,7 @@ static void pxaKpcPrvIrqRecals(struct PxaKpc *kpc)
 	irq = irq || ((kpc->kpc & 0x00401800ul) == 0x00401800ul);
 	irq = irq || ((kpc->kpc & 0x00000023ul) == 0x00000023ul);
 	
-	socIcInt(kpc->ic, PXA_I_KEYPAD, irq);
+	pxaIcInt(kpc->ic, PXA_I_KEYPAD, irq);
 }
 
 static void pxaKpcPrvMatrixRecalc(struct PxaKpc *kpc, bool lastKeyChangeWasDown)
@@ -6,6 +6,11 @@
 #include "endian.h"
 #include "util.h"
 
+#ifdef __SSE2__
+	#include <emmintrin.h>
+	#include <tmmintrin.h>
+#endif
+
 union REG64 {
 	uint64_t v64;
 	int64_t s64;
@@ -21,6 +26,7 @@ struct Pxa270wmmx {
 	union REG64 wR[16];
 	uint32_t wCGR[4], wCASF;		//NZCV
 	uint8_t wCon, wCSSF;
+	bool hostSsse3;
 };
 
 
@@ -45,6 +51,224 @@ static void pxa270wmmxPrvSetFlagsForLogical64(struct Pxa270wmmx *wmmx, uint64_t
 	pxa270wmmxPrvControlRegsChanged(wmmx);
 }
 
+#ifdef __SSE2__
+
+	/*
+		Host vector versions of the hot packed ops. A register fits in the low half of an XMM register and flags for all
+		lanes come out of compare masks at once. Whatever these do not take on is left to the plain C below, which stays
+		the reference for what each op does (including its flags)
+	*/
+
+	static __m128i pxa270wmmxPrvSimdGet(struct Pxa270wmmx *wmmx, uint_fast8_t reg)
+	{
+		return _mm_loadl_epi64((const __m128i*)&wmmx->wR[reg]);
+	}
+
+	static void pxa270wmmxPrvSimdPut(struct Pxa270wmmx *wmmx, uint_fast8_t reg, __m128i val)
+	{
+		_mm_storel_epi64((__m128i*)&wmmx->wR[reg], val);
+		pxa270wmmxPrvDataRegsChanged(wmmx);
+	}
+
+	static __m128i pxa270wmmxPrvSimdAdd(__m128i a, __m128i b, uint_fast8_t sz)
+	{
+		return sz == 1 ? _mm_add_epi8(a, b) : (sz == 2 ? _mm_add_epi16(a, b) : _mm_add_epi32(a, b));
+	}
+
+	static __m128i pxa270wmmxPrvSimdSub(__m128i a, __m128i b, uint_fast8_t sz)
+	{
+		return sz == 1 ? _mm_sub_epi8(a, b) : (sz == 2 ? _mm_sub_epi16(a, b) : _mm_sub_epi32(a, b));
+	}
+
+	static __m128i pxa270wmmxPrvSimdCmpEq(__m128i a, __m128i b, uint_fast8_t sz)
+	{
+		return sz == 1 ? _mm_cmpeq_epi8(a, b) : (sz == 2 ? _mm_cmpeq_epi16(a, b) : _mm_cmpeq_epi32(a, b));
+	}
+
+	static __m128i pxa270wmmxPrvSimdCmpGt(__m128i a, __m128i b, uint_fast8_t sz, bool sgnd)
+	{
+		if (!sgnd) {		//flipping the top bit makes unsigned order signed
+			
+			__m128i bias = sz == 1 ? _mm_set1_epi8(0x80) : (sz == 2 ? _mm_set1_epi16(0x8000) : _mm_set1_epi32(0x80000000));
+			
+			a = _mm_xor_si128(a, bias);
+			b = _mm_xor_si128(b, bias);
+		}
+		return sz == 1 ? _mm_cmpgt_epi8(a, b) : (sz == 2 ? _mm_cmpgt_epi16(a, b) : _mm_cmpgt_epi32(a, b));
+	}
+
+	static __m128i pxa270wmmxPrvSimdNeg(__m128i v, uint_fast8_t sz)	//lanes with the top bit set become all ones
+	{
+		return pxa270wmmxPrvSimdCmpGt(_mm_setzero_si128(), v, sz, true);
+	}
+
+	//wCASF from per-lane masks. each lane's NZCV nibble sits at the top of that lane's share of the register
+	static uint32_t pxa270wmmxPrvSimdCasf(__m128i n, __m128i z, __m128i c, __m128i v, uint_fast8_t sz)
+	{
+		__m128i bitV = sz == 1 ? _mm_set1_epi8(0x01) : (sz == 2 ? _mm_set1_epi16(0x0010) : _mm_set1_epi32(0x1000)), t;
+		
+		t = _mm_or_si128(_mm_and_si128(n, _mm_slli_epi32(bitV, 3)), _mm_and_si128(z, _mm_slli_epi32(bitV, 2)));
+		t = _mm_or_si128(t, _mm_or_si128(_mm_and_si128(c, _mm_slli_epi32(bitV, 1)), _mm_and_si128(v, bitV)));
+		
+		switch (sz) {
+			case 1:		//two byte lanes' nibbles into one byte
+				t = _mm_and_si128(_mm_or_si128(t, _mm_srli_epi16(t, 4)), _mm_set1_epi16(0x00ff));
+				//fallthrough
+			case 2:
+				t = _mm_packus_epi16(t, t);
+				break;
+			
+			default:
+				t = _mm_shufflelo_epi16(t, _MM_SHUFFLE(3, 3, 2, 0));
+				break;
+		}
+		
+		return _mm_cvtsi128_si32(t);
+	}
+
+	//one wCSSF bit per lane, at the lane's lowest byte
+	static uint_fast8_t pxa270wmmxPrvSimdCssf(__m128i sat, uint_fast8_t sz)
+	{
+		return _mm_movemask_epi8(sat) & (sz == 1 ? 0xff : (sz == 2 ? 0x55 : 0x11));
+	}
+
+	static bool pxa270wmmxPrvSimdAddSub(struct Pxa270wmmx *wmmx, bool sub, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+	{
+		__m128i a = pxa270wmmxPrvSimdGet(wmmx, CRn), b = pxa270wmmxPrvSimdGet(wmmx, CRm), r, w, n, v, c, sat, zero = _mm_setzero_si128();
+		uint_fast8_t sz = 1 << (op1 >> 2);
+		
+		if (sz > 4)
+			return false;
+		
+		w = sub ? pxa270wmmxPrvSimdSub(a, b, sz) : pxa270wmmxPrvSimdAdd(a, b, sz);
+		
+		switch (op1 & 3) {
+			
+			case 0b00:		//modulo. C mirrors the sign of the unwrapped result, as in the scalar code
+				n = pxa270wmmxPrvSimdNeg(w, sz);
+				v = pxa270wmmxPrvSimdNeg(_mm_and_si128(sub ? _mm_xor_si128(a, b) : _mm_andnot_si128(_mm_xor_si128(a, b), _mm_set1_epi8(0xff)), _mm_xor_si128(a, w)), sz);
+				c = _mm_xor_si128(n, v);
+				if (sub)
+					c = _mm_andnot_si128(c, _mm_set1_epi8(0xff));
+				wmmx->wCASF = pxa270wmmxPrvSimdCasf(n, pxa270wmmxPrvSimdCmpEq(w, zero, sz), c, v, sz);
+				r = w;
+				break;
+			
+			case 0b11:		//signed saturation. SSE2 has it for bytes and halfwords only
+				if (sz == 1)
+					r = sub ? _mm_subs_epi8(a, b) : _mm_adds_epi8(a, b);
+				else if (sz == 2)
+					r = sub ? _mm_subs_epi16(a, b) : _mm_adds_epi16(a, b);
+				else
+					return false;
+				
+				sat = _mm_andnot_si128(pxa270wmmxPrvSimdCmpEq(r, w, sz), _mm_set1_epi8(0xff));
+				n = pxa270wmmxPrvSimdNeg(r, sz);
+				c = _mm_andnot_si128(sat, sub ? _mm_andnot_si128(n, _mm_set1_epi8(0xff)) : n);
+				wmmx->wCASF = pxa270wmmxPrvSimdCasf(n, pxa270wmmxPrvSimdCmpEq(r, zero, sz), c, zero, sz);
+				wmmx->wCSSF |= pxa270wmmxPrvSimdCssf(sat, sz);
+				break;
+			
+			default:
+				return false;
+		}
+		
+		pxa270wmmxPrvSimdPut(wmmx, CRd, r);
+		pxa270wmmxPrvControlRegsChanged(wmmx);
+		return true;
+	}
+
+	static bool pxa270wmmxPrvSimdCompare(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+	{
+		__m128i a = pxa270wmmxPrvSimdGet(wmmx, CRn), b = pxa270wmmxPrvSimdGet(wmmx, CRm), r, zero = _mm_setzero_si128();
+		uint_fast8_t sz = 1 << (op1 >> 2);
+		
+		if (sz > 4 || (op1 & 3) == 0b10)
+			return false;
+		
+		r = (op1 & 3) ? pxa270wmmxPrvSimdCmpGt(a, b, sz, (op1 & 3) == 0b11) : pxa270wmmxPrvSimdCmpEq(a, b, sz);
+		wmmx->wCASF = pxa270wmmxPrvSimdCasf(r, _mm_andnot_si128(r, _mm_set1_epi8(0xff)), zero, zero, sz);
+		pxa270wmmxPrvSimdPut(wmmx, CRd, r);
+		pxa270wmmxPrvControlRegsChanged(wmmx);
+		return true;
+	}
+
+	static bool pxa270wmmxPrvSimdMinMax(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+	{
+		__m128i a = pxa270wmmxPrvSimdGet(wmmx, CRn), b = pxa270wmmxPrvSimdGet(wmmx, CRm), aWins;
+		uint_fast8_t sz = 1 << (op1 >> 2);
+		
+		if (sz > 4)
+			return false;
+		
+		aWins = pxa270wmmxPrvSimdCmpGt(a, b, sz, !!(op1 & 2));
+		if (op1 & 1)		//min: on a tie either will do
+			aWins = _mm_andnot_si128(aWins, _mm_set1_epi8(0xff));
+		pxa270wmmxPrvSimdPut(wmmx, CRd, _mm_or_si128(_mm_and_si128(aWins, a), _mm_andnot_si128(aWins, b)));
+		return true;
+	}
+
+	static bool pxa270wmmxPrvSimdAverage(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+	{
+		__m128i a = pxa270wmmxPrvSimdGet(wmmx, CRn), b = pxa270wmmxPrvSimdGet(wmmx, CRm), r, zero = _mm_setzero_si128();
+		bool half = !!(op1 & 4);
+		
+		r = half ? _mm_avg_epu16(a, b) : _mm_avg_epu8(a, b);		//these always round up
+		if (!(op1 & 1))
+			r = half ? _mm_sub_epi16(r, _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi16(1))) : _mm_sub_epi8(r, _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+		
+		wmmx->wCASF = pxa270wmmxPrvSimdCasf(zero, pxa270wmmxPrvSimdCmpEq(r, zero, half ? 2 : 1), zero, zero, half ? 2 : 1);
+		pxa270wmmxPrvSimdPut(wmmx, CRd, r);
+		pxa270wmmxPrvControlRegsChanged(wmmx);
+		return true;
+	}
+
+	static bool pxa270wmmxPrvSimdMultiply(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+	{
+		__m128i a = pxa270wmmxPrvSimdGet(wmmx, CRn), b = pxa270wmmxPrvSimdGet(wmmx, CRm), r;
+		
+		switch (op1) {
+			case 0b0000:	//WMULUL
+			case 0b0010:	//WMULSL
+				r = _mm_mullo_epi16(a, b);
+				break;
+			
+			case 0b0001:	//WMULUM
+				r = _mm_mulhi_epu16(a, b);
+				break;
+			
+			case 0b0011:	//WMULSM
+				r = _mm_mulhi_epi16(a, b);
+				break;
+			
+			case 0b1010:	//WMADDS
+				r = _mm_madd_epi16(a, b);
+				break;
+			
+			default:
+				return false;
+		}
+		
+		pxa270wmmxPrvSimdPut(wmmx, CRd, r);
+		return true;
+	}
+
+	//only called once the host has been seen to have SSSE3, so it does not need it enabled for the whole build
+	static __attribute__((target("ssse3"))) void pxa270wmmxPrvSimdShuffle(struct Pxa270wmmx *wmmx, uint_fast8_t which, uint_fast8_t CRd, uint_fast8_t CRn)
+	{
+		__m128i r, zero = _mm_setzero_si128(), ctl;
+		
+		//each halfword lane picks source bytes 2 * sel and 2 * sel + 1
+		ctl = _mm_set_epi16(0, 0, 0, 0, ((which >> 6) & 3) * 0x202 + 0x100, ((which >> 4) & 3) * 0x202 + 0x100, ((which >> 2) & 3) * 0x202 + 0x100, (which & 3) * 0x202 + 0x100);
+		r = _mm_shuffle_epi8(pxa270wmmxPrvSimdGet(wmmx, CRn), ctl);
+		
+		wmmx->wCASF = pxa270wmmxPrvSimdCasf(pxa270wmmxPrvSimdNeg(r, 2), pxa270wmmxPrvSimdCmpEq(r, zero, 2), zero, zero, 2);
+		pxa270wmmxPrvSimdPut(wmmx, CRd, r);
+		pxa270wmmxPrvControlRegsChanged(wmmx);
+	}
+
+#endif
+
 static void pxa270wmmxPrvAlign(struct Pxa270wmmx *wmmx, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm, uint_fast8_t by)
 {
 	union REG64 ret;
@@ -64,6 +288,11 @@ static bool pxa270wmmxPrvDataProcessingMisc(struct Pxa270wmmx *wmmx, uint_fast8_
 	uint_fast16_t tf16;
 	uint64_t tmp;
 	
+#ifdef __SSE2__
+	if ((op1 & 0b1010) == 0b1000)
+		return pxa270wmmxPrvSimdAverage(wmmx, op1, CRd, CRn, CRm);
+#endif
+	
 	switch (op1) {
 		case 0b0000:		//WOR
 			wmmx->wR[CRd].v64 = tmp = wmmx->wR[CRn].v64 | wmmx->wR[CRm].v64;
@@ -400,6 +629,11 @@ static bool pxa270wmmxPrvDataProcessingCompare(struct Pxa270wmmx *wmmx, uint_fas
 	uint_fast16_t tf16;
 	uint_fast32_t tf32;
 	
+#ifdef __SSE2__
+	if (pxa270wmmxPrvSimdCompare(wmmx, op1, CRd, CRn, CRm))
+		return true;
+#endif
+	
 	switch (op1) {
 		
 		case 0b0000:	//WCMPEQ.b
@@ -857,6 +1091,11 @@ static bool pxa270wmmxPrvDataProcessingMultiply(struct Pxa270wmmx *wmmx, uint_fa
 	uint64_t sum = wmmx->wR[CRd].v64;
 	uint_fast8_t i;
 	
+#ifdef __SSE2__
+	if (pxa270wmmxPrvSimdMultiply(wmmx, op1, CRd, CRn, CRm))
+		return true;
+#endif
+	
 	switch (op1) {
 		
 		case 0b0000:	//WMULUL		//When L is specified the U and S qualifiers produce the same result
@@ -971,6 +1210,11 @@ static bool pxa270wmmxPrvDataProcessingMinMax(struct Pxa270wmmx *wmmx, uint_fast
 {
 	uint_fast8_t i;
 	
+#ifdef __SSE2__
+	if (pxa270wmmxPrvSimdMinMax(wmmx, op1, CRd, CRn, CRm))
+		return true;
+#endif
+	
 	switch (op1) {
 		
 		case 0b0000:	//WMAXUB
@@ -1091,6 +1335,13 @@ static bool pxa270wmmxPrvDataProcessingShuffle(struct Pxa270wmmx *wmmx, uint_fas
 	uint_fast16_t tf16;
 	union REG64 ret;
 	
+#ifdef __SSE2__
+	if (wmmx->hostSsse3) {
+		pxa270wmmxPrvSimdShuffle(wmmx, which, CRd, CRn);
+		return true;
+	}
+#endif
+	
 	wmmx->wCASF = 0;
 	for (i = 0; i < 4; i++, which >>= 2) {
 		
@@ -1113,6 +1364,11 @@ static bool pxa270wmmxPrvDataProcessingAddition(struct Pxa270wmmx *wmmx, uint_fa
 	int_fast32_t sf32;
 	int_fast64_t sf64;
 	
+#ifdef __SSE2__
+	if (pxa270wmmxPrvSimdAddSub(wmmx, false, op1, CRd, CRn, CRm))
+		return true;
+#endif
+	
 	wmmx->wCASF = 0;
 	switch (op1) {
 		
@@ -1341,6 +1597,11 @@ static bool pxa270wmmxPrvDataProcessingSubtraction(struct Pxa270wmmx *wmmx, uint
 	int_fast32_t sf32;
 	int_fast64_t sf64;
 	
+#ifdef __SSE2__
+	if (pxa270wmmxPrvSimdAddSub(wmmx, true, op1, CRd, CRn, CRm))
+		return true;
+#endif
+	
 	wmmx->wCASF = 0;
 	switch (op1) {
 		
@@ -1634,6 +1895,45 @@ static bool pxa270wmmxPrvDataProcessing1(struct ArmCpu *cpu, void* userData, boo
 	}
 }
 
+static bool pxa270wmmxPrvDataProcessingShift0(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+{
+	return pxa270wmmxPrvDataProcessingShift(wmmx, false, op1, CRd, CRn, CRm);
+}
+
+static bool pxa270wmmxPrvDataProcessingShift1(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+{
+	return pxa270wmmxPrvDataProcessingShift(wmmx, true, op1, CRd, CRn, CRm);
+}
+
+static bool pxa270wmmxPrvDataProcessingUnpackLo(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+{
+	return pxa270wmmxPrvDataProcessingUnpack(wmmx, false, op1, CRd, CRn, CRm);
+}
+
+static bool pxa270wmmxPrvDataProcessingUnpackHi(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+{
+	return pxa270wmmxPrvDataProcessingUnpack(wmmx, true, op1, CRd, CRn, CRm);
+}
+
+//the same dispatch as pxa270wmmxPrvDataProcessing0/1, indexed by (cp1 << 3) + op2
+static bool (* const mDataProcessingOps[16])(struct Pxa270wmmx *wmmx, uint_fast8_t op1, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm) = {
+	[0b0000] = pxa270wmmxPrvDataProcessingMisc,
+	[0b0001] = pxa270wmmxPrvDataProcessingAlign,
+	[0b0010] = pxa270wmmxPrvDataProcessingShift0,
+	[0b0011] = pxa270wmmxPrvDataProcessingCompare,
+	[0b0100] = pxa270wmmxPrvDataProcessingPack,
+	[0b0110] = pxa270wmmxPrvDataProcessingUnpackLo,
+	[0b0111] = pxa270wmmxPrvDataProcessingUnpackHi,
+	[0b1000] = pxa270wmmxPrvDataProcessingMultiply,
+	[0b1001] = pxa270wmmxPrvDataProcessingDifference,
+	[0b1010] = pxa270wmmxPrvDataProcessingShift1,
+	[0b1011] = pxa270wmmxPrvDataProcessingMinMax,
+	[0b1100] = pxa270wmmxPrvDataProcessingAddition,
+	[0b1101] = pxa270wmmxPrvDataProcessingSubtraction,
+	[0b1110] = pxa270wmmxPrvDataProcessingAccumulate,
+	[0b1111] = pxa270wmmxPrvDataProcessingShuffle,
+};
+
 static void pxa270wmmxPrvSetCoreReg(struct ArmCpu *cpu, uint_fast8_t reg, uint32_t val)
 {
 	if (reg == 15) {
@@ -2197,6 +2497,53 @@ static bool pxa270wmmxPrvMemAccess1(struct ArmCpu *cpu, void* userData, bool two
 	return pxa270wmmxPrvMemAccess((struct Pxa270wmmx*)userData, true, cpu, two, N, store, CRd, addrReg, addBefore, addAfter, option);
 }
 
+static bool pxa270wmmxPrvOpDataProcessing(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	return mDataProcessingOps[arg]((struct Pxa270wmmx*)userData, ARM_CP_INSTR_CDP_OP1(instr), ARM_CP_INSTR_RD(instr), ARM_CP_INSTR_CRN(instr), ARM_CP_INSTR_CRM(instr));
+}
+
+static bool pxa270wmmxPrvOpTmcrTmrc(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	return pxa270wmmxPrvRegXferTmcrTmrc((struct Pxa270wmmx*)userData, cpu, ARM_CP_INSTR_MRC(instr), 0, ARM_CP_INSTR_RD(instr), ARM_CP_INSTR_CRN(instr));
+}
+
+static bool pxa270wmmxPrvOpTmia(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	return pxa270wmmxPrvRegXferTmia((struct Pxa270wmmx*)userData, cpu, ARM_CP_INSTR_CRN(instr), arg, ARM_CP_INSTR_RD(instr), ARM_CP_INSTR_CRM(instr));
+}
+
+//inner loops are mostly CDPs and control register moves. resolve those once rather than per execution
+static ArmCoprocOpF pxa270wmmxPrvDecode(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t *argP)
+{
+	bool cp1 = !!(instr & 0x00000100UL), read = ARM_CP_INSTR_MRC(instr);
+	uint_fast8_t op2 = ARM_CP_INSTR_OP2(instr);
+	
+	if (ARM_CP_INSTR_TWO(instr))
+		return NULL;
+	
+	if (!ARM_CP_INSTR_XFER(instr)) {
+		
+		*argP = (cp1 ? 8 : 0) + op2;
+		return mDataProcessingOps[*argP] ? pxa270wmmxPrvOpDataProcessing : NULL;
+	}
+	
+	switch (ARM_CP_INSTR_XFER_OP1(instr)) {
+		case 0b000:
+			if (op2 || !cp1 || ARM_CP_INSTR_CRM(instr) || (ARM_CP_INSTR_CRN(instr) & 4))
+				return NULL;
+			return pxa270wmmxPrvOpTmcrTmrc;
+		
+		case 0b001:
+			if (read)
+				return NULL;
+			*argP = op2 + (cp1 ? 8 : 0);
+			return pxa270wmmxPrvOpTmia;
+		
+		default:
+			return NULL;
+	}
+}
+
 static bool pxa270wmmxPrvTwoReg0(struct ArmCpu *cpu, void* userData, bool MRRC, uint8_t op, uint8_t Rd, uint8_t Rn, uint8_t CRm)
 {
 	return pxa270wmmxPrvTwoReg((struct Pxa270wmmx*)userData, false, cpu, MRRC, op, Rd, Rn, CRm);
@@ -2215,6 +2562,7 @@ struct Pxa270wmmx* pxa270wmmxInit(struct ArmCpu* cpu)
 		.dataProcessing = pxa270wmmxPrvDataProcessing0,
 		.memAccess = pxa270wmmxPrvMemAccess0,
 		.twoRegF = pxa270wmmxPrvTwoReg0,
+		.decode = pxa270wmmxPrvDecode,
 		.userData = wmmx,
 	};
 	struct ArmCoprocessor cp1 = {
@@ -2222,6 +2570,7 @@ struct Pxa270wmmx* pxa270wmmxInit(struct ArmCpu* cpu)
 		.dataProcessing = pxa270wmmxPrvDataProcessing1,
 		.memAccess = pxa270wmmxPrvMemAccess1,
 		.twoRegF = pxa270wmmxPrvTwoReg1,
+		.decode = pxa270wmmxPrvDecode,
 		.userData = wmmx,
 	};
 	
@@ -2229,6 +2578,9 @@ struct Pxa270wmmx* pxa270wmmxInit(struct ArmCpu* cpu)
 		ERR("cannot alloc WMMX");
 	
 	memset(wmmx, 0, sizeof (*wmmx));
+#ifdef __SSE2__
+	wmmx->hostSsse3 = __builtin_cpu_supports("ssse3");
+#endif
 	
 	cpuCoprocessorRegister(cpu, 0, &cp0);
 	cpuCoprocessorRegister(cpu, 1, &cp1);
@@ -5,6 +5,7 @@
 #include "soc_AC97.h"
 #include <string.h>
 #include <stdlib.h>
+#include "endian.h"
 #include "util.h"
 #include "mem.h"
 
@@ -23,8 +24,13 @@ struct AC97Fifo {
 	uint32_t data[16];
 	
 	uint8_t *icr, *isr;
+	struct SocAC97 *ac97;
 	
 	uint32_t lastReadSample;
+	
+	//the codec's sample clock on this slot: where it last moved samples and the fraction of a sample left over
+	uint64_t clkTick;
+	uint32_t clkRem;
 };
 
 struct Ac97CodecStruct {
@@ -48,6 +54,9 @@ struct SocAC97 {
 	uint8_t pocr, picr, mccr, posr, pisr, mcsr, car, mocr, mosr, micr, misr;
 	uint32_t gcr, gsr, pcdr;
 	
+	uint64_t ticks;
+	uint32_t ticksPerSec;
+	
 	//prmary audio is PCM
 	//secondary is mic
 	//primary modem is modem
@@ -68,7 +77,7 @@ static void socAC97prvIrqUpdate(struct SocAC97 *ac97)
 	irq = irq || (ac97->gcr & ac97->gsr & 0x300);
 	irq = irq || (ac97->gsr & 0x000c0000ul);
 	
-	socIcInt(ac97->ic, PXA_I_AC97, irq);
+	pxaIcInt(ac97->ic, PXA_I_AC97, irq);
 }
 
 static void socAC97PrvFifoDmaUpdate(struct SocAC97 *ac97, struct AC97Fifo *fifo)
@@ -83,7 +92,7 @@ static void socAC97PrvFifoDmaUpdate(struct SocAC97 *ac97, struct AC97Fifo *fifo)
 		*fifo->isr &=~ 4;
 	
 	if (fifo->dmaChannelNum)
-		socDmaExternalReq(ac97->dma, fifo->dmaChannelNum, fifoReadyForRead);
+		pxaDmaExternalReq(ac97->dma, fifo->dmaChannelNum, fifoReadyForRead);
 }
 
 static bool socAC97PrvFifoAdd(struct SocAC97 *ac97, struct AC97Fifo *fifo, uint32_t val)
@@ -137,6 +146,54 @@ static bool socAC97PrvFifoGet(struct SocAC97 *ac97, struct AC97Fifo *fifo, uint3
 	return ret;
 }
 
+static uint32_t socAC97PrvDmaTx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct AC97Fifo *fifo = (struct AC97Fifo*)userData;
+	uint32_t cap = sizeof(fifo->data) / sizeof(*fifo->data), done;
+	const uint32_t *src = (const uint32_t*)buf;
+	
+	if (itemSz != 4)
+		return 0;
+	
+	for (done = 0; done < len / 4 && fifo->numItems < cap; done++)
+		fifo->data[(fifo->readPtr + fifo->numItems++) % cap] = le32toh(src[done]);
+	
+	if (done)
+		socAC97PrvFifoDmaUpdate(fifo->ac97, fifo);
+	
+	return done * 4;
+}
+
+static uint32_t socAC97PrvDmaRx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct AC97Fifo *fifo = (struct AC97Fifo*)userData;
+	uint32_t cap = sizeof(fifo->data) / sizeof(*fifo->data), done;
+	uint32_t *dst = (uint32_t*)buf;
+	
+	if (itemSz != 4)
+		return 0;
+	
+	for (done = 0; done < len / 4 && fifo->numItems; done++) {
+		
+		fifo->lastReadSample = fifo->data[fifo->readPtr];
+		dst[done] = htole32(fifo->lastReadSample);
+		if (++fifo->readPtr == cap)
+			fifo->readPtr = 0;
+		fifo->numItems--;
+	}
+	
+	if (done)
+		socAC97PrvFifoDmaUpdate(fifo->ac97, fifo);
+	
+	return done * 4;
+}
+
+static void socAC97PrvFifoDmaInit(struct SocAC97 *ac97, struct AC97Fifo *fifo)
+{
+	fifo->ac97 = ac97;
+	pxaDmaSetBulkHandler(ac97->dma, fifo->dmaChannelNum, !fifo->isRxFifo, fifo->isRxFifo ? socAC97PrvDmaRx : socAC97PrvDmaTx, fifo);
+}
+
 static bool socAC97PrvFifoW(struct SocAC97 *ac97, struct Ac97CodecStruct *codec, uint32_t val)
 {
 	return socAC97PrvFifoAdd(ac97, &codec->txFifo, val);
@@ -370,7 +427,7 @@ static bool socAC97PrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 	return true;
 }
 
-struct SocAC97* socAC97Init(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma)
+struct SocAC97* socAC97Init(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t periodicHz)
 {
 	struct SocAC97 *ac97 = (struct SocAC97*)malloc(sizeof(*ac97));
 	
@@ -381,6 +438,7 @@ struct SocAC97* socAC97Init(struct ArmMem *physMem, struct SocIc *ic, struct Soc
 	
 	ac97->ic = ic;
 	ac97->dma = dma;
+	ac97->ticksPerSec = periodicHz;
 	ac97->gsr = 0x100;	//primary codec is ready
 	
 	ac97->primaryAudio.txFifo.dmaChannelNum = DMA_CMR_AC97_AUDIO_TX;
@@ -406,6 +464,12 @@ struct SocAC97* socAC97Init(struct ArmMem *physMem, struct SocIc *ic, struct Soc
 	ac97->primaryModem.rxFifo.isRxFifo = true;
 	ac97->primaryModem.rxFifo.icr = &ac97->micr;
 	ac97->primaryModem.rxFifo.isr = &ac97->misr;
+	
+	socAC97PrvFifoDmaInit(ac97, &ac97->primaryAudio.txFifo);
+	socAC97PrvFifoDmaInit(ac97, &ac97->primaryAudio.rxFifo);
+	socAC97PrvFifoDmaInit(ac97, &ac97->secondaryAudio.rxFifo);
+	socAC97PrvFifoDmaInit(ac97, &ac97->primaryModem.txFifo);
+	socAC97PrvFifoDmaInit(ac97, &ac97->primaryModem.rxFifo);
 		
 	if (!memRegionAdd(physMem, PXA_AC97_BASE, PXA_AC97_SIZE, socAC97PrvMemAccessF, ac97))
 		ERR("cannot add AC97 to MEM\n");
@@ -415,7 +479,8 @@ struct SocAC97* socAC97Init(struct ArmMem *physMem, struct SocIc *ic, struct Soc
 
 void socAC97Periodic(struct SocAC97 *ac97)
 {
-	//nothing - codecs do their own work getting data to and from us :)
+	//codecs do their own work getting data to and from us, we just keep time for them
+	ac97->ticks++;
 }
 
 static struct Ac97CodecStruct* socAC97prvCodecPtrGet(struct SocAC97 *ac97, enum Ac97Codec which)
@@ -463,3 +528,62 @@ void socAC97clientClientHaveData(struct SocAC97 *ac97, enum Ac97Codec which, uin
 	
 	(void)socAC97PrvFifoAdd(ac97, &cd->rxFifo, data);
 }
+
+//samples due at "rate" on this fifo since the codec last moved any. when it falls far behind, the backlog is dropped
+static uint32_t socAC97PrvSamplesDue(struct SocAC97 *ac97, struct AC97Fifo *fifo, uint32_t rate, uint32_t max)
+{
+	uint64_t t = (ac97->ticks - fifo->clkTick) * rate + fifo->clkRem;
+	uint64_t due = t / ac97->ticksPerSec;
+	
+	fifo->clkTick = ac97->ticks;
+	fifo->clkRem = t % ac97->ticksPerSec;
+	
+	return due < max ? due : max;
+}
+
+uint32_t socAC97clientTakeSamples(struct SocAC97 *ac97, enum Ac97Codec which, uint32_t rate, uint32_t *dst, uint32_t max)
+{
+	struct AC97Fifo *fifo = &socAC97prvCodecPtrGet(ac97, which)->txFifo;
+	uint32_t cap = sizeof(fifo->data) / sizeof(*fifo->data), due, done;
+	
+	due = socAC97PrvSamplesDue(ac97, fifo, rate, max);
+	if (!due)
+		return 0;
+	
+	for (done = 0; done < due && fifo->numItems; done++) {
+		
+		dst[done] = fifo->data[fifo->readPtr];
+		if (++fifo->readPtr == cap)
+			fifo->readPtr = 0;
+		fifo->numItems--;
+	}
+	
+	if (done)
+		fifo->lastReadSample = dst[done - 1];
+	if (done != due)
+		*fifo->isr |= 0x10;		//underrun
+	
+	socAC97PrvFifoDmaUpdate(ac97, fifo);
+	
+	return done;
+}
+
+uint32_t socAC97clientGiveSamples(struct SocAC97 *ac97, enum Ac97Codec which, uint32_t rate, const uint32_t *src, uint32_t max)
+{
+	struct AC97Fifo *fifo = &socAC97prvCodecPtrGet(ac97, which)->rxFifo;
+	uint32_t cap = sizeof(fifo->data) / sizeof(*fifo->data), due, done;
+	
+	due = socAC97PrvSamplesDue(ac97, fifo, rate, max);
+	if (!due)
+		return 0;
+	
+	for (done = 0; done < due && fifo->numItems < cap; done++)
+		fifo->data[(fifo->readPtr + fifo->numItems++) % cap] = src[done];
+	
+	if (done != due)
+		*fifo->isr |= 0x10;		//overrun
+	
+	socAC97PrvFifoDmaUpdate(ac97, fifo);
+	
+	return done;
+}
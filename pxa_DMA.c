@@ -19,6 +19,8 @@
 #define REG_CR		3	//command
 #define REG_CSR		4	//status
 
+#define PXA_DMA_MAX_BULK	24
+
 
 
 struct PxaDmaChannel {
@@ -34,10 +36,22 @@ struct PxaDmaChannel {
 	uint8_t dcmdAddrWritten : 1;
 };
 
+struct PxaDmaBulk {
+	
+	SocDmaBulkF f;
+	void *userData;
+	uint8_t reqNum;
+	bool toPeriph;
+};
+
 struct SocDma {
 
 	struct SocIc *ic;
 	struct ArmMem *mem;
+	struct ArmRam *ram;
+	
+	struct PxaDmaBulk bulk[PXA_DMA_MAX_BULK];
+	uint8_t numBulk;
 	
 	uint32_t dalgn, dpcsr;
 	uint32_t DINT;
@@ -71,7 +85,7 @@ static void socDmaPrvChannelIrqRecalc(struct SocDma* dma, uint_fast8_t channel)
 		dma->DINT |= 1 << channel;
 	}
 		
-	socIcInt(dma->ic, PXA_I_DMA, !!dma->DINT);
+	pxaIcInt(dma->ic, PXA_I_DMA, !!dma->DINT);
 }
 
 static void socDmaPrvChannelStop(struct SocDma* dma, struct PxaDmaChannel *ch)
@@ -222,6 +236,86 @@ static bool socDmaPrvChannelDoBurst(struct SocDma* dma, uint_fast8_t channel)		/
 	return socDmaPrvChannelCheckForEnd(dma, channel);
 }
 
+//an unflow-controlled copy with both sides incrementing through RAM is one memmove per descriptor
+//an overlapping copy upwards replicates item by item on the real engine, so that one is copied forward
+static bool socDmaPrvChannelDoCopy(struct SocDma* dma, uint_fast8_t channel, bool *irqUpdateP)	//false if not possible, do it the slow way
+{
+	struct PxaDmaChannel *ch = &dma->channels[channel];
+	uint32_t i, each, len = ch->CR & 0x1fff, width = (ch->CR >> 14) & 3;
+	uint8_t *src, *dst;
+	
+	if ((ch->CR & 0xf0000000ul) != 0xc0000000ul || !len || !width || len % (each = 1 << (width - 1)))
+		return false;
+	
+	src = (uint8_t*)ramGetPtr(dma->ram, ch->SAR, len);
+	dst = (uint8_t*)ramGetPtr(dma->ram, ch->TAR, len);
+	if (!src || !dst)
+		return false;
+	
+	if (dst <= src || dst >= src + len)
+		memmove(dst, src, len);
+	else for (i = 0; i < len; i += each)
+		memmove(dst + i, src + i, each);
+	ramDirtyMark(dma->ram, ch->TAR, len);
+	ch->SAR += len;
+	ch->TAR += len;
+	ch->CR -= len;
+	
+	if (socDmaPrvChannelCheckForEnd(dma, channel))
+		*irqUpdateP = true;
+	
+	return true;
+}
+
+//a flow-controlled channel between RAM and a peripheral with a bulk handler moves as much as descriptors and the peripheral allow in one go
+static bool socDmaPrvChannelDoBulk(struct SocDma* dma, uint_fast8_t channel, bool *irqUpdateP)	//false if nothing moved, do it the slow way
+{
+	struct PxaDmaChannel *ch = &dma->channels[channel];
+	const struct PxaDmaBulk *bulk = NULL;
+	uint32_t i, len, done, memAddr;
+	bool moved = false;
+	uint8_t *ptr;
+	
+	for (i = 0; i < dma->numBulk && !bulk; i++) {
+		if (dma->CMR[dma->bulk[i].reqNum] == (0x80 | channel))
+			bulk = &dma->bulk[i];
+	}
+	if (!bulk)
+		return false;
+	
+	do {
+		
+		//memory side must increment, peripheral side must not and must be the one flow-controlling
+		if ((ch->CR & 0xf0000000ul) != (bulk->toPeriph ? 0x90000000ul : 0x60000000ul) || !((ch->CR >> 14) & 3))
+			break;
+		
+		len = ch->CR & 0x1fff;
+		memAddr = bulk->toPeriph ? ch->SAR : ch->TAR;
+		ptr = (uint8_t*)ramGetPtr(dma->ram, memAddr, len);
+		if (!ptr)
+			break;
+		
+		done = bulk->f(bulk->userData, ptr, len, 1 << (((ch->CR >> 14) & 3) - 1));
+		if (!done)
+			break;
+		
+		if (bulk->toPeriph)
+			ch->SAR += done;
+		else {
+			ramDirtyMark(dma->ram, memAddr, done);
+			ch->TAR += done;
+		}
+		ch->CR -= done;
+		moved = true;
+		
+		if (socDmaPrvChannelCheckForEnd(dma, channel))
+			*irqUpdateP = true;
+		
+	} while (done == len && socDmaPrvChannelRunning(dma, ch));
+	
+	return moved;
+}
+
 static void socDmaPrvChannelActIfNeeded(struct SocDma* dma, uint_fast8_t channel)
 {
 	bool irqUpdate = false, doWork = false, justOne = true;
@@ -248,10 +342,13 @@ static void socDmaPrvChannelActIfNeeded(struct SocDma* dma, uint_fast8_t channel
 			justOne = false;			//do it all
 		}
 		
-		if (doWork) {
+		if (doWork && !(justOne && socDmaPrvChannelDoBulk(dma, channel, &irqUpdate))) {
 			
 			do {
 				
+				if (!justOne && socDmaPrvChannelDoCopy(dma, channel, &irqUpdate))
+					continue;
+				
 				if (socDmaPrvChannelDoBurst(dma, channel))
 					irqUpdate = true;
 				
@@ -385,7 +482,7 @@ static bool socDmaPrvChannelRegRead(struct SocDma* dma, uint_fast8_t channel, ui
 	return true;
 }
 
-void socDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested)
+void pxaDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested)
 {
 	uint32_t cfg = dma->CMR[chNum];
 	
@@ -402,7 +499,21 @@ void socDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested)
 	}
 }
 
-void socDmaPeriodic(struct SocDma* dma)
+void pxaDmaSetBulkHandler(struct SocDma* dma, uint_fast8_t chNum, bool toPeriph, SocDmaBulkF f, void *userData)
+{
+	struct PxaDmaBulk *bulk;
+	
+	if (dma->numBulk == PXA_DMA_MAX_BULK)
+		ERR("too many DMA bulk handlers\n");
+	
+	bulk = &dma->bulk[dma->numBulk++];
+	bulk->f = f;
+	bulk->userData = userData;
+	bulk->reqNum = chNum;
+	bulk->toPeriph = toPeriph;
+}
+
+void pxaDmaPeriodic(struct SocDma* dma)
 {
 	uint32_t i;
 	
@@ -540,7 +651,7 @@ static bool socDmaPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 }
 
 
-struct SocDma* socDmaInit(struct ArmMem *physMem, struct SocIc *ic)
+struct SocDma* pxaDmaInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic)
 {
 	struct SocDma *dma = (struct SocDma*)malloc(sizeof(*dma));
 	uint_fast8_t i;
@@ -551,6 +662,7 @@ struct SocDma* socDmaInit(struct ArmMem *physMem, struct SocIc *ic)
 	memset(dma, 0, sizeof (*dma));
 	dma->ic = ic;
 	dma->mem = physMem;
+	dma->ram = ram;
 	
 	for (i = 0; i < 32; i++)
 		dma->channels[i].CSR = 8;	//stopped or uninitialized
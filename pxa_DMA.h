@@ -102,6 +102,10 @@
 #define DMA_CMR_DREQ_2			74
 
 
+struct SocDma* pxaDmaInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic);
+void pxaDmaPeriodic(struct SocDma* dma);
+void pxaDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested);
+void pxaDmaSetBulkHandler(struct SocDma* dma, uint_fast8_t chNum, bool toPeriph, SocDmaBulkF f, void *userData);
 
 
 #endif
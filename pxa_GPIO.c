@@ -1,7 +1,7 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
 #include "pxa_IC.h"
-#include "soc_GPIO.h"
+#include "pxa_GPIO.h"
 #include <string.h>
 #include <stdlib.h>
 #include "util.h"
@@ -99,9 +99,9 @@ static void socGpioPrvRecalcValues(struct SocGpio *gpio, uint_fast8_t which)
 
 static void socGpioPrvRecalcIntrs(struct SocGpio *gpio)
 {	
-	socIcInt(gpio->ic, PXA_I_GPIO_all, gpio->detStatus[3] || gpio->detStatus[2] || gpio->detStatus[1] || (gpio->detStatus[0] &~ 3));
-	socIcInt(gpio->ic, PXA_I_GPIO_1, (gpio->detStatus[0] & 2) != 0);
-	socIcInt(gpio->ic, PXA_I_GPIO_0, (gpio->detStatus[0] & 1) != 0);
+	pxaIcInt(gpio->ic, PXA_I_GPIO_all, gpio->detStatus[3] || gpio->detStatus[2] || gpio->detStatus[1] || (gpio->detStatus[0] &~ 3));
+	pxaIcInt(gpio->ic, PXA_I_GPIO_1, (gpio->detStatus[0] & 2) != 0);
+	pxaIcInt(gpio->ic, PXA_I_GPIO_0, (gpio->detStatus[0] & 1) != 0);
 }
 
 static bool socGpioPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* buf)
@@ -304,7 +304,7 @@ done:
 	return true;
 }
 
-struct SocGpio* socGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev)
+struct SocGpio* pxaGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev)
 {
 	struct SocGpio *gpio = (struct SocGpio*)malloc(sizeof(*gpio));
 	
@@ -332,7 +332,7 @@ struct SocGpio* socGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8
 	return gpio;
 }
 
-void socGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
+void pxaGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
 {
 	uint32_t set = gpioNum >> 5;
 	uint32_t v = 1UL << (gpioNum & 0x1F);
@@ -351,7 +351,7 @@ void socGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
 	socGpioPrvRecalcIntrs(gpio);
 }
 
-enum SocGpioState socGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
+enum SocGpioState pxaGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
 {
 	uint32_t sSet = gpioNum >> 5;
 	uint32_t bSet = gpioNum >> 4;
@@ -382,7 +382,7 @@ enum SocGpioState socGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
 	return SocGpioStateHiZ;
 }
 
-void socGpioSetNotif (struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData)
+void pxaGpioSetNotif (struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData)
 {
 	if (gpioNum >= gpio->nGpios)
 		return;
@@ -391,7 +391,7 @@ void socGpioSetNotif (struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNot
 	gpio->notifD[gpioNum] = userData;
 }
 
-void socGpioSetDirsChangedNotif (struct SocGpio *gpio, GpioDirsChangedF notifF, void *userData)
+void pxaGpioSetDirsChangedNotif (struct SocGpio *gpio, GpioDirsChangedF notifF, void *userData)
 {
 	gpio->dirNotifF = notifF;
 	gpio->dirNotifD = userData;
@@ -0,0 +1,16 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _PXA_GPIO_H_
+#define _PXA_GPIO_H_
+
+#include "soc_GPIO.h"
+
+
+struct SocGpio* pxaGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev);
+enum SocGpioState pxaGpioGetState(struct SocGpio* gpio, uint_fast8_t gpioNum);
+void pxaGpioSetState(struct SocGpio* gpio, uint_fast8_t gpioNum, bool on);
+void pxaGpioSetNotif(struct SocGpio* gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData);
+void pxaGpioSetDirsChangedNotif(struct SocGpio* gpio, GpioDirsChangedF notifF, void *userData);
+
+
+#endif
@@ -1,7 +1,7 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
 #include "pxa_IC.h"
-#include "soc_I2C.h"
+#include "pxa_I2C.h"
 #include <string.h>
 #include <stdlib.h>
 #include "util.h"
@@ -39,7 +39,7 @@ struct SocI2c {
 	
 };
 
-bool socI2cDeviceAdd(struct SocI2c *i2c, I2cDeviceActionF actF, void *userData)
+bool pxaI2cDeviceAdd(struct SocI2c *i2c, I2cDeviceActionF actF, void *userData)
 {
 	uint_fast8_t i;
 	
@@ -75,7 +75,7 @@ static void socI2cPrvRecalcIrq(struct SocI2c *i2c)
 	if (!(i2c->icr & 0x0100))	//ITEIE
 		effectiveIsr &=~ (1 << 6);
 	
-	socIcInt(i2c->ic, i2c->irqNo, !!effectiveIsr);
+	pxaIcInt(i2c->ic, i2c->irqNo, !!effectiveIsr);
 }
 
 static uint_fast8_t socI2cPrvAction(struct SocI2c *i2c, enum ActionI2C action, uint8_t param)
@@ -241,7 +241,7 @@ static bool socI2cPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 	return true;
 }
 
-struct SocI2c* socI2cInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint32_t irqNo)
+struct SocI2c* pxaI2cInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint32_t irqNo)
 {
 	struct SocI2c *i2c = (struct SocI2c*)malloc(sizeof(*i2c));
 	
@@ -0,0 +1,13 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _PXA_I2C_H_
+#define _PXA_I2C_H_
+
+#include "soc_I2C.h"
+
+
+struct SocI2c* pxaI2cInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t base, uint32_t irqNo);
+bool pxaI2cDeviceAdd(struct SocI2c *i2c, I2cDeviceActionF actF, void *userData);
+
+
+#endif
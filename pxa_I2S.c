@@ -5,6 +5,7 @@
 #include "soc_I2S.h"
 #include <string.h>
 #include <stdlib.h>
+#include "endian.h"
 #include "util.h"
 
 #define PXA_I2S_BASE	0x40400000UL
@@ -15,6 +16,9 @@ struct SocI2s {
 	struct SocDma *dma;
 	struct SocIc *ic;
 	
+	I2sClientTxF clientTxF;
+	void *clientData;
+	
 	uint16_t sacr0;
 	uint16_t sasr0;
 	uint8_t sacr1;
@@ -25,12 +29,14 @@ struct SocI2s {
 	uint32_t rxFifo[16];
 	uint8_t txFifoEnts;
 	uint8_t rxFifoEnts;
+	
+	uint32_t ticksPerSec, clkRem;	//frames go out at the SADIV rate, however often we are called
 };
 
 
 static void socI2sPrvIrqUpdate(struct SocI2s *i2s)
 {
-	socIcInt(i2s->ic, PXA_I_I2S, !!(i2s->sasr0 & i2s->saimr & 0x78));
+	pxaIcInt(i2s->ic, PXA_I_I2S, !!(i2s->sasr0 & i2s->saimr & 0x78));
 }
 
 static void socI2sPrvTxFifoRecalc(struct SocI2s *i2s)
@@ -45,7 +51,7 @@ static void socI2sPrvTxFifoRecalc(struct SocI2s *i2s)
 		i2s->sasr0 |= 0x08;
 	
 	socI2sPrvIrqUpdate(i2s);
-	socDmaExternalReq(i2s->dma, DMA_CMR_I2S_TX, !!(i2s->sasr0 & 0x08));
+	pxaDmaExternalReq(i2s->dma, DMA_CMR_I2S_TX, !!(i2s->sasr0 & 0x08));
 }
 
 static void socI2sPrvRxFifoRecalc(struct SocI2s *i2s)
@@ -61,7 +67,7 @@ static void socI2sPrvRxFifoRecalc(struct SocI2s *i2s)
 	
 	socI2sPrvIrqUpdate(i2s);
 	
-	socDmaExternalReq(i2s->dma, DMA_CMR_I2S_RX, !!(i2s->sasr0 & 0x10));
+	pxaDmaExternalReq(i2s->dma, DMA_CMR_I2S_RX, !!(i2s->sasr0 & 0x10));
 }
 
 static bool socI2sPrvFifoW(struct SocI2s *i2s, uint32_t val)
@@ -89,6 +95,45 @@ static bool socI2sPrvFifoR(struct SocI2s *i2s, uint32_t *valP)
 	return true;
 }
 
+static uint32_t socI2sPrvDmaTx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct SocI2s *i2s = (struct SocI2s*)userData;
+	const uint32_t *src = (const uint32_t*)buf;
+	uint32_t done;
+	
+	if (itemSz != 4)
+		return 0;
+	
+	for (done = 0; done < len / 4 && i2s->txFifoEnts < sizeof(i2s->txFifo) / sizeof(*i2s->txFifo); done++)
+		i2s->txFifo[i2s->txFifoEnts++] = le32toh(src[done]);
+	
+	if (done)
+		socI2sPrvTxFifoRecalc(i2s);
+	
+	return done * 4;
+}
+
+static uint32_t socI2sPrvDmaRx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct SocI2s *i2s = (struct SocI2s*)userData;
+	uint32_t *dst = (uint32_t*)buf;
+	uint32_t done;
+	
+	if (itemSz != 4)
+		return 0;
+	
+	for (done = 0; done < len / 4 && done < i2s->rxFifoEnts; done++)
+		dst[done] = htole32(i2s->rxFifo[done]);
+	
+	if (done) {
+		i2s->rxFifoEnts -= done;
+		memmove(i2s->rxFifo + 0, i2s->rxFifo + done, sizeof(*i2s->rxFifo) * i2s->rxFifoEnts);
+		socI2sPrvRxFifoRecalc(i2s);
+	}
+	
+	return done * 4;
+}
+
 static bool socI2sPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* buf)
 {
 	struct SocI2s *i2s = (struct SocI2s*)userData;
@@ -165,7 +210,7 @@ static bool socI2sPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 	return true;
 }
 
-struct SocI2s* socI2sInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma)
+struct SocI2s* socI2sInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t periodicHz)
 {
 	struct SocI2s *i2s = (struct SocI2s*)malloc(sizeof(*i2s));
 	
@@ -178,40 +223,72 @@ struct SocI2s* socI2sInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDm
 	i2s->sacr0 = 0x7700;
 	i2s->sasr0 = 0x0001;
 	i2s->sadiv = 0x001a;
+	i2s->ticksPerSec = periodicHz;
 	
 	if (!memRegionAdd(physMem, PXA_I2S_BASE, PXA_I2S_SIZE, socI2sPrvMemAccessF, i2s))
 		ERR("cannot add I2S to MEM\n");
 	
+	pxaDmaSetBulkHandler(dma, DMA_CMR_I2S_TX, true, socI2sPrvDmaTx, i2s);
+	pxaDmaSetBulkHandler(dma, DMA_CMR_I2S_RX, false, socI2sPrvDmaRx, i2s);
+	
 	return i2s;
 }
 
 void socI2sPeriodic(struct SocI2s *i2s)
 {
-	uint32_t val = 0;
+	uint32_t frames[sizeof(i2s->txFifo) / sizeof(*i2s->txFifo)] = {0, }, rate, due, done = 0, i;
+	uint64_t t;
 	
-	//consume a sample if tx is allowed
+	if (!i2s->sadiv)
+		return;
+	
+	//SYSCLK is 147.456MHz / SADIV and a frame takes 256 of those
+	rate = 576000 / i2s->sadiv;
+	t = (uint64_t)rate + i2s->clkRem;
+	due = t / i2s->ticksPerSec;
+	i2s->clkRem = t % i2s->ticksPerSec;
+	if (due > sizeof(frames) / sizeof(*frames))
+		due = sizeof(frames) / sizeof(*frames);
+	if (!due)
+		return;
+	
+	//consume samples if tx is allowed
 	if (!(i2s->sacr1 & 0x10)) {
 		
-		if (i2s->txFifoEnts) {
+		done = due < i2s->txFifoEnts ? due : i2s->txFifoEnts;
+		if (done) {
 			
-			val = i2s->txFifo[0];
-			memmove(i2s->txFifo + 0, i2s->txFifo + 1, sizeof(*i2s->txFifo) * --i2s->txFifoEnts);
+			memcpy(frames, i2s->txFifo, sizeof(*frames) * done);
+			i2s->txFifoEnts -= done;
+			memmove(i2s->txFifo + 0, i2s->txFifo + done, sizeof(*i2s->txFifo) * i2s->txFifoEnts);
+			
+			if (i2s->clientTxF)
+				i2s->clientTxF(i2s->clientData, frames, done, rate);
 		}
-		else
+		if (done != due)
 			i2s->sasr0 |= 0x20;
-		
 	}
 	
-	//get a sample if RX is allowed
+	//get samples if RX is allowed
 	if (!(i2s->sacr1 & 0x08)) {
-		if (i2s->rxFifoEnts != sizeof(i2s->rxFifo) / sizeof(*i2s->rxFifo)) {
+		
+		for (i = 0; i < due; i++) {
 			
-			i2s->rxFifo[i2s->rxFifoEnts++] = val;
+			if (i2s->rxFifoEnts == sizeof(i2s->rxFifo) / sizeof(*i2s->rxFifo)) {
+				
+				i2s->sasr0 |= 0x40;
+				break;
+			}
+			i2s->rxFifo[i2s->rxFifoEnts++] = frames[i];
 		}
-		else
-			i2s->sasr0 |= 0x40;
 	}
 	
 	socI2sPrvTxFifoRecalc(i2s);
 	socI2sPrvRxFifoRecalc(i2s);
-}
\ No newline at end of file
+}
+
+void socI2sClientAdd(struct SocI2s *i2s, I2sClientTxF txF, void *userData)
+{
+	i2s->clientTxF = txF;
+	i2s->clientData = userData;
+}
\ No newline at end of file
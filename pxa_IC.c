@@ -303,11 +303,76 @@ bool pxa270icPrvCoprocAccess(struct ArmCpu* cpu, void* userData, bool two/* MCR2
 	return true;
 }
 
-struct SocIc* socIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev)
+static bool pxa270icPrvOpReadIcip(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), socIcPrvGetIcip((struct SocIc*)userData, arg));
+	return true;
+}
+
+static bool pxa270icPrvOpReadIchp(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), socIcPrvCalcHighestPrio((struct SocIc*)userData));
+	return true;
+}
+
+static bool pxa270icPrvOpReadIcpr(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), ((struct SocIc*)userData)->ICPR[arg]);
+	return true;
+}
+
+static bool pxa270icPrvOpReadIcmr(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), ((struct SocIc*)userData)->ICMR[arg]);
+	return true;
+}
+
+static bool pxa270icPrvOpWriteIcmr(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	struct SocIc *ic = (struct SocIc*)userData;
+	
+	ic->ICMR[arg] = cpuGetRegExternal(cpu, ARM_CP_INSTR_RD(instr));
+	socIcPrvHandleChanges(ic);
+	return true;
+}
+
+//what an IRQ handler does on every interrupt: find the source, mask it, unmask it later. "arg" is the bank
+static ArmCoprocOpF pxa270icPrvCoprocDecode(struct ArmCpu* cpu, void* userData, uint32_t instr, uint32_t *argP)
+{
+	uint_fast8_t CRn = ARM_CP_INSTR_CRN(instr);
+	bool MRC = ARM_CP_INSTR_MRC(instr);
+	
+	if (!ARM_CP_INSTR_XFER(instr) || ARM_CP_INSTR_TWO(instr) || ARM_CP_INSTR_XFER_OP1(instr) || ARM_CP_INSTR_CRM(instr) || ARM_CP_INSTR_OP2(instr))
+		return NULL;
+	
+	*argP = CRn >= 6;
+	switch (CRn) {
+		case 0:
+		case 6:
+			return MRC ? pxa270icPrvOpReadIcip : NULL;
+		
+		case 1:
+		case 7:
+			return MRC ? pxa270icPrvOpReadIcmr : pxa270icPrvOpWriteIcmr;
+		
+		case 4:
+		case 10:
+			return MRC ? pxa270icPrvOpReadIcpr : NULL;
+		
+		case 5:
+			return MRC ? pxa270icPrvOpReadIchp : NULL;
+		
+		default:
+			return NULL;
+	}
+}
+
+struct SocIc* pxaIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev)
 {
 	struct SocIc *ic = (struct SocIc*)malloc(sizeof(*ic));
 	struct ArmCoprocessor cp = {
 		.regXfer = pxa270icPrvCoprocAccess,
+		.decode = pxa270icPrvCoprocDecode,
 		.userData = ic,
 	};
 	
@@ -328,7 +393,7 @@ struct SocIc* socIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t
 	return ic;
 }
 
-void socIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise)		//interrupt caused by emulated hardware
+void pxaIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise)		//interrupt caused by emulated hardware
 {
 	uint32_t old = ic->ICPR[intNum / 32];
 	
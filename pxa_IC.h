@@ -44,5 +44,9 @@
 #define PXA_I_SSP3			0	//PXA27x
 
 
+struct SocIc* pxaIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev);
+void pxaIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise);
+
+
 #endif
 
@@ -2,9 +2,10 @@
 
 #include "pxa_LCD.h"
 #include "pxa_IC.h"
-#include "SDL2/SDL.h"
+#include "display.h"
 #include <string.h>
 #include <stdlib.h>
+#include "speed.h"
 #include "util.h"
 #include "mem.h"
 
@@ -18,11 +19,14 @@
 
 #define UNMASKABLE_INTS			0x7C8E
 
+#define HOST_REFRESH_DIVIDER	16		//guest refreshes at ~1200fps, we look for changes in every 16th frame
+
 
 struct PxaLcd {
 
 	struct SocIc *ic;
 	struct ArmMem *mem;
+	struct ArmRam *ram;
 	
 	//registers
 	uint32_t lccr0, lccr1, lccr2, lccr3, lccr4, lccr5, liicr, trgbr, tcr;
@@ -36,11 +40,16 @@ struct PxaLcd {
 	uint8_t intWasPending	: 1;
 	uint8_t enbChanged	: 1;
 
-	uint8_t palette[512];
+	uint16_t palette[256];
 
 	uint32_t frameNum;
 	
 	bool hardGrafArea;
+	bool redrawAll;		//geometry, format or palette changed since we last drew
+	uint32_t drawnAddr;
+	
+	//output
+	struct Display *disp;
 };
 
 
@@ -51,7 +60,7 @@ static void pxaLcdPrvUpdateInts(struct PxaLcd *lcd)
 	if ((ints && !lcd->intWasPending) || (!ints && lcd->intWasPending)) {
 			
 		lcd->intWasPending = !!ints;
-		socIcInt(lcd->ic, PXA_I_LCD, !!ints);
+		pxaIcInt(lcd->ic, PXA_I_LCD, !!ints);
 	}
 }
 
@@ -97,14 +106,17 @@ static bool pxaLcdPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 			
 			case 1:
 				lcd->lccr1 = val;
+				lcd->redrawAll = true;
 				break;
 			
 			case 2:
 				lcd->lccr2 = val;
+				lcd->redrawAll = true;
 				break;
 			
 			case 3:
 				lcd->lccr3 = val;
+				lcd->redrawAll = true;
 				break;
 			
 			case 4:
@@ -291,123 +303,66 @@ static void pxaLcdPrvDma(struct PxaLcd *lcd, void* dest, uint32_t addr, int32_t
 	}
 }
 	
-static void pxaLcdPrvScreenDataPixel(struct PxaLcd *lcd, uint8_t* buf)
+static void pxaLcdPrvOpenDisplay(struct PxaLcd *lcd, uint32_t w, uint32_t h)
 {
-	static SDL_Surface *mScreen = NULL;
-	static SDL_Window *mWindow = NULL;
-	uint16_t val = *(uint16_t*)buf;
-	static uint32_t pixCnt = 0;
-	static uint16_t *dst;
-	uint32_t w, h;
-
-	w = (lcd->lccr1 & 0x3ff) + 1;
-	h = (lcd->lccr2 & 0x3ff) + 1;
+	if (!lcd->disp)
+		lcd->disp = displayInit(w, h, lcd->hardGrafArea ? h + 3 * w / 8 : h);
+}
 
-	if (!mWindow) {
-		
-		uint32_t winH = h;
-		
-		if (lcd->hardGrafArea)
-			winH += 3 * w / 8;
-		
-		fprintf(stderr, "SCREEN configured for %u x %u\n", (unsigned)w, (unsigned)h);
-		mWindow = SDL_CreateWindow("uARM", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, w, winH, 0);
-		if (mWindow == NULL) {
-			printf("Couldn't create window: %s\n", SDL_GetError());
-			exit(-1);
-		}
-		
-		mScreen = SDL_CreateRGBSurface(0, w, h, 16, 0xf800, 0x07e0, 0x001f, 0x0000);
-		if (mScreen == NULL) {
-			printf("Couldn't create screen surface: %s\n", SDL_GetError());
-			exit(-1);
-		}
-	}
-	
-	if (!pixCnt) {
-		
-		SDL_LockSurface(mScreen);
-		dst = (uint16_t*)mScreen->pixels;
-	}
-	
-	dst[pixCnt++] = val;
-	
-	if (pixCnt == w * h) {
-		
-		pixCnt = 0;
-		SDL_UnlockSurface(mScreen);
-		dst = NULL;
-		SDL_BlitSurface(mScreen, NULL, SDL_GetWindowSurface(mWindow), NULL);
-		SDL_UpdateWindowSurface(mWindow);
-	}
+static void pxaLcdPrvReleaseFb(struct PxaLcd *lcd)
+{
+	displayPublish(lcd->disp);
 }
 
 static void pxaLcdPrvScreenDataDma(struct PxaLcd *lcd, uint32_t addr/*PA*/, uint32_t len)
 {
-	uint8_t data[4];
-	uint32_t i, j;
-	void* ptr;
+	uint32_t w = (lcd->lccr1 & 0x3ff) + 1, h = (lcd->lccr2 & 0x3ff) + 1, r, rowBytes, numRows;
+	static const uint8_t fmts[] = {DisplayPixPal1, DisplayPixPal2, DisplayPixPal4, DisplayPixPal8, DisplayPixRgb565};
+	uint_fast8_t fmt, bppMode = (lcd->lccr3 >> 24) & 7;
+	uint8_t rowBuf[1024 * 2];
+	uint32_t frameAddr = addr;
+	const uint8_t *src;
+	bool all;
 	
-	len /= 4;
-	while (len--) {
-		pxaLcdPrvDma(lcd, data, addr, 4);
-		addr += 4;
+	if (bppMode > 4)	//BAD
+		return;
+	
+	fmt = fmts[bppMode];
+	rowBytes = displayRowBytes(fmt, w);
+	numRows = len / rowBytes;
+	if (numRows > h)
+		numRows = h;
+	
+	//framebuffer is nearly always in RAM, then we read it in place and only convert rows written since we last did. if not, we DMA it all
+	src = (const uint8_t*)ramGetPtr(lcd->ram, addr, numRows * rowBytes);
+	all = !src || lcd->redrawAll || lcd->drawnAddr != addr;
+	
+	if (!all && !ramDirtyTest(lcd->ram, addr, numRows * rowBytes))
+		return;
+	
+	if (speedShouldSkipFrame())
+		return;
+	
+	pxaLcdPrvOpenDisplay(lcd, w, h);
+	
+	for (r = 0; r < numRows; r++, addr += rowBytes) {
 		
-		switch ((lcd->lccr3 >> 24) & 7) {
-			
-			case 0:		//1BPP
-				
-				for (i = 0; i < 4; i++) {
-					for (j = 0; j < 8; j++) {
-					
-						ptr = lcd->palette + ((data[i] >> j) & 1) * 2;
-						pxaLcdPrvScreenDataPixel(lcd, (uint8_t*)ptr);
-					}
-				}
-				break;
-			
-			case 1:		//2BPP
-				
-				for (i = 0; i < 4; i++) {
-					for (j = 0; j < 8; j += 2) {
-					
-						ptr = lcd->palette + ((data[i] >> j) & 3) * 2;
-						pxaLcdPrvScreenDataPixel(lcd, (uint8_t*)ptr);
-					}
-				}
-				break;
-			
-			case 2:		//4BPP
-				
-				for (i = 0; i < 4; i++) {
-					for (j = 0; j < 8; j += 4) {
-					
-						ptr = lcd->palette + ((data[i] >> j) & 15) * 2;
-						pxaLcdPrvScreenDataPixel(lcd, (uint8_t*)ptr);
-					}
-				}
-				break;
-			
-			case 3:		//8BPP
-				
-				for (i = 0; i < 4; i++) {
-					
-					ptr = lcd->palette + (data[i] * 2);
-					pxaLcdPrvScreenDataPixel(lcd, (uint8_t*)ptr);
-				}
-				break;
-			
-			case 4:		//16BPP
-				
-				for (i = 0; i < 4; i += 2)
-					pxaLcdPrvScreenDataPixel(lcd, data + i);
-				break;
-			
-			default:
-				
-				;//BAD
+		if (src) {
+			if (all || ramDirtyTest(lcd->ram, addr, rowBytes))
+				displayDrawRow(lcd->disp, r, src, w, fmt, lcd->palette);
+			src += rowBytes;
+		}
+		else {
+			pxaLcdPrvDma(lcd, rowBuf, addr, rowBytes);
+			displayDrawRow(lcd->disp, r, rowBuf, w, fmt, lcd->palette);
 		}
 	}
+	
+	ramDirtyClear(lcd->ram, frameAddr, numRows * rowBytes);
+	lcd->drawnAddr = frameAddr;
+	lcd->redrawAll = false;
+	
+	pxaLcdPrvReleaseFb(lcd);
 }
 
 void pxaLcdFrame(struct PxaLcd *lcd)
@@ -467,15 +422,22 @@ void pxaLcdFrame(struct PxaLcd *lcd)
 				
 				if (lcd->ldcmd[0] & 0x04000000UL) {	//pallette data
 					
+					uint16_t palette[256];
+					
 					if (len > sizeof(lcd->palette))
 						len = sizeof(lcd->palette);
 				
-					pxaLcdPrvDma(lcd, lcd->palette, lcd->fsadr[0], len);	
+					pxaLcdPrvDma(lcd, palette, lcd->fsadr[0], len);
+					if (memcmp(palette, lcd->palette, len)) {
+						
+						memcpy(lcd->palette, palette, len);
+						lcd->redrawAll = true;
+					}
 				}
 				else{
 					
 					lcd->frameNum++;
-					if (!(lcd->frameNum & 63))
+					if (!(lcd->frameNum % HOST_REFRESH_DIVIDER))
 						pxaLcdPrvScreenDataDma(lcd, lcd->fsadr[0], len);
 				}
 				
@@ -493,7 +455,7 @@ void pxaLcdFrame(struct PxaLcd *lcd)
 	pxaLcdPrvUpdateInts(lcd);
 }
 
-struct PxaLcd* pxaLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardGrafArea)
+struct PxaLcd* pxaLcdInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic, bool hardGrafArea)
 {
 	struct PxaLcd *lcd = (struct PxaLcd*)malloc(sizeof(*lcd));
 	
@@ -503,12 +465,16 @@ struct PxaLcd* pxaLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardGra
 	memset(lcd, 0, sizeof (*lcd));
 	lcd->ic = ic;
 	lcd->mem = physMem;
+	lcd->ram = ram;
+	lcd->redrawAll = true;
 	lcd->intMask = UNMASKABLE_INTS;
 	lcd->hardGrafArea = hardGrafArea;
 	
 	if (!memRegionAdd(physMem, PXA_LCD_BASE, PXA_LCD_SIZE, pxaLcdPrvMemAccessF, lcd))
 		ERR("cannot add LCD to MEM\n");
 	
+	ramDirtyTrack(ram);
+	
 	return lcd;
 }
 
@@ -4,6 +4,7 @@
 #define _PXA_LCD_H_
 
 #include "mem.h"
+#include "RAM.h"
 #include "CPU.h"
 #include "soc_IC.h"
 
@@ -11,7 +12,7 @@ struct PxaLcd;
 
 
 
-struct PxaLcd* pxaLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardGrafArea);
+struct PxaLcd* pxaLcdInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic, bool hardGrafArea);
 void pxaLcdFrame(struct PxaLcd *lcd);
 
 
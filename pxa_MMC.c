@@ -41,7 +41,7 @@ static void pxaMmcPrvIrqUpdate(struct PxaMmc *mmc)
 	if (mmc->cmdat & 0x80)
 		irqs &=~ 0x60;
 	
-	socIcInt(mmc->ic, PXA_I_MMC, !!irqs);
+	pxaIcInt(mmc->ic, PXA_I_MMC, !!irqs);
 }
 
 static void pxaMmcPrvRecalcIregAndFifo(struct PxaMmc *mmc)
@@ -66,8 +66,8 @@ static void pxaMmcPrvRecalcIregAndFifo(struct PxaMmc *mmc)
 
 	if (mmc->cmdat & 0x80) {
 		
-		socDmaExternalReq(mmc->dma, DMA_CMR_MMC_RX, !!(mmc->iReg & 0x20));
-		socDmaExternalReq(mmc->dma, DMA_CMR_MMC_TX, !!(mmc->iReg & 0x40));
+		pxaDmaExternalReq(mmc->dma, DMA_CMR_MMC_RX, !!(mmc->iReg & 0x20));
+		pxaDmaExternalReq(mmc->dma, DMA_CMR_MMC_TX, !!(mmc->iReg & 0x40));
 	}
 	
 	pxaMmcPrvIrqUpdate(mmc);
@@ -102,6 +102,27 @@ static void pxaMmcPrvDataXferNextBlockRead(struct PxaMmc *mmc)
 	}
 }
 
+static void pxaMmcPrvDataXferRxDrained(struct PxaMmc *mmc)
+{
+	if (mmc->numBlks)
+		pxaMmcPrvDataXferNextBlockRead(mmc);
+	else {
+		mmc->stat |= 0x0800;		//data xfer done
+		mmc->dataXferOngoing = false;
+	}
+}
+
+static void pxaMmcPrvDataXferTxBlocksDone(struct PxaMmc *mmc, uint32_t numBlks)
+{
+	mmc->numBlks -= numBlks;
+	
+	if (!mmc->numBlks) {
+		mmc->stat |= 0x0800;		//data xfer done
+		mmc->stat |= 0x1000;		//not busy
+		mmc->dataXferOngoing = false;
+	}
+}
+
 static void pxaMmcPrvDataXferStart(struct PxaMmc *mmc)
 {
 
@@ -122,6 +143,33 @@ static void pxaMmcPrvDataXferStart(struct PxaMmc *mmc)
 	}
 }
 
+static bool pxaMmcPrvDataXferTxBlockFull(struct PxaMmc *mmc)
+{
+	enum SdDataReplyType ret;
+
+	if (!mmc->dataXferOngoing) {
+		fprintf(stderr, "Cannot write block if no xfer ongoing\n");
+		return false;
+	}
+	
+	ret = vsdDataXferBlockToCard(mmc->vsd, mmc->blockFifo, mmc->blkLen);
+	switch (ret) {
+		case SdDataErrWrongBlockSize:		//would manifest as a crc error
+		case SdDataErrWrongCurrentState:	//would manifest as a timeout but we report all as crc errors
+		case SdDataErrBackingStore:
+		default:
+			mmc->stat |= 0x0004;			//crc write error
+			break;
+
+		case SdDataOk:
+			mmc->fifoBytes = 0;
+			pxaMmcPrvDataXferTxBlocksDone(mmc, 1);
+			break;
+	}
+	
+	return true;
+}
+
 static bool pxaMmcPrvDataFifoW(struct PxaMmc *mmc, uint32_t val)
 {
 	if (mmc->fifoBytes >= mmc->blkLen) {
@@ -131,36 +179,8 @@ static bool pxaMmcPrvDataFifoW(struct PxaMmc *mmc, uint32_t val)
 	
 	mmc->blockFifo[mmc->fifoBytes++] = val;
 	
-	if (mmc->fifoBytes == mmc->blkLen) {
-		
-		enum SdDataReplyType ret;
-	
-		if (!mmc->dataXferOngoing) {
-			fprintf(stderr, "Cannot write block if no xfer ongoing\n");
-			return false;
-		}
-		
-		ret = vsdDataXferBlockToCard(mmc->vsd, mmc->blockFifo, mmc->blkLen);
-		switch (ret) {
-			case SdDataErrWrongBlockSize:		//would manifest as a crc error
-			case SdDataErrWrongCurrentState:	//would manifest as a timeout but we report all as crc errors
-			case SdDataErrBackingStore:
-			default:
-				mmc->stat |= 0x0004;			//crc write error
-				break;
-
-			case SdDataOk:
-				mmc->fifoBytes = 0;
-				mmc->numBlks--;
-				
-				if (!mmc->numBlks) {
-					mmc->stat |= 0x0800;		//data xfer done
-					mmc->stat |= 0x1000;		//not busy
-					mmc->dataXferOngoing = false;
-				}
-				break;
-		}
-	}
+	if (mmc->fifoBytes == mmc->blkLen && !pxaMmcPrvDataXferTxBlockFull(mmc))
+		return false;
 	
 	pxaMmcPrvRecalcIregAndFifo(mmc);
 	
@@ -178,19 +198,104 @@ static bool pxaMmcPrvDataFifoR(struct PxaMmc *mmc, uint32_t *valP)
 	*valP = mmc->blockFifo[mmc->fifoOfst++];
 	mmc->fifoBytes--;
 	
-	if (!mmc->fifoBytes) {
-		if (mmc->numBlks)
-			pxaMmcPrvDataXferNextBlockRead(mmc);
-		else {
-			mmc->stat |= 0x0800;		//data xfer done
-			mmc->dataXferOngoing = false;
-		}
-	}
+	if (!mmc->fifoBytes)
+		pxaMmcPrvDataXferRxDrained(mmc);
 	
 	pxaMmcPrvRecalcIregAndFifo(mmc);
 	return true;
 }
 
+static uint32_t pxaMmcPrvWholeBlocks(struct PxaMmc *mmc, uint32_t bytes)	//how many blocks can skip the fifo
+{
+	uint32_t num = bytes / VSD_SECTOR_SIZE, left;
+	
+	if (!mmc->vsd || mmc->blkLen != VSD_SECTOR_SIZE)
+		return 0;
+	left = vsdDataBlocksLeft(mmc->vsd);
+	if (num > mmc->numBlks)
+		num = mmc->numBlks;
+	
+	return num < left ? num : left;
+}
+
+//DMA draining the fifo: what is in it, then whole blocks straight from the card into RAM
+static uint32_t pxaMmcPrvDmaRx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct PxaMmc *mmc = (struct PxaMmc*)userData;
+	uint8_t *dst = (uint8_t*)buf;
+	uint32_t done = 0, now;
+	
+	if (itemSz != 1)	//the fifo is a byte wide
+		return 0;
+	
+	while (done < len && mmc->fifoBytes) {
+		
+		now = len - done < mmc->fifoBytes ? len - done : mmc->fifoBytes;
+		memcpy(dst + done, mmc->blockFifo + mmc->fifoOfst, now);
+		mmc->fifoOfst += now;
+		mmc->fifoBytes -= now;
+		done += now;
+		if (mmc->fifoBytes)
+			break;
+		
+		now = pxaMmcPrvWholeBlocks(mmc, len - done);
+		if (now) {
+			if (vsdDataXferBlocks(mmc->vsd, dst + done, now) != SdDataOk) {
+				mmc->stat |= 0x0001;	//read timeout
+				break;
+			}
+			mmc->numBlks -= now;
+			done += now * VSD_SECTOR_SIZE;
+		}
+		pxaMmcPrvDataXferRxDrained(mmc);
+	}
+	
+	if (done)
+		pxaMmcPrvRecalcIregAndFifo(mmc);
+	
+	return done;
+}
+
+//DMA filling the fifo: whole blocks go straight to the card, the rest through the fifo
+static uint32_t pxaMmcPrvDmaTx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct PxaMmc *mmc = (struct PxaMmc*)userData;
+	const uint8_t *src = (const uint8_t*)buf;
+	uint32_t done = 0, now;
+	
+	if (itemSz != 1)	//the fifo is a byte wide
+		return 0;
+	
+	while (done < len && mmc->dataXferOngoing && mmc->numBlks) {
+		
+		if (!mmc->fifoBytes && (now = pxaMmcPrvWholeBlocks(mmc, len - done)) != 0) {
+			
+			if (vsdDataXferBlocks(mmc->vsd, (void*)(src + done), now) != SdDataOk) {
+				mmc->stat |= 0x0004;	//crc write error
+				break;
+			}
+			pxaMmcPrvDataXferTxBlocksDone(mmc, now);
+			done += now * VSD_SECTOR_SIZE;
+			continue;
+		}
+		
+		now = mmc->blkLen - mmc->fifoBytes;
+		if (now > len - done)
+			now = len - done;
+		memcpy(mmc->blockFifo + mmc->fifoBytes, src + done, now);
+		mmc->fifoBytes += now;
+		done += now;
+		
+		if (mmc->fifoBytes == mmc->blkLen && (!pxaMmcPrvDataXferTxBlockFull(mmc) || mmc->fifoBytes))
+			break;
+	}
+	
+	if (done)
+		pxaMmcPrvRecalcIregAndFifo(mmc);
+	
+	return done;
+}
+
 
 static bool mmcSendCommand(struct PxaMmc *mmc)
 {
@@ -498,6 +603,9 @@ struct PxaMmc *pxaMmcInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDm
 	mmc->stat = 0x40;
 	pxaMmcPrvRecalcIregAndFifo(mmc);
 	
+	pxaDmaSetBulkHandler(dma, DMA_CMR_MMC_RX, false, pxaMmcPrvDmaRx, mmc);
+	pxaDmaSetBulkHandler(dma, DMA_CMR_MMC_TX, true, pxaMmcPrvDmaTx, mmc);
+	
 	if (!memRegionAdd(physMem, PXA_MMC_BASE, PXA_MMC_SIZE, pxaMmcPrvMemAccessF, mmc))
 		ERR("cannot add MMC to MEM\n");
 	
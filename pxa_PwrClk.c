@@ -103,6 +103,46 @@ success:
 	return true;
 }
 
+static bool pxaPwrClkPrvOpReadZero(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	cpuSetReg(cpu, ARM_CP_INSTR_RD(instr), 0);
+	return true;
+}
+
+static bool pxaPwrClkPrvOpPwrMode(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t arg)
+{
+	uint_fast8_t Rx = ARM_CP_INSTR_RD(instr);
+	
+	if (cpuGetRegExternal(cpu, Rx) == 1)		//idle
+		return true;
+	
+	return pxaPwrClkPrvCoproc14regXferFunc(cpu, userData, false, false, 0, Rx, 7, 0, 0);
+}
+
+//the OS idle loop and clock queries hit these over and over
+static ArmCoprocOpF pxaPwrClkPrvCoproc14decode(struct ArmCpu *cpu, void* userData, uint32_t instr, uint32_t *argP)
+{
+	uint_fast8_t op2 = ARM_CP_INSTR_OP2(instr);
+	bool read = ARM_CP_INSTR_MRC(instr);
+	
+	if (!ARM_CP_INSTR_XFER(instr) || ARM_CP_INSTR_TWO(instr) || ARM_CP_INSTR_XFER_OP1(instr) || ARM_CP_INSTR_CRM(instr))
+		return NULL;
+	
+	switch (ARM_CP_INSTR_CRN(instr)) {
+		case 6:
+		case 10:
+			return (read && !op2) ? pxaPwrClkPrvOpReadZero : NULL;
+		
+		case 7:
+			if (read)
+				return pxaPwrClkPrvOpReadZero;
+			return op2 ? NULL : pxaPwrClkPrvOpPwrMode;
+		
+		default:
+			return NULL;
+	}
+}
+
 static bool pxaPwrClkPrvClockMgrMemAccessF(void* userData, uint32_t pa, uint8_t size, bool write, void* buf)
 {
 	struct PxaPwrClk *pc = (struct PxaPwrClk*)userData;
@@ -317,6 +357,7 @@ struct PxaPwrClk* pxaPwrClkInit(struct ArmCpu *cpu, struct ArmMem *physMem, bool
 	struct PxaPwrClk *pc = (struct PxaPwrClk*)malloc(sizeof(*pc));
 	struct ArmCoprocessor cp14 = {
 		.regXfer = pxaPwrClkPrvCoproc14regXferFunc,
+		.decode = pxaPwrClkPrvCoproc14decode,
 		.userData = pc,
 	};
 	struct ArmCoprocessor cp7 = {
@@ -36,8 +36,8 @@ void pxaRtcPrvUpdate(struct PxaRtc *rtc)
 		
 		rtc->lastSeenTime = rtc->RCNR;
 	}
-	socIcInt(rtc->ic, PXA_I_RTC_ALM, !!(rtc->RTSR & 1));
-	socIcInt(rtc->ic, PXA_I_RTC_HZ, !!(rtc->RTSR & 2));
+	pxaIcInt(rtc->ic, PXA_I_RTC_ALM, !!(rtc->RTSR & 1));
+	pxaIcInt(rtc->ic, PXA_I_RTC_HZ, !!(rtc->RTSR & 2));
 }
 
 static bool pxaRtcPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* buf)
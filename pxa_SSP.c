@@ -5,6 +5,7 @@
 #include "soc_SSP.h"
 #include <string.h>
 #include <stdlib.h>
+#include "endian.h"
 #include "util.h"
 #include "mem.h"
 
@@ -39,7 +40,7 @@ static void socSspPrvIrqsUpdate(struct SocSsp *ssp)
 	if ((ssp->sr & 0x20) && (ssp->cr1 & 0x02))
 		irq = true;
 	
-	socIcInt(ssp->ic, ssp->irqNo, irq);
+	pxaIcInt(ssp->ic, ssp->irqNo, irq);
 }
 
 static void socSspPrvRecalcRxFifoSta(struct SocSsp *ssp)
@@ -52,7 +53,7 @@ static void socSspPrvRecalcRxFifoSta(struct SocSsp *ssp)
 	if (ssp->rxFifoUsed > ((ssp->cr1 >> 10) & 0x0f))
 		ssp->sr |= 0x40;
 
-	socDmaExternalReq(ssp->dma, ssp->dmaReqNoBase + DMA_OFST_RX, !!(ssp->sr & 0x40));
+	pxaDmaExternalReq(ssp->dma, ssp->dmaReqNoBase + DMA_OFST_RX, !!(ssp->sr & 0x40));
 	
 	socSspPrvIrqsUpdate(ssp);
 }
@@ -67,7 +68,7 @@ static void socSspPrvRecalcTxFifoSta(struct SocSsp *ssp)
 	if (ssp->txFifoUsed <= ((ssp->cr1 >> 6) & 0x0f))
 		ssp->sr |= 0x20;
 	
-	socDmaExternalReq(ssp->dma, ssp->dmaReqNoBase + DMA_OFST_RX, !!(ssp->sr & 0x20));
+	pxaDmaExternalReq(ssp->dma, ssp->dmaReqNoBase + DMA_OFST_TX, !!(ssp->sr & 0x20));
 	
 	socSspPrvIrqsUpdate(ssp);
 }
@@ -102,6 +103,48 @@ static bool socSspPrvFifoW(struct SocSsp *ssp, uint16_t val)
 	return true;
 }
 
+//the data register is 32 bits wide, of which the fifos keep the low 16
+static uint32_t socSspPrvDmaTx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct SocSsp *ssp = (struct SocSsp*)userData;
+	const uint32_t *src = (const uint32_t*)buf;
+	uint32_t done;
+	
+	if (itemSz != 4)
+		return 0;
+	
+	for (done = 0; done < len / 4 && ssp->txFifoUsed < sizeof(ssp->txFifo) / sizeof(*ssp->txFifo); done++)
+		ssp->txFifo[ssp->txFifoUsed++] = le32toh(src[done]);
+	
+	if (done) {
+		ssp->sr |= 0x10;	//busy
+		socSspPrvRecalcTxFifoSta(ssp);
+	}
+	
+	return done * 4;
+}
+
+static uint32_t socSspPrvDmaRx(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz)
+{
+	struct SocSsp *ssp = (struct SocSsp*)userData;
+	uint32_t *dst = (uint32_t*)buf;
+	uint32_t done;
+	
+	if (itemSz != 4)
+		return 0;
+	
+	for (done = 0; done < len / 4 && done < ssp->rxFifoUsed; done++)
+		dst[done] = htole32(ssp->rxFifo[done]);
+	
+	if (done) {
+		ssp->rxFifoUsed -= done;
+		memmove(ssp->rxFifo + 0, ssp->rxFifo + done, sizeof(uint16_t) * ssp->rxFifoUsed);
+		socSspPrvRecalcRxFifoSta(ssp);
+	}
+	
+	return done * 4;
+}
+
 static bool socSspPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* buf)
 {
 	struct SocSsp *ssp = (struct SocSsp*)userData;
@@ -210,6 +253,9 @@ struct SocSsp* socSspInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDm
 	if (!memRegionAdd(physMem, base, PXA_SSP_SIZE, socSspPrvMemAccessF, ssp))
 		ERR("cannot add SSP to MEM\n");
 	
+	pxaDmaSetBulkHandler(dma, dmaReqNoBase + DMA_OFST_TX, true, socSspPrvDmaTx, ssp);
+	pxaDmaSetBulkHandler(dma, dmaReqNoBase + DMA_OFST_RX, false, socSspPrvDmaRx, ssp);
+	
 	return ssp;
 }
 
@@ -27,10 +27,10 @@ struct PxaTimr {
 
 static void pxaTimrPrvRaiseLowerInts(struct PxaTimr *timr)
 {
-	socIcInt(timr->ic, PXA_I_TIMR0, (timr->OSSR & 1) != 0);
-	socIcInt(timr->ic, PXA_I_TIMR1, (timr->OSSR & 2) != 0);
-	socIcInt(timr->ic, PXA_I_TIMR2, (timr->OSSR & 4) != 0);
-	socIcInt(timr->ic, PXA_I_TIMR3, (timr->OSSR & 8) != 0);
+	pxaIcInt(timr->ic, PXA_I_TIMR0, (timr->OSSR & 1) != 0);
+	pxaIcInt(timr->ic, PXA_I_TIMR1, (timr->OSSR & 2) != 0);
+	pxaIcInt(timr->ic, PXA_I_TIMR2, (timr->OSSR & 4) != 0);
+	pxaIcInt(timr->ic, PXA_I_TIMR3, (timr->OSSR & 8) != 0);
 }
 
 static void pxaTimrPrvCheckMatch(struct PxaTimr *timr, uint_fast8_t idx)
@@ -1,6 +1,7 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
 #include "pxa_UART.h"
+#include "pxa_IC.h"
 #include <string.h>
 #include <stdlib.h>
 #include "util.h"
@@ -40,6 +41,7 @@ struct SocUart {
 	
 	uint8_t irq:5;
 	uint8_t cyclesSinceRecv:3;
+	bool bulk;				//move data as fast as the FIFOs allow, not at wire speed
 	
 	uint8_t IER;		//interrupt enable register
 	uint8_t IIR;		//interrupt information register
@@ -127,7 +129,7 @@ static void socUartPrvRecalc(struct SocUart *uart);
 
 static void socUartPrvIrq(struct SocUart *uart, bool raise)
 {
-	socIcInt(uart->ic, uart->irq, !(uart->MCR & UART_MCR_LOOP) && (uart->MCR & UART_MCR_OUT2) && raise/* only raise if ints are enabled */);
+	pxaIcInt(uart->ic, uart->irq, !(uart->MCR & UART_MCR_LOOP) && (uart->MCR & UART_MCR_OUT2) && raise/* only raise if ints are enabled */);
 }
 
 static uint_fast16_t socUartPrvDefaultRead(void* userData)							//these are special funcs since they always get their own userData - the uart pointer :)
@@ -458,7 +460,7 @@ static bool socUartPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 	return true;
 }
 
-void socUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void* userData)
+void pxaUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void* userData)
 {
 	if (!readF)
 		readF = socUartPrvDefaultRead;		//these are special funcs since they get their own private data - the uart :)
@@ -470,7 +472,7 @@ void socUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF wri
 	uart->accessFuncsData = userData;
 }
 
-struct SocUart* socUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t baseAddr, uint8_t irq)
+struct SocUart* pxaUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t baseAddr, uint8_t irq)
 {
 	struct SocUart *uart = (struct SocUart*)malloc(sizeof(*uart));
 	
@@ -488,7 +490,7 @@ struct SocUart* socUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t b
 	socUartPrvFifoFlush(&uart->TX);
 	socUartPrvFifoFlush(&uart->RX);
 	
-	socUartSetFuncs(uart, NULL, NULL, NULL);
+	pxaUartSetFuncs(uart, NULL, NULL, NULL);
 	
 	if (!memRegionAdd(physMem, baseAddr, PXA_UART_SIZE, socUartPrvMemAccessF, uart))
 		ERR("cannot add UART at 0x%08x to MEM\n", baseAddr);
@@ -496,12 +498,10 @@ struct SocUart* socUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t b
 	return uart;
 }
 
-void socUartProcess(struct SocUart *uart)		//send and rceive up to one character
+static void socUartPrvProcessTx(struct SocUart *uart)
 {
-	uint_fast16_t v;
 	uint_fast8_t t;
 	
-	//first process sending (if any)
 	if (!(uart->LSR & UART_LSR_TEMT)) {
 		
 		socUartPrvPutchar(uart, uart->transmitShift);
@@ -531,13 +531,24 @@ void socUartProcess(struct SocUart *uart)		//send and rceive up to one character
 			uart->LSR |= UART_LSR_TDRQ;
 		}
 	}
+}
+
+static bool socUartPrvRxHasRoom(struct SocUart *uart)
+{
+	if (uart->FCR & UART_FCR_TRFIFOE)
+		return socUartPrvFifoUsed(&uart->RX) < UART_FIFO_DEPTH;
+	else
+		return !(uart->LSR & UART_LSR_DR);
+}
+
+static bool socUartPrvProcessRx(struct SocUart *uart)		//true if we got a char
+{
+	uint_fast16_t v;
 	
-	//now process receiving
 	v = socUartPrvGetchar(uart);
 	if (v != UART_CHAR_NONE) {
 		
 		uart->cyclesSinceRecv = 0;
-		uart->LSR |= UART_LSR_DR;
 		
 		if (uart->FCR & UART_FCR_TRFIFOE) {	//fifo mode
 		
@@ -553,14 +564,41 @@ void socUartProcess(struct SocUart *uart)		//send and rceive up to one character
 			else
 				uart->receiveHolding = v;
 		}
+		uart->LSR |= UART_LSR_DR;
+		
+		return true;
 	}
 	else if (uart->cyclesSinceRecv <= 4) {
 		uart->cyclesSinceRecv++;
 	}
 	
+	return false;
+}
+
+void pxaUartProcess(struct SocUart *uart)		//send and rceive up to one character, or all we can in bulk mode
+{
+	if (!uart->bulk) {
+		
+		socUartPrvProcessTx(uart);
+		socUartPrvProcessRx(uart);
+	}
+	else {
+		
+		while (!(uart->LSR & UART_LSR_TEMT))
+			socUartPrvProcessTx(uart);
+		
+		//never overrun - the host side can hold on to the data until the guest makes room
+		while (socUartPrvRxHasRoom(uart) && socUartPrvProcessRx(uart));
+	}
+	
 	socUartPrvRecalc(uart);
 }
 
+void pxaUartSetBulk(struct SocUart *uart, bool bulk)
+{
+	uart->bulk = bulk;
+}
+
 static void socUartPrvRecalcCharBits(struct SocUart *uart, uint_fast16_t c)
 {
 	if (c & UART_CHAR_BREAK)
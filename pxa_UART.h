@@ -24,6 +24,11 @@
 #define PXA_HWUART_BASE	0x41600000UL		//PXA25x/PXA26x only
 
 
+struct SocUart* pxaUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t baseAddr, uint8_t irq);
+void pxaUartProcess(struct SocUart *uart);
+void pxaUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void *userData);
+void pxaUartSetBulk(struct SocUart *uart, bool bulk);
+
 
 #endif
 
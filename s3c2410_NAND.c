@@ -201,7 +201,7 @@ static bool s3c24xxNandPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t s
 	return true;
 }
 
-struct S3C24xxNand* s3c24xxNandInit(struct ArmMem *physMem, struct NAND *nandChip, struct SocIc *ic, struct SocGpio *gpio)
+struct S3C24xxNand* s3c2410NandInit(struct ArmMem *physMem, struct NAND *nandChip, struct SocIc *ic, struct SocGpio *gpio)
 {
 	struct S3C24xxNand *nand = (struct S3C24xxNand*)malloc(sizeof(*nand));
 	uint_fast8_t i;
@@ -219,7 +219,7 @@ struct S3C24xxNand* s3c24xxNandInit(struct ArmMem *physMem, struct NAND *nandChi
 	return nand;
 }
 
-void s3c24xxNandPeriodic(struct S3C24xxNand* nand)
+void s3c2410NandPeriodic(struct S3C24xxNand* nand)
 {
 	if (nand->nand)
 		nandPeriodic(nand->nand);
@@ -2,7 +2,7 @@
 
 #include "s3c24xx_NAND.h"
 #include "s3c24xx_IC.h"
-#include "soc_GPIO.h"
+#include "s3c24xx_GPIO.h"
 #include <string.h>
 #include <stdlib.h>
 #include "util.h"
@@ -529,11 +529,11 @@ static void s3c24xxNandPrvNandReadyCbk(void *userData, bool ready)
 		nand->nfstat |= 4;
 		
 		if (nand->nfcont & 0x200)											//int enabled?
-			socIcInt(nand->ic, S3C2440_I_NAND, true);
+			s3c24xxIcInt(nand->ic, S3C2440_I_NAND, true);
 	}
 }
 
-struct S3C24xxNand* s3c24xxNandInit(struct ArmMem *physMem, struct NAND *nandChip, struct SocIc *ic, struct SocGpio *gpio)
+struct S3C24xxNand* s3c2440NandInit(struct ArmMem *physMem, struct NAND *nandChip, struct SocIc *ic, struct SocGpio *gpio)
 {
 	struct S3C24xxNand *nand = (struct S3C24xxNand*)malloc(sizeof(*nand));
 	uint_fast8_t i;
@@ -548,13 +548,13 @@ struct S3C24xxNand* s3c24xxNandInit(struct ArmMem *physMem, struct NAND *nandChi
 	
 	//setup NFCONF's initial value
 	nand->nfconf = 0x1000;
-	if (socGpioGetState(gpio, 162) == SocGpioStateHigh)	//NCON
+	if (s3c24xxGpioGetState(gpio, 162) == SocGpioStateHigh)	//NCON
 		nand->nfconf |= 0x08;
-	if (socGpioGetState(gpio, 125) == SocGpioStateHigh)	//GPG13
+	if (s3c24xxGpioGetState(gpio, 125) == SocGpioStateHigh)	//GPG13
 		nand->nfconf |= 0x04;
-	if (socGpioGetState(gpio, 126) == SocGpioStateHigh)	//GPG14
+	if (s3c24xxGpioGetState(gpio, 126) == SocGpioStateHigh)	//GPG14
 		nand->nfconf |= 0x02;
-	if (socGpioGetState(gpio, 127) == SocGpioStateHigh)	//GPG15
+	if (s3c24xxGpioGetState(gpio, 127) == SocGpioStateHigh)	//GPG15
 		nand->nfconf |= 0x01;
 	
 	if (nandChip) {
@@ -568,7 +568,7 @@ struct S3C24xxNand* s3c24xxNandInit(struct ArmMem *physMem, struct NAND *nandChi
 	return nand;
 }
 
-void s3c24xxNandPeriodic(struct S3C24xxNand* nand)
+void s3c2440NandPeriodic(struct S3C24xxNand* nand)
 {
 	if (nand->nand)
 		nandPeriodic(nand->nand);
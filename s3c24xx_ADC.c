@@ -159,7 +159,7 @@ void s3c24xxAdcPeriodic(struct S3C24xxAdc *adc)
 				s3c24xxAdcPrvResult(adc, 1, adc->penY);
 				break;
 		}
-		socIcInt(adc->ic, S3C24XX_I_ADC, true);
+		s3c24xxIcInt(adc->ic, S3C24XX_I_ADC, true);
 	}
 }
 
@@ -192,7 +192,7 @@ void s3c24xxAdcSetPenPos(struct S3C24xxAdc *adc, int_fast16_t x, int_fast16_t y)
 	if (!adc->sentPenDn != !adc->penDown && (adc->adctsc & 3)) {	//pen down status changed
 		
 		if (!(adc->adctsc & 0x100) == !adc->sentPenDn)
-			socIcInt(adc->ic, S3C24XX_I_TC, true);
+			s3c24xxIcInt(adc->ic, S3C24XX_I_TC, true);
 	}
 }
 
@@ -1,7 +1,7 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
 #include "s3c24xx_IC.h"
-#include "soc_GPIO.h"
+#include "s3c24xx_GPIO.h"
 #include <string.h>
 #include <stdlib.h>
 #include "util.h"
@@ -136,12 +136,12 @@ static void socGpioPrvRecalc(struct SocGpio* gpio)
 			}
 		}
 	}
-	socIcInt(gpio->ic, S3C24XX_I_EINT0, !!(gpio->eintpend & 0x00000001UL));
-	socIcInt(gpio->ic, S3C24XX_I_EINT1, !!(gpio->eintpend & 0x00000002UL));
-	socIcInt(gpio->ic, S3C24XX_I_EINT2, !!(gpio->eintpend & 0x00000004UL));
-	socIcInt(gpio->ic, S3C24XX_I_EINT3, !!(gpio->eintpend & 0x00000008UL));
-	socIcInt(gpio->ic, S3C24XX_I_EINT4_7, !!(gpio->eintpend & 0x000000f0UL));
-	socIcInt(gpio->ic, S3C24XX_I_EINT8_23, !!(gpio->eintpend & 0x00ffff00UL));
+	s3c24xxIcInt(gpio->ic, S3C24XX_I_EINT0, !!(gpio->eintpend & 0x00000001UL));
+	s3c24xxIcInt(gpio->ic, S3C24XX_I_EINT1, !!(gpio->eintpend & 0x00000002UL));
+	s3c24xxIcInt(gpio->ic, S3C24XX_I_EINT2, !!(gpio->eintpend & 0x00000004UL));
+	s3c24xxIcInt(gpio->ic, S3C24XX_I_EINT3, !!(gpio->eintpend & 0x00000008UL));
+	s3c24xxIcInt(gpio->ic, S3C24XX_I_EINT4_7, !!(gpio->eintpend & 0x000000f0UL));
+	s3c24xxIcInt(gpio->ic, S3C24XX_I_EINT8_23, !!(gpio->eintpend & 0x00ffff00UL));
 }
 
 static bool socGpioPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* buf)
@@ -375,7 +375,7 @@ static bool socGpioPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 	return true;
 }
 
-struct SocGpio* socGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev)
+struct SocGpio* s3c24xxGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev)
 {
 	struct SocGpio *gpio = (struct SocGpio*)malloc(sizeof(*gpio));
 	
@@ -413,7 +413,7 @@ struct SocGpio* socGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8
 	return gpio;
 }
 
-void socGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
+void s3c24xxGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
 {
 	uint_fast8_t orig = gpioNum;
 	
@@ -454,7 +454,7 @@ void socGpioSetState(struct SocGpio *gpio, uint_fast8_t gpioNum, bool on)
 	socGpioPrvRecalc(gpio);
 }
 
-enum SocGpioState socGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
+enum SocGpioState s3c24xxGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
 {
 	uint_fast8_t orig = gpioNum;
 	
@@ -499,7 +499,7 @@ enum SocGpioState socGpioGetState(struct SocGpio *gpio, uint_fast8_t gpioNum)
 	return SocGpioStateNoSuchGpio;
 }
 
-void socGpioSetNotif(struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData)
+void s3c24xxGpioSetNotif(struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData)
 {
 	uint_fast8_t orig = gpioNum;
 	
@@ -533,7 +533,7 @@ void socGpioSetNotif(struct SocGpio *gpio, uint_fast8_t gpioNum, GpioChangedNoti
 	ERR("gpio pin %u does not support notification\n", orig);
 }
 
-void socGpioSetDirsChangedNotif(struct SocGpio *gpio, GpioDirsChangedF notifF, void *userData)
+void s3c24xxGpioSetDirsChangedNotif(struct SocGpio *gpio, GpioDirsChangedF notifF, void *userData)
 {
 	gpio->dirNotifF = notifF;
 	gpio->dirNotifD = userData;
@@ -0,0 +1,16 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _S3C24XX_GPIO_H_
+#define _S3C24XX_GPIO_H_
+
+#include "soc_GPIO.h"
+
+
+struct SocGpio* s3c24xxGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev);
+enum SocGpioState s3c24xxGpioGetState(struct SocGpio* gpio, uint_fast8_t gpioNum);
+void s3c24xxGpioSetState(struct SocGpio* gpio, uint_fast8_t gpioNum, bool on);
+void s3c24xxGpioSetNotif(struct SocGpio* gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData);
+void s3c24xxGpioSetDirsChangedNotif(struct SocGpio* gpio, GpioDirsChangedF notifF, void *userData);
+
+
+#endif
@@ -169,7 +169,7 @@ static bool socIcPrvMemAccessF(void *userData, uint32_t pa, uint_fast8_t size, b
 	return true;
 }
 
-struct SocIc* socIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev)
+struct SocIc* s3c24xxIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev)
 {
 	struct SocIc *ic = (struct SocIc*)malloc(sizeof(*ic));
 	uint_fast8_t i;
@@ -194,7 +194,7 @@ struct SocIc* socIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t
 	return ic;
 }
 
-void socIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise)		//interrupt caused by emulated hardware
+void s3c24xxIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise)		//interrupt caused by emulated hardware
 {
 	if (intNum >= S3C24XX_SUB_INTS_START) {
 		intNum -= S3C24XX_SUB_INTS_START;
@@ -54,6 +54,10 @@
 #define S3C24XX_I_UART0_RX		(S3C24XX_SUB_INTS_START + 0)
 
 
+struct SocIc* s3c24xxIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev);
+void s3c24xxIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise);
+
+
 #endif
 
 
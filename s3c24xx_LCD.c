@@ -2,9 +2,10 @@
 
 #include "s3c24xx_LCD.h"
 #include "s3c24xx_IC.h"
-#include "SDL2/SDL.h"
+#include "display.h"
 #include <string.h>
 #include <stdlib.h>
+#include "speed.h"
 #include "util.h"
 #include "mem.h"
 
@@ -15,15 +16,16 @@
 
 struct S3C24xxLcd {
 
-	SDL_Surface *mScreen;
-	SDL_Window *mWindow;
+	struct Display *disp;
 	struct ArmMem *mem;
+	struct ArmRam *ram;
 	struct SocIc *ic;
 	
 	uint32_t lcdcon1, lcdcon2, lcdcon3, lcdcon5, lcdsaddr1, lcdsaddr2, lcdsaddr3, redlut, greenlut, dithmode, tpal;
 	uint16_t lcdcon4, bluelut, pal[256];
 	uint8_t lcdintpnd, lcdsrcpnd, lcdintmsk, lpcsel;
 	bool hardGrafArea;
+	bool redrawAll;		//config or palette changed since we last drew
 };
 
 
@@ -31,7 +33,7 @@ static void s3c24xxLcdPrvUpdateInts(struct S3C24xxLcd *lcd)
 {
 	lcd->lcdintpnd |= lcd->lcdsrcpnd &~ lcd->lcdintmsk;
 	
-	socIcInt(lcd->ic, S3C24XX_I_LCD, !!lcd->lcdintpnd);
+	s3c24xxIcInt(lcd->ic, S3C24XX_I_LCD, !!lcd->lcdintpnd);
 }
 
 static bool s3c24xxLcdPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size, bool write, void* buf)
@@ -46,8 +48,12 @@ static bool s3c24xxLcdPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t si
 	
 	pa = (pa - S3C24XX_LCD_BASE) >> 2;
 	
-	if (write)
+	if (write) {
 		val = *(uint32_t*)buf;
+		
+		if (pa < 0x54 / 4 || pa > 0x5c / 4)	//all but interrupt regs may change what is on screen
+			lcd->redrawAll = true;
+	}
 	
 	if (pa >= 0x400 / 4) {
 		if (write)
@@ -201,64 +207,132 @@ static bool s3c24xxLcdPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t si
 
 //XXX: implement TPAL
 
-static uint16_t* s3c24xxLcdPrvGetFb(struct S3C24xxLcd *lcd, uint32_t w, uint32_t h)
+static void s3c24xxLcdPrvOpenDisplay(struct S3C24xxLcd *lcd, uint32_t w, uint32_t h)
 {
-	if (!lcd->mWindow) {
-		
-		uint32_t winH = h;
-		
-		if (lcd->hardGrafArea && w == h)
-			winH += 3 * w / 8;
-		
-		fprintf(stderr, "SCREEN configured for %u x %u\n", (unsigned)w, (unsigned)h);
-		lcd->mWindow = SDL_CreateWindow("uARM", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, w, winH, 0);
-		if (lcd->mWindow == NULL)
-			ERR("Couldn't create window: %s\n", SDL_GetError());
-		
-		lcd->mScreen = SDL_CreateRGBSurface(0, w, h, 16, 0xf800, 0x07e0, 0x001f, 0x0000);
-		if (lcd->mScreen == NULL)
-			ERR("Couldn't create screen surface: %s\n", SDL_GetError());
-	}
-	
-	SDL_LockSurface(lcd->mScreen);
-	return (uint16_t*)lcd->mScreen->pixels;
+	if (!lcd->disp)
+		lcd->disp = displayInit(w, h, (lcd->hardGrafArea && w == h) ? h + 3 * w / 8 : h);
 }
 
 static void s3c24xxLcdPrvReleaseFb(struct S3C24xxLcd *lcd)
 {
-	SDL_UnlockSurface(lcd->mScreen);
-	SDL_BlitSurface(lcd->mScreen, NULL, SDL_GetWindowSurface(lcd->mWindow), NULL);
-	SDL_UpdateWindowSurface(lcd->mWindow);
+	displayPublish(lcd->disp);
 }
 
-static uint32_t s3c24xxLcdPrvReadWord(struct S3C24xxLcd *lcd, uint32_t addr)	//swaps as needed
+//reads a row of words, swaps them as configured and stores them big-endian, which makes every mode a plain msb-first stream
+static void s3c24xxLcdPrvFetchRow(struct S3C24xxLcd *lcd, uint8_t *dst, uint32_t pa, uint32_t numWords)
 {
-	uint32_t val;
+	const uint32_t *src = (const uint32_t*)ramGetPtr(lcd->ram, pa, numWords * sizeof(uint32_t));
+	uint32_t i, val;
 	
-	if (!memAccess(lcd->mem, addr, sizeof(uint32_t), false, &val))
-		val = 0xaaaaaaaaul;
+	for (i = 0; i < numWords; i++, pa += sizeof(uint32_t)) {
+		
+		if (src)
+			val = src[i];
+		else if (!memAccess(lcd->mem, pa, sizeof(uint32_t), false, &val))
+			val = 0xaaaaaaaaul;
+		
+		switch (lcd->lcdcon5 & 3) {	//swapping
+			case 0:	//none
+				break;
+			case 1:	//halfwords
+				val = (val >> 16) | (val << 16);
+				break;
+			case 2:	//bytes
+				val = __builtin_bswap32(val);
+				break;
+			case 3:	//bytes & halwords (meaning byte sin halfwords)
+				val = ((val & 0xff00ff00ul) >> 8) | ((val << 8) & 0xff00ff00ul);
+				break;
+		}
+		
+		*dst++ = val >> 24;
+		*dst++ = val >> 16;
+		*dst++ = val >> 8;
+		*dst++ = val;
+	}
+}
+
+//pixel format and palette for the current mode. false if we do not know it
+static bool s3c24xxLcdPrvGetFormat(struct S3C24xxLcd *lcd, uint_fast8_t *fmtP, const uint16_t **palP, uint16_t *stnPal)
+{
+	static const uint16_t shades1[] = {0xffff, 0x0000};
+	static const uint16_t shades2[] = {0xffff, 0xA554, 0x52AA, 0x0000};
+	static const uint16_t shades4[] = {0xffff, 0xef7d, 0xdefb, 0xce59, 0xbdd7, 0xad55, 0x9cd3, 0x8c51, 0x73ae, 0x632c, 0x52aa, 0x4228, 0x31a6, 0x2104, 0x1082, 0x0000, };
+	uint_fast16_t i;
+	
+	*palP = NULL;
 	
-	switch (lcd->lcdcon5 & 3) {	//swapping
-		case 0:	//none
+	switch ((lcd->lcdcon1 >> 1) & 0x0f) {
+		case 0x00:	//STN 1bpp
+		case 0x08:	//LCD 1bpp
+			*fmtP = DisplayPixPal1 | DISPLAY_PIX_MSB_FIRST;
+			*palP = shades1;
+			break;
+		
+		case 0x01:	//STN 2bpp
+		case 0x09:	//TFT 2bpp
+			*fmtP = DisplayPixPal2 | DISPLAY_PIX_MSB_FIRST;
+			*palP = shades2;
+			break;
+		
+		case 0x02:	//STN 4bpp
+		case 0x0a:	//TFT 4bpp
+			*fmtP = DisplayPixPal4 | DISPLAY_PIX_MSB_FIRST;
+			*palP = shades4;
+			break;
+		
+		case 0x03:	//STN 8bpp - direct color, 3:3:2 through the LUTs
+			for (i = 0; i < 256; i++) {
+				
+				static const uint8_t gamma5[] = {0x0, 0x2, 0x4, 0x6, 0x8, 0xa, 0xc, 0xe, 0x11, 0x13, 0x15, 0x17, 0x19, 0x1b, 0x1d, 0x1f, };
+				static const uint8_t gamma6[] = {0x0, 0x4, 0x8, 0xd, 0x11, 0x15, 0x19, 0x1d, 0x22, 0x26, 0x2a, 0x2e, 0x32, 0x37, 0x3b, 0x3f, };
+				uint_fast16_t rv = (lcd->redlut >> (((i >> 5) & 7) * 4)) & 0x0f;
+				uint_fast16_t gv = (lcd->greenlut >> (((i >> 2) & 7) * 4)) & 0x0f;
+				uint_fast16_t bv = (lcd->bluelut >> ((i & 3) * 4)) & 0x0f;
+				
+				stnPal[i] = (((uint_fast16_t)gamma5[rv]) << 11) | (((uint_fast16_t)gamma6[gv]) << 5) | gamma5[bv];
+			}
+			*fmtP = DisplayPixPal8;
+			*palP = stnPal;
+			break;
+		
+		case 0x04:	//STN 12bpp - direct color
+			*fmtP = DisplayPixRgb444Packed | DISPLAY_PIX_MSB_FIRST;
+			break;
+		
+		case 0x05:	//STN 12bit unpacked - S3C2440 only
+			*fmtP = DisplayPixRgb444 | DISPLAY_PIX_BIG_ENDIAN;
 			break;
-		case 1:	//halfwords
-			val = (val >> 16) | (val << 16);
+		
+		case 0x06:	//STN 16bit - S3C2440 only
+		case 0x0c:	//TFT 16bpp
+			*fmtP = DisplayPixRgb565 | DISPLAY_PIX_BIG_ENDIAN;
 			break;
-		case 2:	//bytes
-			val = __builtin_bswap32(val);
+		
+		case 0x0b:	//TFT 8bpp
+			*fmtP = DisplayPixPal8;
+			*palP = lcd->pal;
 			break;
-		case 3:	//bytes & halwords (meaning byte sin halfwords)
-			val = ((val & 0xff00ff00ul) >> 8) | ((val << 8) & 0xff00ff00ul);
+		
+		case 0x0d:	//TFT 24bpp
+			*fmtP = DisplayPixRgb888 | DISPLAY_PIX_BIG_ENDIAN;
 			break;
+		
+		default:
+			return false;
 	}
 	
-	return val;
+	return true;
 }
 
 void s3c24xxLcdPeriodic(struct S3C24xxLcd *lcd)
 {
-	uint32_t i, w, h;
-	uint16_t *px;
+	uint32_t r, w, h, pa, fbPa, rowBytes, rowWords, strideExtra;
+	uint16_t stnPal[256];
+	uint8_t rowBuf[2048 * 4];
+	const uint16_t *pal;
+	uint_fast8_t fmt;
+	bool all;
 	
 	if (!(lcd->lcdcon1 & 1))	//if lcd is off, nothing to do
 		return;
@@ -328,241 +402,49 @@ void s3c24xxLcdPeriodic(struct S3C24xxLcd *lcd)
 	//set LINECNT again
 	lcd->lcdcon1 |= (lcd->lcdcon2 << 4) & 0x0ffc0000ul;
 	
-	px = s3c24xxLcdPrvGetFb(lcd, w, h);
+	fbPa = (lcd->lcdsaddr1 << 1) & 0x7ffffffeul;
+	strideExtra = 2 * ((lcd->lcdsaddr3 >> 11) & 0x7ff);
+	if (!s3c24xxLcdPrvGetFormat(lcd, &fmt, &pal, stnPal))
+		ERR("LCD color mode 0x0%x\n", (unsigned)((lcd->lcdcon1 >> 1) & 0x0f));
+	rowWords = (displayRowBytes(fmt, w) + 3) / 4;
+	rowBytes = rowWords * 4;
+	
+	if (rowBytes > sizeof(rowBuf))
+		ERR("LCD row of %u bytes is too long\n", (unsigned)rowBytes);
+	
+	//only rows written since we last drew need converting, unless something else changed
+	all = lcd->redrawAll;
+	if (!all && ((lcd->tpal & 0x01000000ul) || !ramDirtyTest(lcd->ram, fbPa, h * (rowBytes + strideExtra))))
+		goto lcd_done;
+	
+	if (speedShouldSkipFrame())	//behind real time - do not draw this one
+		goto lcd_done;
+	
+	s3c24xxLcdPrvOpenDisplay(lcd, w, h);
 	
 	if (lcd->tpal & 0x01000000ul) {	//TPAL
 		
-		uint32_t v = ((lcd->tpal >> 8) & 0xf800) | ((lcd->tpal >> 5) & 0x07e0) | ((lcd->tpal >> 3) * 0x001f);
+		uint32_t v = ((lcd->tpal >> 8) & 0xf800) | ((lcd->tpal >> 5) & 0x07e0) | ((lcd->tpal >> 3) & 0x001f);
 		
-		for (i = 0; i < w * h; i++)
-			*px++ = v;
+		displayFill(lcd->disp, v);
 	}
-	else {
-		static const uint8_t gamma5[] = {0x0, 0x2, 0x4, 0x6, 0x8, 0xa, 0xc, 0xe, 0x11, 0x13, 0x15, 0x17, 0x19, 0x1b, 0x1d, 0x1f, };
-		static const uint8_t gamma6[] = {0x0, 0x4, 0x8, 0xd, 0x11, 0x15, 0x19, 0x1d, 0x22, 0x26, 0x2a, 0x2e, 0x32, 0x37, 0x3b, 0x3f, };
-		uint32_t r, c, t, v, pa = (lcd->lcdsaddr1 << 1) & 0x7ffffffeul, strideExtra = 2 * ((lcd->lcdsaddr3 >> 11) & 0x7ff);
-		
-		for (r = 0; r < h; r++, pa += strideExtra) {
-			
-			switch ((lcd->lcdcon1 >> 1) & 0x0f) {
-				case 0x00:	//STN 1bpp
-				case 0x08:	//LCD 1bpp
-					for (c = 0; c < w; c += 32, pa += 4) {
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						
-						for (i = 0; i < 32; i++, v <<= 1)
-							*px++ = (v >> 31) ? 0 : 0xffff;
-					}
-					break;
-				
-				case 0x01:	//STN 2bpp
-				case 0x09:	//TFT 2bpp
-					for (c = 0; c < w; c += 16, pa += 4) {
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						
-						for (i = 0; i < 16; i++, v <<= 2) {
-							static const uint16_t shades[] = {0xffff, 0xA554, 0x52AA, 0x0000};
-							
-							*px++ = shades[v >> 30];
-						}
-					}
-					break;
-				
-				case 0x02:	//STN 4bpp
-				case 0x0a:	//TFT 4bpp
-					for (c = 0; c < w; c += 8, pa += 4) {
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						
-						for (i = 0; i < 8; i++, v <<= 4) {
-							static const uint16_t shades[] = {0xffff, 0xef7d, 0xdefb, 0xce59, 0xbdd7, 0xad55, 0x9cd3, 0x8c51, 0x73ae, 0x632c, 0x52aa, 0x4228, 0x31a6, 0x2104, 0x1082, 0x0000, };
-							
-							*px++ = shades[v >> 28];
-						}
-					}
-					break;
-				
-				case 0x03:	//STN 8bpp - direct color
-					for (c = 0; c < w; c += 4, pa += 4) {
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						
-						for (i = 0; i < 4; i++, v <<= 8) {
-							
-							static const uint8_t gamma5[] = {0x0, 0x2, 0x4, 0x6, 0x8, 0xa, 0xc, 0xe, 0x11, 0x13, 0x15, 0x17, 0x19, 0x1b, 0x1d, 0x1f, };
-							static const uint8_t gamma6[] = {0x0, 0x4, 0x8, 0xd, 0x11, 0x15, 0x19, 0x1d, 0x22, 0x26, 0x2a, 0x2e, 0x32, 0x37, 0x3b, 0x3f, };
-							
-							
-							//get components
-							uint_fast8_t pv = v >> 24;
-							uint_fast8_t rv = (pv >> 5) & 7;
-							uint_fast8_t gv = (pv >> 2) & 7;
-							uint_fast8_t bv = (pv & 3);
-							
-							//lookup
-							rv = (lcd->redlut >> (rv * 4)) & 0x0f;
-							gv = (lcd->greenlut >> (gv * 4)) & 0x0f;
-							bv = (lcd->bluelut >> (bv * 4)) & 0x0f;
-							
-							//expand to our bit withs
-							rv = gamma5[rv];
-							gv = gamma6[gv];
-							bv = gamma5[bv];
-							
-							//to one pixel
-							t = rv;
-							t <<= 5;
-							t += gv;
-							t <<= 6;
-							t += bv;
-							
-							*px++ = t;
-						}
-					}
-					break;
-				
-				case 0x04:	//STN 12bpp - direct color
-					for (c = 0; c < w; c += 8) {
-						
-						uint_fast8_t rv = 0, gv = 0, bv = 0, cc, bc;
-						
-						for (bc = 0, cc = 0, i = 0; i < 24; i++, v <<= 4, bc--) {
-							
-							if (!bc) {
-								bc = 8;
-								v = s3c24xxLcdPrvReadWord(lcd, pa);
-								pa += 4;
-							}
-							
-							switch (cc++) {
-								case 0:
-									rv = v >> 28;
-									break;
-								case 1:
-									gv = v >> 28;
-									break;
-								case 2:
-									bv = v >> 28;
-									
-									//expand to our bit withs
-									rv = gamma5[rv];
-									gv = gamma6[gv];
-									bv = gamma5[bv];
-									
-									//to one pixel
-									t = rv;
-									t <<= 6;
-									t += gv;
-									t <<= 5;
-									t += bv;
-									
-									*px++ = t;
-									cc = 0;
-							}
-						}
-					}
-					break;
-				
-				case 0x05:		//STN 12bit unpacked - S3C2440 only
-					for (c = 0; c < w; c += 2, pa += 4) {
-						uint_fast8_t rv = 0, gv = 0, bv = 0;
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						
-						for (i = 0; i < 2; i++, v <<= 16) {
-							rv = (v >> 24) & 0x0f;
-							gv = (v >> 20) & 0x0f;
-							bv = (v >> 16) & 0x0f;
-							
-							//expand to our bit withs
-							rv = gamma5[rv];
-							gv = gamma6[gv];
-							bv = gamma5[bv];
-							
-							//to one pixel
-							t = rv;
-							t <<= 6;
-							t += gv;
-							t <<= 5;
-							t += bv;
-							
-							*px++ = t;
-							
-						}
-					}
-					break;
-				
-				case 0x06:		//STN 16bit - S3C2440 only
-					for (c = 0; c < w; c += 2, pa += 4) {
-						uint_fast8_t rv = 0, gv = 0, bv = 0;
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						
-						for (i = 0; i < 2; i++, v <<= 16) {
-							rv = (v >> 28) & 0x0f;	//collapse to 4-bit data
-							gv = (v >> 23) & 0x0f;
-							bv = (v >> 17) & 0x0f;
-							
-							//expand to our bit withs
-							rv = gamma5[rv];
-							gv = gamma6[gv];
-							bv = gamma5[bv];
-							
-							//to one pixel
-							t = rv;
-							t <<= 6;
-							t += gv;
-							t <<= 5;
-							t += bv;
-							
-							*px++ = t;
-							
-						}
-					}
-					break;
-				
-				case 0x0b:		//TFT 8bpp
-					for (c = 0; c < w; c += 4, pa += 4) {
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						
-						for (i = 0; i < 4; i++, v <<= 8) {
-							
-							*px++ = lcd->pal[v >> 24];
-						}
-					}
-					break;
-				
-				case 0x0c:		//TFT 16bpp
-					for (c = 0; c < w; c += 2, pa += 4) {
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						*px++ = v >> 16;
-						*px++ = v;
-					}
-					break;
-				
-				case 0x0d:		//TFT 24bpp
-					for (c = 0; c < w; c++, pa += 4) {
-						uint_fast8_t rv, gv, bv;
-						
-						v = s3c24xxLcdPrvReadWord(lcd, pa);
-						
-						rv = (v >> 16) & 0xff;
-						gv = (v >> 8) & 0xff;
-						bv = (v >> 0) & 0xff;
-						
-						*px++ = (((uint32_t)(rv & 0xf8)) << 8) | (((uint32_t)(gv & 0xfc)) << 3) | (bv >> 3);
-					}
-					break;
-				
-				default:
-					ERR("LCD color mode 0x0%x\n", (unsigned)((lcd->lcdcon1 >> 1) & 0x0f));
-					break;
-			}
-		}
+	else for (r = 0, pa = fbPa; r < h; r++, pa += rowBytes + strideExtra) {
+		
+		if (!all && !ramDirtyTest(lcd->ram, pa, rowBytes))
+			continue;
+		
+		s3c24xxLcdPrvFetchRow(lcd, rowBuf, pa, rowWords);
+		displayDrawRow(lcd->disp, r, rowBuf, w, fmt, pal);
 	}
+	ramDirtyClear(lcd->ram, fbPa, h * (rowBytes + strideExtra));
+	lcd->redrawAll = false;
 	s3c24xxLcdPrvReleaseFb(lcd);
 
 lcd_done:
 	s3c24xxLcdPrvUpdateInts(lcd);
 }
 
-struct S3C24xxLcd* s3c24xxLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardGrafArea)
+struct S3C24xxLcd* s3c24xxLcdInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic, bool hardGrafArea)
 {
 	struct S3C24xxLcd *lcd = (struct S3C24xxLcd*)malloc(sizeof(*lcd));
 	
@@ -571,14 +453,18 @@ struct S3C24xxLcd* s3c24xxLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool
 	
 	memset(lcd, 0, sizeof (*lcd));
 	lcd->mem = physMem;
+	lcd->ram = ram;
 	lcd->ic = ic;
 	lcd->hardGrafArea = hardGrafArea;
 	lcd->lcdintmsk = 3;
 	lcd->lpcsel = 4;
+	lcd->redrawAll = true;
 	
 	if (!memRegionAdd(physMem, S3C24XX_LCD_BASE, S3C24XX_LCD_SIZE, s3c24xxLcdPrvMemAccessF, lcd))
 		ERR("cannot add LCD to MEM\n");
 	
+	ramDirtyTrack(ram);
+	
 	return lcd;
 }
 
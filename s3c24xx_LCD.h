@@ -4,6 +4,7 @@
 #define _S3C24XX_LCD_H_
 
 #include "mem.h"
+#include "RAM.h"
 #include "CPU.h"
 #include "soc_IC.h"
 
@@ -11,7 +12,7 @@ struct S3C24xxLcd;
 
 
 
-struct S3C24xxLcd* s3c24xxLcdInit(struct ArmMem *physMem, struct SocIc *ic, bool hardGrafArea);
+struct S3C24xxLcd* s3c24xxLcdInit(struct ArmMem *physMem, struct ArmRam *ram, struct SocIc *ic, bool hardGrafArea);
 void s3c24xxLcdPeriodic(struct S3C24xxLcd *lcd);
 
 
@@ -11,8 +11,11 @@
 struct S3C24xxNand;
 
 
-struct S3C24xxNand* s3c24xxNandInit(struct ArmMem *physMem, struct NAND *nandChip, struct SocIc *ic, struct SocGpio *gpio);
-void s3c24xxNandPeriodic(struct S3C24xxNand* nand);
+//the S3C2410 and S3C2440 each have their own, both are built and the SoC picks by its revision
+struct S3C24xxNand* s3c2410NandInit(struct ArmMem *physMem, struct NAND *nandChip, struct SocIc *ic, struct SocGpio *gpio);
+void s3c2410NandPeriodic(struct S3C24xxNand* nand);
+struct S3C24xxNand* s3c2440NandInit(struct ArmMem *physMem, struct NAND *nandChip, struct SocIc *ic, struct SocGpio *gpio);
+void s3c2440NandPeriodic(struct S3C24xxNand* nand);
 
 
 
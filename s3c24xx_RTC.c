@@ -232,7 +232,7 @@ void s3c24xxRtcPeriodic(struct S3C24xxRtc *rtc)
 			rtc->ticntCounter--;
 		else {
 			rtc->ticntCounter = rtc->ticnt & 0x7f;
-			socIcInt(rtc->ic, S3C24XX_I_TICK, true);
+			s3c24xxIcInt(rtc->ic, S3C24XX_I_TICK, true);
 		}
 	}
 	
@@ -261,7 +261,7 @@ void s3c24xxRtcPeriodic(struct S3C24xxRtc *rtc)
 				(!(rtc->rtcalm & 0x04) || (rtc->bcdhour == rtc->almhour)) &&
 				(!(rtc->rtcalm & 0x02) || (rtc->bcdmin == rtc->almmin)) &&
 				(!(rtc->rtcalm & 0x01) || (rtc->bcdsec == rtc->almsec)))
-			socIcInt(rtc->ic, S3C24XX_I_RTC, true);
+			s3c24xxIcInt(rtc->ic, S3C24XX_I_RTC, true);
 	}	
 }
 
@@ -46,7 +46,7 @@ static void s3c24xxSdioPrvRecalc(struct S3C24xxSdio *sdio)
 	//not addressed - NoBusyInt - S2440 only
 	//not addressed - FFfailInt - do our fifs even fail?
 	
-	socIcInt(sdio->ic, S3C24XX_I_SDIO, !!irq);
+	s3c24xxIcInt(sdio->ic, S3C24XX_I_SDIO, !!irq);
 }
 
 static bool s3c24xxSdioPrvFifoW(struct S3C24xxSdio *sdio, uint32_t val, uint_fast8_t size)
@@ -160,7 +160,7 @@ static void s3c24xxTimersPrvTimerTick(struct S3C24xxTimers* tmr, uint_fast8_t id
 				ERR("dma not yet implemented for timers\n");
 			}
 			else
-				socIcInt(tmr->ic, S3C24XX_I_TIMER0 + idx, true);
+				s3c24xxIcInt(tmr->ic, S3C24XX_I_TIMER0 + idx, true);
 		}
 	}
 }
@@ -1,6 +1,7 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
 #include "s3c24xx_UART.h"
+#include "s3c24xx_IC.h"
 #include <string.h>
 #include <stdlib.h>
 #include "util.h"
@@ -52,9 +53,9 @@ static void socUartPrvRecalc(struct SocUart* uart)
 	
 	//XXX: DMA
 	
-	socIcInt(uart->ic, uart->irqBase + IRQ_ADD_ERROR, false);
-	socIcInt(uart->ic, uart->irqBase + IRQ_ADD_RX, false);
-	socIcInt(uart->ic, uart->irqBase + IRQ_ADD_TX, false);
+	s3c24xxIcInt(uart->ic, uart->irqBase + IRQ_ADD_ERROR, false);
+	s3c24xxIcInt(uart->ic, uart->irqBase + IRQ_ADD_RX, false);
+	s3c24xxIcInt(uart->ic, uart->irqBase + IRQ_ADD_TX, false);
 }
 
 
@@ -189,7 +190,7 @@ static bool socUartPrvMemAccessF(void* userData, uint32_t pa, uint_fast8_t size,
 }
 
 
-struct SocUart* socUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t baseAddr, uint8_t irqBase)
+struct SocUart* s3c24xxUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t baseAddr, uint8_t irqBase)
 {
 	struct SocUart *uart = (struct SocUart*)malloc(sizeof(*uart));
 	
@@ -227,7 +228,7 @@ static void socUartPrvDefaultWrite(uint_fast16_t chr, void *userData)				//these
 	//nothing to do here
 }
 
-void socUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void *userData)
+void s3c24xxUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void *userData)
 {
 	if (!readF)
 		readF = socUartPrvDefaultRead;		//these are special funcs since they get their own private data - the uart :)
@@ -239,9 +240,14 @@ void socUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF wri
 	uart->accessFuncsData = userData;
 }
 
-void socUartProcess(struct SocUart *uart)
+void s3c24xxUartProcess(struct SocUart *uart)
 {
 	//todo
 }
 
+void s3c24xxUartSetBulk(struct SocUart *uart, bool bulk)
+{
+	//no data moves yet, so nothing to do
+}
 
+
@@ -23,6 +23,10 @@
 #define S3C24XX_UART2_BASE		0x50008000UL
 
 
+struct SocUart* s3c24xxUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t baseAddr, uint8_t irq);
+void s3c24xxUartProcess(struct SocUart *uart);
+void s3c24xxUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void *userData);
+void s3c24xxUartSetBulk(struct SocUart *uart, bool bulk);
 
 
 #endif
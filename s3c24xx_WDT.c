@@ -118,7 +118,7 @@ void s3c24xxWdtPeriodic(struct S3C24xxWdt *wdt)
 				ERR("WDT resets device\n");
 			
 			if (wdt->wtcon & 0x04)
-				socIcInt(wdt->ic, wdt->soc40 ? S3C2440_I_WDT : S3C2410_I_WDT, true);
+				s3c24xxIcInt(wdt->ic, wdt->soc40 ? S3C2440_I_WDT : S3C2410_I_WDT, true);
 		}
 	}
 }
@@ -0,0 +1,816 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#define _GNU_SOURCE		//SEEK_DATA, SEEK_HOLE
+
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include "sdstore.h"
+#include "endian.h"
+#include "util.h"
+
+
+#define SDSTORE_LINE_SECS		128				//64KB lines: a miss reads this much
+#define SDSTORE_LINE_BYTES		(SDSTORE_LINE_SECS * SDSTORE_SECTOR_SIZE)
+#define SDSTORE_READAHEAD		4				//lines read at once on a sequential miss
+#define SDSTORE_MIN_LINES		(2 * SDSTORE_READAHEAD)
+#define SDSTORE_FLUSH_SEC		1				//dirty data never stays in memory much longer than this
+#define SDSTORE_NO_CHUNK		0xffffffffUL
+
+//delta files: a header sector, the first-level map (where each second-level map is, in sectors, 0 for none), then
+//second-level maps and sector data in the order they were needed. a second-level map entry says where in the delta
+//that sector is, or that it is all zeroes, or (0) that it was never written. all little-endian
+#define SDSTORE_DELTA_MAGIC		"uARMsdDt"
+#define SDSTORE_DELTA_VER		1
+#define SDSTORE_MAP_SHIFT		12				//each second-level map covers 2MB
+#define SDSTORE_MAP_SECS		(1UL << SDSTORE_MAP_SHIFT)
+#define SDSTORE_MAP_BYTES		(SDSTORE_MAP_SECS * sizeof(uint32_t))
+
+#define SDSTORE_IN_BASE			0				//sector locations
+#define SDSTORE_ZERO			0xffffffffUL
+
+
+struct SdDeltaHdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t numMaps;
+	uint64_t baseSize;
+};
+
+struct SdLine {
+	uint32_t chunk;										//which SDSTORE_LINE_BYTES piece of the image, or SDSTORE_NO_CHUNK
+	uint64_t lastUse;
+	uint64_t valid[SDSTORE_LINE_SECS / 64];				//per-sector bitmaps
+	uint64_t dirty[SDSTORE_LINE_SECS / 64];
+	bool isDirty;
+	uint8_t *data;
+};
+
+struct SdStore {
+	int fd;						//the image. read-only under a delta
+	uint64_t size;
+	uint64_t *haveData;			//per chunk of the image: not a hole, so worth reading
+
+	int deltaFd;				//-1 if none
+	uint32_t numMaps, deltaEnd;
+	uint32_t *mapPos;			//first-level map
+	uint32_t **maps;			//second-level maps we have, in host order
+
+	uint32_t numLines, numDirty, lastMissChunk;
+	uint64_t useCtr;
+	struct SdLine *lines, *mru;
+	uint8_t *scratch;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t flusher;
+	bool stop;
+
+	//stats
+	uint64_t secHits, secMisses, secsRead, secsWritten, sysReads, sysWrites;
+};
+
+
+static struct SdStore *mStore = NULL;	//for the exit handler
+
+
+
+static bool sdStorePrvTest(const uint64_t *bits, uint32_t idx)
+{
+	return (bits[idx / 64] >> (idx % 64)) & 1;
+}
+
+static void sdStorePrvSet(uint64_t *bits, uint32_t idx)
+{
+	bits[idx / 64] |= 1ULL << (idx % 64);
+}
+
+static uint32_t sdStorePrvChunkBytes(struct SdStore *sd, uint32_t chunk)	//last one may be short
+{
+	uint64_t start = (uint64_t)chunk * SDSTORE_LINE_BYTES;
+
+	return (sd->size - start < SDSTORE_LINE_BYTES) ? (uint32_t)(sd->size - start) : SDSTORE_LINE_BYTES;
+}
+
+static bool sdStorePrvIsZero(const uint8_t *sector)
+{
+	const uint64_t *p = (const uint64_t*)sector;
+	uint32_t i;
+
+	for (i = 0; i < SDSTORE_SECTOR_SIZE / sizeof(uint64_t); i++) {
+		if (p[i])
+			return false;
+	}
+
+	return true;
+}
+
+static uint32_t sdStorePrvDeltaLoc(struct SdStore *sd, uint32_t sec)		//SDSTORE_IN_BASE if the delta does not have it
+{
+	const uint32_t *map;
+
+	if (sd->deltaFd < 0 || !(map = sd->maps[sec >> SDSTORE_MAP_SHIFT]))
+		return SDSTORE_IN_BASE;
+
+	return map[sec & (SDSTORE_MAP_SECS - 1)];
+}
+
+static uint32_t sdStorePrvLocate(struct SdStore *sd, uint32_t sec)
+{
+	uint32_t loc = sdStorePrvDeltaLoc(sd, sec);
+
+	if (loc == SDSTORE_IN_BASE && !sdStorePrvTest(sd->haveData, sec / SDSTORE_LINE_SECS))
+		loc = SDSTORE_ZERO;			//a hole in the image
+
+	return loc;
+}
+
+//sectors from wherever they are: the image, the delta, or nowhere if they are known to be zero. one read per contiguous run
+static bool sdStorePrvReadSecs(struct SdStore *sd, uint32_t sec, uint8_t *buf, uint32_t num)
+{
+	uint32_t i, j, loc, len;
+	uint64_t ofst;
+	int fd;
+
+	for (i = 0; i < num; i = j) {
+
+		loc = sdStorePrvLocate(sd, sec + i);
+		for (j = i + 1; j < num; j++) {
+
+			uint32_t next = sdStorePrvLocate(sd, sec + j);
+
+			if ((loc == SDSTORE_IN_BASE || loc == SDSTORE_ZERO) ? next != loc : next != loc + (j - i))
+				break;
+		}
+
+		len = (j - i) * SDSTORE_SECTOR_SIZE;
+		if (loc == SDSTORE_ZERO) {
+			memset(buf + i * SDSTORE_SECTOR_SIZE, 0, len);
+			continue;
+		}
+
+		fd = (loc == SDSTORE_IN_BASE) ? sd->fd : sd->deltaFd;
+		ofst = (uint64_t)((loc == SDSTORE_IN_BASE) ? sec + i : loc) * SDSTORE_SECTOR_SIZE;
+		sd->sysReads++;
+		if (pread(fd, buf + i * SDSTORE_SECTOR_SIZE, len, ofst) != len) {
+			perror("SD card image read failed");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static uint32_t* sdStorePrvDeltaMap(struct SdStore *sd, uint32_t mapIdx)	//creates it if needed
+{
+	uint32_t pos = sd->deltaEnd, posLe = htole32(pos);
+	uint32_t *map = sd->maps[mapIdx];
+
+	if (map)
+		return map;
+
+	map = (uint32_t*)calloc(SDSTORE_MAP_SECS, sizeof(uint32_t));
+	if (!map)
+		ERR("cannot alloc SD delta map\n");
+
+	//an empty map first, then the pointer to it
+	sd->sysWrites += 2;
+	if (pwrite(sd->deltaFd, map, SDSTORE_MAP_BYTES, (uint64_t)pos * SDSTORE_SECTOR_SIZE) != SDSTORE_MAP_BYTES ||
+			pwrite(sd->deltaFd, &posLe, sizeof(posLe), SDSTORE_SECTOR_SIZE + mapIdx * sizeof(uint32_t)) != sizeof(posLe)) {
+		perror("SD card delta write failed");
+		free(map);
+		return NULL;
+	}
+
+	sd->deltaEnd += SDSTORE_MAP_BYTES / SDSTORE_SECTOR_SIZE;
+	sd->mapPos[mapIdx] = pos;
+
+	return sd->maps[mapIdx] = map;
+}
+
+//sectors the delta has are rewritten in place, new ones appended unless all zeroes. data goes out before the map entries pointing to it
+static bool sdStorePrvDeltaWrite(struct SdStore *sd, uint32_t sec, const uint8_t *buf, uint32_t num)
+{
+	uint32_t i, j, len, now, loc[SDSTORE_LINE_SECS], ent[SDSTORE_LINE_SECS], *map;
+
+	for (; num; num -= now, sec += now, buf += now * SDSTORE_SECTOR_SIZE) {
+
+		now = num < SDSTORE_LINE_SECS ? num : SDSTORE_LINE_SECS;
+
+		for (i = 0; i < now; i++) {
+
+			uint32_t cur = sdStorePrvDeltaLoc(sd, sec + i);
+
+			if (cur != SDSTORE_IN_BASE && cur != SDSTORE_ZERO)		//reused even for zeroes, so the delta never grows past one copy of each sector
+				loc[i] = cur;
+			else if (sdStorePrvIsZero(buf + i * SDSTORE_SECTOR_SIZE))
+				loc[i] = SDSTORE_ZERO;
+			else
+				loc[i] = sd->deltaEnd++;
+		}
+
+		for (i = 0; i < now; i = j) {
+
+			if (loc[i] == SDSTORE_ZERO) {
+				j = i + 1;
+				continue;
+			}
+			for (j = i + 1; j < now && loc[j] == loc[i] + (j - i); j++);
+
+			len = (j - i) * SDSTORE_SECTOR_SIZE;
+			sd->sysWrites++;
+			if (pwrite(sd->deltaFd, buf + i * SDSTORE_SECTOR_SIZE, len, (uint64_t)loc[i] * SDSTORE_SECTOR_SIZE) != len) {
+				perror("SD card delta write failed");
+				return false;
+			}
+		}
+
+		//one map update per second-level map touched
+		for (i = 0; i < now; i = j) {
+
+			uint32_t mapIdx = (sec + i) >> SDSTORE_MAP_SHIFT, first = (sec + i) & (SDSTORE_MAP_SECS - 1);
+
+			map = sdStorePrvDeltaMap(sd, mapIdx);
+			if (!map)
+				return false;
+
+			for (j = i; j < now && ((sec + j) >> SDSTORE_MAP_SHIFT) == mapIdx; j++) {
+				map[first + j - i] = loc[j];
+				ent[j - i] = htole32(loc[j]);
+			}
+
+			len = (j - i) * sizeof(uint32_t);
+			sd->sysWrites++;
+			if (pwrite(sd->deltaFd, ent, len, (uint64_t)sd->mapPos[mapIdx] * SDSTORE_SECTOR_SIZE + first * sizeof(uint32_t)) != len) {
+				perror("SD card delta write failed");
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool sdStorePrvWriteSecs(struct SdStore *sd, uint32_t sec, const uint8_t *buf, uint32_t num)
+{
+	uint32_t len = num * SDSTORE_SECTOR_SIZE, chunk;
+
+	if (sd->deltaFd >= 0)
+		return sdStorePrvDeltaWrite(sd, sec, buf, num);
+
+	sd->sysWrites++;
+	if (pwrite(sd->fd, buf, len, (uint64_t)sec * SDSTORE_SECTOR_SIZE) != len) {
+		perror("SD card image write failed");
+		return false;
+	}
+	for (chunk = sec / SDSTORE_LINE_SECS; chunk <= (sec + num - 1) / SDSTORE_LINE_SECS; chunk++)
+		sdStorePrvSet(sd->haveData, chunk);
+
+	return true;
+}
+
+static bool sdStorePrvWriteBack(struct SdStore *sd, struct SdLine *line)
+{
+	uint32_t i, j;
+
+	if (!line->isDirty)
+		return true;
+
+	//one write per run of dirty sectors
+	for (i = 0; i < SDSTORE_LINE_SECS; i = j) {
+
+		if (!sdStorePrvTest(line->dirty, i)) {
+			j = i + 1;
+			continue;
+		}
+
+		for (j = i + 1; j < SDSTORE_LINE_SECS && sdStorePrvTest(line->dirty, j); j++);
+
+		if (!sdStorePrvWriteSecs(sd, line->chunk * SDSTORE_LINE_SECS + i, line->data + i * SDSTORE_SECTOR_SIZE, j - i))
+			return false;
+	}
+
+	memset(line->dirty, 0, sizeof(line->dirty));
+	line->isDirty = false;
+	sd->numDirty--;
+
+	return true;
+}
+
+static bool sdStorePrvFlushAll(struct SdStore *sd)
+{
+	bool ret = true;
+	uint32_t i;
+
+	for (i = 0; i < sd->numLines && sd->numDirty; i++)
+		ret = sdStorePrvWriteBack(sd, &sd->lines[i]) && ret;
+
+	return ret;
+}
+
+static struct SdLine* sdStorePrvFind(struct SdStore *sd, uint32_t chunk)
+{
+	uint32_t i;
+
+	if (sd->mru && sd->mru->chunk == chunk)
+		return sd->mru;
+
+	for (i = 0; i < sd->numLines; i++) {
+		if (sd->lines[i].chunk == chunk)
+			return sd->mru = &sd->lines[i];
+	}
+
+	return NULL;
+}
+
+//a free (or least recently used, written back) line for the given chunk, with nothing valid in it
+static struct SdLine* sdStorePrvAlloc(struct SdStore *sd, uint32_t chunk)
+{
+	struct SdLine *line = &sd->lines[0];
+	uint32_t i;
+
+	for (i = 1; i < sd->numLines && line->chunk != SDSTORE_NO_CHUNK; i++) {
+		if (sd->lines[i].chunk == SDSTORE_NO_CHUNK || sd->lines[i].lastUse < line->lastUse)
+			line = &sd->lines[i];
+	}
+
+	if (!sdStorePrvWriteBack(sd, line))
+		return NULL;
+
+	line->chunk = chunk;
+	line->lastUse = ++sd->useCtr;
+	memset(line->valid, 0, sizeof(line->valid));
+
+	return sd->mru = line;
+}
+
+//a miss: read the chunk, and a few after it if access looks sequential. a plain image takes one call for all of them
+static struct SdLine* sdStorePrvLoad(struct SdStore *sd, uint32_t chunk)
+{
+	uint32_t i, num = 1, maxChunk = (sd->size - 1) / SDSTORE_LINE_BYTES, total = 0;
+	struct SdLine *lines[SDSTORE_READAHEAD];
+	struct iovec iov[SDSTORE_READAHEAD];
+	bool direct = sd->deltaFd < 0;
+	bool ok = true;
+
+	if (chunk == sd->lastMissChunk + 1) {
+		while (num < SDSTORE_READAHEAD && chunk + num <= maxChunk && !sdStorePrvFind(sd, chunk + num))
+			num++;
+	}
+	sd->lastMissChunk = chunk + num - 1;
+
+	for (i = 0; i < num; i++) {
+
+		lines[i] = sdStorePrvAlloc(sd, chunk + i);
+		if (!lines[i])
+			return NULL;
+
+		iov[i].iov_base = lines[i]->data;
+		iov[i].iov_len = sdStorePrvChunkBytes(sd, chunk + i);
+		total += iov[i].iov_len;
+		direct = direct && sdStorePrvTest(sd->haveData, chunk + i);
+	}
+
+	if (direct) {
+		sd->sysReads++;
+		ok = preadv(sd->fd, iov, num, (uint64_t)chunk * SDSTORE_LINE_BYTES) == total;
+		if (!ok)
+			perror("SD card image read failed");
+	}
+	else for (i = 0; i < num && ok; i++)
+		ok = sdStorePrvReadSecs(sd, (chunk + i) * SDSTORE_LINE_SECS, lines[i]->data, iov[i].iov_len / SDSTORE_SECTOR_SIZE);
+
+	if (!ok) {
+		for (i = 0; i < num; i++)
+			lines[i]->chunk = SDSTORE_NO_CHUNK;
+		return NULL;
+	}
+
+	for (i = 0; i < num; i++)
+		memset(lines[i]->valid, 0xff, sizeof(lines[i]->valid));
+
+	return sd->mru = lines[0];
+}
+
+//a line we wrote some sectors of without reading it first needs the rest from the image
+static bool sdStorePrvFill(struct SdStore *sd, struct SdLine *line)
+{
+	uint32_t i, len = sdStorePrvChunkBytes(sd, line->chunk);
+
+	if (!sdStorePrvReadSecs(sd, line->chunk * SDSTORE_LINE_SECS, sd->scratch, len / SDSTORE_SECTOR_SIZE))
+		return false;
+
+	for (i = 0; i < SDSTORE_LINE_SECS; i++) {
+		if (!sdStorePrvTest(line->valid, i))
+			memcpy(line->data + i * SDSTORE_SECTOR_SIZE, sd->scratch + i * SDSTORE_SECTOR_SIZE, SDSTORE_SECTOR_SIZE);
+	}
+	memset(line->valid, 0xff, sizeof(line->valid));
+
+	return true;
+}
+
+static bool sdStorePrvInRange(struct SdStore *sd, uint32_t sec, uint32_t numSecs)
+{
+	return (uint64_t)sec * SDSTORE_SECTOR_SIZE < sd->size && (sd->size - (uint64_t)sec * SDSTORE_SECTOR_SIZE) / SDSTORE_SECTOR_SIZE >= numSecs;
+}
+
+bool sdStoreRead(struct SdStore *sd, uint32_t sec, void *buf, uint32_t numSecs)
+{
+	uint8_t *dst = (uint8_t*)buf;
+	struct SdLine *line;
+	uint32_t idx, now, i;
+	bool ok = true, hit;
+
+	if (!sdStorePrvInRange(sd, sec, numSecs))
+		return false;
+
+	pthread_mutex_lock(&sd->lock);
+
+	for (; ok && numSecs; numSecs -= now, sec += now, dst += now * SDSTORE_SECTOR_SIZE) {
+
+		idx = sec % SDSTORE_LINE_SECS;
+		now = SDSTORE_LINE_SECS - idx;
+		if (now > numSecs)
+			now = numSecs;
+
+		line = sdStorePrvFind(sd, sec / SDSTORE_LINE_SECS);
+		hit = !!line;
+		if (!line)
+			ok = !!(line = sdStorePrvLoad(sd, sec / SDSTORE_LINE_SECS));
+		else for (i = idx; i < idx + now && ok; i++) {
+			if (!sdStorePrvTest(line->valid, i)) {
+				ok = sdStorePrvFill(sd, line);
+				hit = false;
+			}
+		}
+		if (!ok)
+			break;
+
+		memcpy(dst, line->data + idx * SDSTORE_SECTOR_SIZE, now * SDSTORE_SECTOR_SIZE);
+		line->lastUse = ++sd->useCtr;
+
+		if (hit)
+			sd->secHits += now;
+		else
+			sd->secMisses += now;
+		sd->secsRead += now;
+	}
+
+	pthread_mutex_unlock(&sd->lock);
+
+	return ok;
+}
+
+bool sdStoreWrite(struct SdStore *sd, uint32_t sec, const void *buf, uint32_t numSecs)
+{
+	const uint8_t *src = (const uint8_t*)buf;
+	struct SdLine *line;
+	uint32_t idx, now, i;
+	bool ok = true;
+
+	if (!sdStorePrvInRange(sd, sec, numSecs))
+		return false;
+
+	pthread_mutex_lock(&sd->lock);
+
+	for (; numSecs; numSecs -= now, sec += now, src += now * SDSTORE_SECTOR_SIZE) {
+
+		idx = sec % SDSTORE_LINE_SECS;
+		now = SDSTORE_LINE_SECS - idx;
+		if (now > numSecs)
+			now = numSecs;
+
+		line = sdStorePrvFind(sd, sec / SDSTORE_LINE_SECS);
+		if (!line)		//no need to read what we are about to overwrite
+			line = sdStorePrvAlloc(sd, sec / SDSTORE_LINE_SECS);
+		if (!line) {
+			ok = false;
+			break;
+		}
+
+		memcpy(line->data + idx * SDSTORE_SECTOR_SIZE, src, now * SDSTORE_SECTOR_SIZE);
+		for (i = idx; i < idx + now; i++) {
+			sdStorePrvSet(line->valid, i);
+			sdStorePrvSet(line->dirty, i);
+		}
+		if (!line->isDirty) {
+			line->isDirty = true;
+			if (!sd->numDirty++)
+				pthread_cond_signal(&sd->cond);
+		}
+		line->lastUse = ++sd->useCtr;
+		sd->secsWritten += now;
+	}
+
+	//keep room for reads
+	if (sd->numDirty > sd->numLines / 2)
+		ok = sdStorePrvFlushAll(sd) && ok;
+
+	pthread_mutex_unlock(&sd->lock);
+
+	return ok;
+}
+
+bool sdStoreFlush(struct SdStore *sd)
+{
+	bool ret;
+
+	pthread_mutex_lock(&sd->lock);
+	ret = sdStorePrvFlushAll(sd);
+	pthread_mutex_unlock(&sd->lock);
+
+	return ret;
+}
+
+uint64_t sdStoreGetSize(struct SdStore *sd)
+{
+	return sd->size;
+}
+
+//writes dirty data out a little while after it shows up, so a crash or a kill loses at most that much
+static void* sdStorePrvFlusher(void *param)
+{
+	struct SdStore *sd = (struct SdStore*)param;
+	struct timespec ts;
+
+	pthread_mutex_lock(&sd->lock);
+
+	while (!sd->stop) {
+
+		if (!sd->numDirty) {
+			pthread_cond_wait(&sd->cond, &sd->lock);
+			continue;
+		}
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += SDSTORE_FLUSH_SEC;
+		if (pthread_cond_timedwait(&sd->cond, &sd->lock, &ts) == ETIMEDOUT)
+			sdStorePrvFlushAll(sd);
+	}
+
+	pthread_mutex_unlock(&sd->lock);
+
+	return NULL;
+}
+
+static void sdStorePrvClose(struct SdStore *sd)
+{
+	uint32_t i;
+
+	if (sd->deltaFd >= 0) {
+		fsync(sd->deltaFd);
+		close(sd->deltaFd);
+		for (i = 0; i < sd->numMaps; i++)
+			free(sd->maps[i]);
+		free(sd->maps);
+		free(sd->mapPos);
+	}
+	fsync(sd->fd);
+	close(sd->fd);
+	free(sd->haveData);
+}
+
+static void sdStorePrvAtExit(void)
+{
+	struct SdStore *sd = mStore;
+	uint64_t bytes = (sd->secsRead + sd->secsWritten) * SDSTORE_SECTOR_SIZE;
+
+	pthread_mutex_lock(&sd->lock);
+	sd->stop = true;
+	pthread_cond_signal(&sd->cond);
+	pthread_mutex_unlock(&sd->lock);
+	pthread_join(sd->flusher, NULL);
+
+	sdStorePrvFlushAll(sd);
+	sdStorePrvClose(sd);
+
+	if (!bytes)
+		return;
+
+	fprintf(stderr, "SD card: %.1f MB read, %.1f MB written, %.1f%% of sectors read from cache, %.1f host I/O calls per MB\n",
+		sd->secsRead * (double)SDSTORE_SECTOR_SIZE / (1 << 20), sd->secsWritten * (double)SDSTORE_SECTOR_SIZE / (1 << 20),
+		sd->secsRead ? 100.0 * sd->secHits / sd->secsRead : 0.0, (sd->sysReads + sd->sysWrites) * (double)(1 << 20) / bytes);
+}
+
+//chunks of the image that are holes need not be read
+static void sdStorePrvFindHoles(struct SdStore *sd)
+{
+	uint32_t chunk, numChunks = (sd->size + SDSTORE_LINE_BYTES - 1) / SDSTORE_LINE_BYTES;
+	off_t data, hole = 0;
+
+	sd->haveData = (uint64_t*)calloc(numChunks / 64 + 1, sizeof(uint64_t));
+	if (!sd->haveData)
+		ERR("cannot alloc SD hole map\n");
+
+	while ((data = lseek(sd->fd, hole, SEEK_DATA)) >= 0) {
+
+		hole = lseek(sd->fd, data, SEEK_HOLE);
+		if (hole < 0 || (uint64_t)hole > sd->size)
+			hole = sd->size;
+		for (chunk = data / SDSTORE_LINE_BYTES; chunk < numChunks && (uint64_t)chunk * SDSTORE_LINE_BYTES < (uint64_t)hole; chunk++)
+			sdStorePrvSet(sd->haveData, chunk);
+		if ((uint64_t)hole >= sd->size)
+			break;
+	}
+
+	if (data < 0 && errno != ENXIO)		//no way to tell, so it all has data
+		memset(sd->haveData, 0xff, (numChunks / 64 + 1) * sizeof(uint64_t));
+}
+
+static bool sdStorePrvDeltaOpen(struct SdStore *sd, const char *path)
+{
+	uint32_t i, j, l1Secs;
+	struct SdDeltaHdr hdr;
+	struct stat st;
+
+	sd->numMaps = (sd->size / SDSTORE_SECTOR_SIZE + SDSTORE_MAP_SECS - 1) >> SDSTORE_MAP_SHIFT;
+	l1Secs = (sd->numMaps * sizeof(uint32_t) + SDSTORE_SECTOR_SIZE - 1) / SDSTORE_SECTOR_SIZE;
+
+	sd->deltaFd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (sd->deltaFd < 0 || fstat(sd->deltaFd, &st)) {
+		perror("cannot open SD card delta");
+		return false;
+	}
+
+	sd->mapPos = (uint32_t*)calloc(sd->numMaps + 1, sizeof(uint32_t));
+	sd->maps = (uint32_t**)calloc(sd->numMaps + 1, sizeof(uint32_t*));
+	if (!sd->mapPos || !sd->maps)
+		ERR("cannot alloc SD delta maps\n");
+
+	if (!st.st_size) {		//new one
+
+		memset(&hdr, 0, sizeof(hdr));
+		memcpy(hdr.magic, SDSTORE_DELTA_MAGIC, sizeof(hdr.magic));
+		hdr.version = htole32(SDSTORE_DELTA_VER);
+		hdr.numMaps = htole32(sd->numMaps);
+		hdr.baseSize = htole64(sd->size);
+
+		if (ftruncate(sd->deltaFd, (uint64_t)(1 + l1Secs) * SDSTORE_SECTOR_SIZE) || pwrite(sd->deltaFd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+			perror("cannot create SD card delta");
+			return false;
+		}
+		st.st_size = (uint64_t)(1 + l1Secs) * SDSTORE_SECTOR_SIZE;
+	}
+	else {
+
+		if (pread(sd->deltaFd, &hdr, sizeof(hdr), 0) != sizeof(hdr) || memcmp(hdr.magic, SDSTORE_DELTA_MAGIC, sizeof(hdr.magic)) ||
+				le32toh(hdr.version) != SDSTORE_DELTA_VER || le32toh(hdr.numMaps) != sd->numMaps || le64toh(hdr.baseSize) != sd->size) {
+			fprintf(stderr, "'%s' is not an SD card delta for an image of this size\n", path);
+			return false;
+		}
+
+		if (pread(sd->deltaFd, sd->mapPos, sd->numMaps * sizeof(uint32_t), SDSTORE_SECTOR_SIZE) != (ssize_t)(sd->numMaps * sizeof(uint32_t))) {
+			perror("cannot read SD card delta");
+			return false;
+		}
+
+		for (i = 0; i < sd->numMaps; i++) {
+
+			sd->mapPos[i] = le32toh(sd->mapPos[i]);
+			if (!sd->mapPos[i])
+				continue;
+
+			sd->maps[i] = (uint32_t*)malloc(SDSTORE_MAP_BYTES);
+			if (!sd->maps[i])
+				ERR("cannot alloc SD delta map\n");
+			if (pread(sd->deltaFd, sd->maps[i], SDSTORE_MAP_BYTES, (uint64_t)sd->mapPos[i] * SDSTORE_SECTOR_SIZE) != SDSTORE_MAP_BYTES) {
+				perror("cannot read SD card delta");
+				return false;
+			}
+			for (j = 0; j < SDSTORE_MAP_SECS; j++)
+				sd->maps[i][j] = le32toh(sd->maps[i][j]);
+		}
+	}
+	sd->deltaEnd = (st.st_size + SDSTORE_SECTOR_SIZE - 1) / SDSTORE_SECTOR_SIZE;
+
+	return true;
+}
+
+static struct SdStore* sdStorePrvOpenFiles(const char *path, const char *deltaPath, bool writeBase)
+{
+	struct SdStore *sd;
+	struct stat st;
+
+	sd = (struct SdStore*)calloc(1, sizeof(*sd));
+	if (!sd)
+		ERR("cannot alloc SD store\n");
+	sd->deltaFd = -1;
+
+	sd->fd = open(path, (writeBase || !deltaPath ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+	if (sd->fd < 0 || fstat(sd->fd, &st)) {
+		perror("cannot open SD card image");
+		if (sd->fd >= 0)
+			close(sd->fd);
+		free(sd);
+		return NULL;
+	}
+	sd->size = st.st_size;
+	sdStorePrvFindHoles(sd);
+
+	if (deltaPath && !sdStorePrvDeltaOpen(sd, deltaPath)) {
+		sdStorePrvClose(sd);
+		free(sd);
+		return NULL;
+	}
+
+	return sd;
+}
+
+struct SdStore* sdStoreOpen(const char *path, const char *deltaPath, uint32_t cacheBytes)
+{
+	struct SdStore *sd;
+	uint32_t i;
+
+	if (mStore)		//one card is all we have slots for
+		return NULL;
+
+	sd = sdStorePrvOpenFiles(path, deltaPath, false);
+	if (!sd)
+		return NULL;
+
+	sd->numLines = cacheBytes / SDSTORE_LINE_BYTES;
+	if (sd->numLines < SDSTORE_MIN_LINES)
+		sd->numLines = SDSTORE_MIN_LINES;
+
+	sd->lines = (struct SdLine*)calloc(sd->numLines, sizeof(struct SdLine));
+	sd->scratch = (uint8_t*)malloc(SDSTORE_LINE_BYTES);
+	if (!sd->lines || !sd->scratch)
+		ERR("cannot alloc SD cache\n");
+
+	for (i = 0; i < sd->numLines; i++) {
+		sd->lines[i].chunk = SDSTORE_NO_CHUNK;
+		sd->lines[i].data = (uint8_t*)malloc(SDSTORE_LINE_BYTES);
+		if (!sd->lines[i].data)
+			ERR("cannot alloc SD cache\n");
+	}
+	sd->lastMissChunk = SDSTORE_NO_CHUNK - 1;
+
+	pthread_mutex_init(&sd->lock, NULL);
+	pthread_cond_init(&sd->cond, NULL);
+	if (pthread_create(&sd->flusher, NULL, sdStorePrvFlusher, sd))
+		ERR("cannot start SD flusher thread\n");
+
+	posix_fadvise(sd->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	mStore = sd;
+	atexit(sdStorePrvAtExit);
+
+	return sd;
+}
+
+bool sdStoreCommit(const char *path, const char *deltaPath)
+{
+	uint32_t map, i, j, sec, num, numSecs = 0;
+	struct SdStore *sd;
+	bool ok = true;
+	uint8_t *buf;
+
+	sd = sdStorePrvOpenFiles(path, deltaPath, true);
+	if (!sd)
+		return false;
+
+	buf = (uint8_t*)malloc(SDSTORE_MAP_SECS * SDSTORE_SECTOR_SIZE);
+	if (!buf)
+		ERR("cannot alloc SD commit buffer\n");
+
+	//each run of sectors the delta has is read from it and written over the image
+	for (map = 0; map < sd->numMaps && ok; map++) {
+
+		if (!sd->maps[map])
+			continue;
+
+		for (i = 0; i < SDSTORE_MAP_SECS && ok; i = j) {
+
+			sec = (map << SDSTORE_MAP_SHIFT) + i;
+			if (sd->maps[map][i] == SDSTORE_IN_BASE) {
+				j = i + 1;
+				continue;
+			}
+			for (j = i + 1; j < SDSTORE_MAP_SECS && sd->maps[map][j] != SDSTORE_IN_BASE; j++);
+
+			num = j - i;
+			ok = sdStorePrvReadSecs(sd, sec, buf, num);
+			if (ok && pwrite(sd->fd, buf, num * SDSTORE_SECTOR_SIZE, (uint64_t)sec * SDSTORE_SECTOR_SIZE) != num * SDSTORE_SECTOR_SIZE) {
+				perror("SD card image write failed");
+				ok = false;
+			}
+			numSecs += num;
+		}
+	}
+
+	if (ok)
+		fprintf(stderr, "committed %lu sectors from '%s' into '%s'\n", (unsigned long)numSecs, deltaPath, path);
+
+	free(buf);
+	sdStorePrvClose(sd);
+	free(sd);
+
+	return ok;
+}
@@ -0,0 +1,34 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _SDSTORE_H_
+#define _SDSTORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define SDSTORE_SECTOR_SIZE		512
+#define SDSTORE_DEFAULT_CACHE	(8UL << 20)
+
+
+struct SdStore;
+
+/*
+	An SD card image behind a write-back block cache. Misses read a whole 64KB line (several of them at once when
+	access is sequential), dirty sectors go out in contiguous runs within a second, when the cache needs room, or
+	at exit. Only one image may be open.
+	With a delta path the image is only read and all writes go to the delta (created if missing), a sparse file
+	holding just the sectors written, so many instances can share one image. Sectors that are all zeroes, in the
+	delta or in holes of the image, cost no I/O
+*/
+struct SdStore* sdStoreOpen(const char *path, const char *deltaPath, uint32_t cacheBytes);
+uint64_t sdStoreGetSize(struct SdStore *sd);	//in bytes
+
+bool sdStoreRead(struct SdStore *sd, uint32_t sec, void *buf, uint32_t numSecs);
+bool sdStoreWrite(struct SdStore *sd, uint32_t sec, const void *buf, uint32_t numSecs);
+bool sdStoreFlush(struct SdStore *sd);
+
+bool sdStoreCommit(const char *path, const char *deltaPath);	//write what a delta has over its image. not while either is open
+
+
+#endif
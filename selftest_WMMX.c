@@ -0,0 +1,171 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "pxa270_WMMX.h"
+
+
+/*
+	Runs random operands through every WMMX data processing op twice: once in the normal build, which takes the host
+	vector paths where it has them, and once in a copy built without them (see "selftest" in the Makefile). Any
+	difference in registers, flags or the return value is a bug in the vector path. Only the coprocessor interface
+	the CPU uses is driven, so this needs no SoC. Built and run with "make selftest"
+*/
+
+#define SELFTEST_ITERS_PER_OP		20000
+#define SELFTEST_MAX_REPORTS		16
+
+
+struct Pxa270wmmx* pxa270wmmxInitScalar(struct ArmCpu* cpu);
+
+struct SelftestState {
+	uint64_t wR[16];
+	uint32_t ctrl[7];			//wCON, wCSSF, wCASF, wCGR[0..3]
+	bool ret;
+};
+
+static const uint8_t mCtrlRegs[] = {1, 2, 3, 8, 9, 10, 11};
+static struct ArmCoprocessor mRegistered[2];
+static uint32_t mCoreRegs[16];
+static uint64_t mRndState = 0x139408dcbbf7a44ull;
+
+
+
+uint32_t cpuGetRegExternal(struct ArmCpu *cpu, uint_fast8_t reg)
+{
+	return mCoreRegs[reg & 15];
+}
+
+void cpuSetReg(struct ArmCpu *cpu, uint_fast8_t reg, uint32_t val)
+{
+	mCoreRegs[reg & 15] = val;
+}
+
+bool cpuMemOpExternal(struct ArmCpu *cpu, void* buf, uint32_t vaddr, uint_fast8_t size, bool write)
+{
+	return false;
+}
+
+void cpuCoprocessorRegister(struct ArmCpu *cpu, uint8_t cpNum, struct ArmCoprocessor* coproc)
+{
+	mRegistered[cpNum] = *coproc;
+}
+
+static uint64_t selftestPrvRand(void)
+{
+	mRndState ^= mRndState << 13;
+	mRndState ^= mRndState >> 7;
+	mRndState ^= mRndState << 17;
+
+	return mRndState;
+}
+
+//saturation and flag bugs hide at lane edges, so plenty of lanes get 0, 0x7f, 0x80 or 0xff
+static uint64_t selftestPrvOperand(void)
+{
+	static const uint8_t edges[] = {0x00, 0x7f, 0x80, 0xff};
+	uint64_t v = selftestPrvRand();
+	uint_fast8_t i;
+
+	if (selftestPrvRand() % 8 < 3) {
+
+		for (i = 0; i < 8; i++) {
+
+			uint64_t pick = selftestPrvRand() % 5;
+
+			if (pick < 4)
+				v = (v &~ (0xffull << (i * 8))) | ((uint64_t)edges[pick] << (i * 8));
+		}
+	}
+
+	return v;
+}
+
+static void selftestPrvLoad(const struct ArmCoprocessor *cp, const struct SelftestState *st)
+{
+	uint_fast8_t i;
+
+	for (i = 0; i < 16; i++) {
+
+		mCoreRegs[0] = st->wR[i];
+		mCoreRegs[1] = st->wR[i] >> 32;
+		cp[0].twoRegF(NULL, cp[0].userData, false, 0, 0, 1, i);
+	}
+	for (i = 0; i < sizeof(mCtrlRegs); i++) {
+
+		mCoreRegs[0] = st->ctrl[i];
+		cp[1].regXfer(NULL, cp[1].userData, false, false, 0, 0, mCtrlRegs[i], 0, 0);
+	}
+}
+
+static void selftestPrvSave(const struct ArmCoprocessor *cp, struct SelftestState *st)
+{
+	uint_fast8_t i;
+
+	for (i = 0; i < 16; i++) {
+
+		cp[0].twoRegF(NULL, cp[0].userData, true, 0, 0, 1, i);
+		st->wR[i] = (((uint64_t)mCoreRegs[1]) << 32) | mCoreRegs[0];
+	}
+	for (i = 0; i < sizeof(mCtrlRegs); i++) {
+
+		cp[1].regXfer(NULL, cp[1].userData, false, true, 0, 0, mCtrlRegs[i], 0, 0);
+		st->ctrl[i] = mCoreRegs[0];
+	}
+}
+
+static void selftestPrvRun(const struct ArmCoprocessor *cp, const struct SelftestState *in, struct SelftestState *out, bool cp1, uint_fast8_t op1, uint_fast8_t op2, uint_fast8_t CRd, uint_fast8_t CRn, uint_fast8_t CRm)
+{
+	selftestPrvLoad(cp, in);
+	out->ret = cp[cp1].dataProcessing(NULL, cp[cp1].userData, false, op1, CRd, CRn, CRm, op2);
+	selftestPrvSave(cp, out);
+}
+
+int main(void)
+{
+	struct ArmCoprocessor vec[2], scalar[2];
+	struct SelftestState in, outVec, outScalar;
+	uint_fast8_t cp1, op1, op2, i, CRd, CRn, CRm;
+	uint64_t numRun = 0, numBad = 0;
+	uint32_t iter;
+
+	pxa270wmmxInit(NULL);
+	memcpy(vec, mRegistered, sizeof(vec));
+	pxa270wmmxInitScalar(NULL);
+	memcpy(scalar, mRegistered, sizeof(scalar));
+
+	for (cp1 = 0; cp1 < 2; cp1++) {
+		for (op2 = 0; op2 < 8; op2++) {
+			for (op1 = 0; op1 < 16; op1++) {
+				for (iter = 0; iter < SELFTEST_ITERS_PER_OP; iter++) {
+
+					for (i = 0; i < 16; i++)
+						in.wR[i] = selftestPrvOperand();
+					for (i = 0; i < sizeof(mCtrlRegs); i++)
+						in.ctrl[i] = selftestPrvRand();
+					CRd = selftestPrvRand() % 16;
+					CRn = selftestPrvRand() % 16;
+					CRm = selftestPrvRand() % 16;
+
+					selftestPrvRun(vec, &in, &outVec, cp1, op1, op2, CRd, CRn, CRm);
+					selftestPrvRun(scalar, &in, &outScalar, cp1, op1, op2, CRd, CRn, CRm);
+					numRun++;
+
+					if (outVec.ret == outScalar.ret && !memcmp(outVec.wR, outScalar.wR, sizeof(outVec.wR)) && !memcmp(outVec.ctrl, outScalar.ctrl, sizeof(outVec.ctrl)))
+						continue;
+
+					if (numBad++ < SELFTEST_MAX_REPORTS)
+						fprintf(stderr, "cp%u op1 %u op2 %u wR%u = wR%u, wR%u: ret %u/%u wRd %016llx/%016llx wCASF %08x/%08x wCSSF %02x/%02x wCON %x/%x\n",
+							cp1, op1, op2, CRd, CRn, CRm, outVec.ret, outScalar.ret,
+							(unsigned long long)outVec.wR[CRd], (unsigned long long)outScalar.wR[CRd],
+							outVec.ctrl[2], outScalar.ctrl[2], outVec.ctrl[1], outScalar.ctrl[1], outVec.ctrl[0], outScalar.ctrl[0]);
+				}
+			}
+		}
+	}
+
+	printf("WMMX vector vs plain C: %llu of %llu ops differ\n", (unsigned long long)numBad, (unsigned long long)numRun);
+
+	return numBad ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include "shmio.h"
+#include "util.h"
+
+
+struct Shmio {
+	struct ShmioHdr *hdr;
+	size_t size;
+	char name[64];
+	uint64_t frameNo;
+	struct Shmio *next;
+};
+
+static struct Shmio *mSegments = NULL;					//every segment set up, for open() to find by name
+static struct ShmioHdr *mInputHdr = NULL;				//whose queue we read. the first segment set up
+
+
+
+static void shmioPrvName(char *dst, size_t dstSz, const char *args)
+{
+	snprintf(dst, dstSz, "%s%s", args[0] == '/' ? "" : "/", args);
+}
+
+//maps at least "size" bytes of the segment, growing it if need be but never shrinking it under other mappings
+static struct ShmioHdr* shmioPrvMap(const char *name, size_t size)
+{
+	struct ShmioHdr *hdr;
+	struct stat st;
+	int fd;
+
+	fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+	if (fd < 0 || fstat(fd, &st) || ((size_t)st.st_size < size && ftruncate(fd, size))) {
+		perror("shm_open");
+		if (fd >= 0)
+			close(fd);
+		return NULL;
+	}
+	hdr = (struct ShmioHdr*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	return hdr == MAP_FAILED ? NULL : hdr;
+}
+
+//segments whose display never came up
+static void shmioPrvUnlinkUnopened(void)
+{
+	struct Shmio *shm;
+
+	for (shm = mSegments; shm; shm = shm->next)
+		shm_unlink(shm->name);
+}
+
+//the segment and its input queue are up from the start, frontends can connect before the guest has a screen
+static bool shmioPrvPrepare(const char *args)
+{
+	uint32_t evtOfst = (sizeof(struct ShmioHdr) + 63) &~ 63;
+	struct ShmioHdr *hdr;
+	struct Shmio *shm;
+
+	if (!args || !*args) {
+		fprintf(stderr, "shm output needs a name: -o shm:NAME\n");
+		return false;
+	}
+
+	shm = (struct Shmio*)calloc(1, sizeof(*shm));
+	if (!shm)
+		ERR("cannot alloc shm output");
+
+	shmioPrvName(shm->name, sizeof(shm->name), args);
+	shm->size = evtOfst + SHMIO_NUM_EVTS * sizeof(struct ShmioEvt);
+
+	hdr = shmioPrvMap(shm->name, shm->size);
+	if (!hdr) {
+		free(shm);
+		return false;
+	}
+
+	__atomic_store_n(&hdr->magic, 0, __ATOMIC_RELEASE);
+	hdr->version = SHMIO_VERSION;
+	hdr->evtNum = SHMIO_NUM_EVTS;
+	hdr->evtOfst = evtOfst;
+	__atomic_store_n(&hdr->evtHead, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&hdr->evtTail, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&hdr->size, 0, __ATOMIC_RELAXED);
+	hdr->width = 0;
+	hdr->height = 0;
+	hdr->winHeight = 0;
+	hdr->numSlots = 0;
+	hdr->slotOfst = 0;
+	hdr->slotStride = 0;
+	hdr->rfu = 0;
+	__atomic_store_n(&hdr->frameSeq, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&hdr->magic, SHMIO_MAGIC, __ATOMIC_RELEASE);	//last, so frontends that poll for it see a complete header
+
+	if (!mSegments)
+		atexit(shmioPrvUnlinkUnopened);
+	shm->hdr = hdr;
+	shm->next = mSegments;
+	mSegments = shm;
+	if (!mInputHdr)
+		mInputHdr = hdr;
+	fprintf(stderr, "shared memory '%s' is up, frames will follow once the screen is set up\n", shm->name);
+
+	return true;
+}
+
+//now that we know the screen size, add the frame ring after the input queue
+static void* shmioPrvOpen(const char *args, uint32_t w, uint32_t h, uint32_t winH)
+{
+	uint32_t slotStride = (sizeof(struct ShmioSlot) + w * h * sizeof(uint16_t) + 63) &~ 63;
+	struct ShmioHdr *hdr;
+	uint32_t slotOfst;
+	struct Shmio *shm;
+	char name[64];
+
+	if (!args || !*args)
+		return NULL;
+
+	shmioPrvName(name, sizeof(name), args);
+	for (shm = mSegments; shm && strcmp(shm->name, name); shm = shm->next);
+	if (!shm)
+		return NULL;
+
+	hdr = shm->hdr;
+	slotOfst = (hdr->evtOfst + hdr->evtNum * sizeof(struct ShmioEvt) + 63) &~ 63;
+
+	//the mapping might move, and the input queue with it. input is polled on this same thread, so it cannot see it mid-move
+	hdr = shmioPrvMap(shm->name, slotOfst + SHMIO_NUM_SLOTS * slotStride);
+	if (!hdr)
+		return NULL;
+	munmap(shm->hdr, shm->size);
+	if (mInputHdr == shm->hdr)
+		mInputHdr = hdr;
+	shm->hdr = hdr;
+	shm->size = slotOfst + SHMIO_NUM_SLOTS * slotStride;
+
+	hdr->width = w;
+	hdr->height = h;
+	hdr->winHeight = winH;
+	hdr->numSlots = SHMIO_NUM_SLOTS;
+	hdr->slotOfst = slotOfst;
+	hdr->slotStride = slotStride;
+	__atomic_store_n(&hdr->size, shm->size, __ATOMIC_RELEASE);
+
+	fprintf(stderr, "frames go to shared memory '%s'\n", shm->name);
+
+	return shm;
+}
+
+static struct ShmioSlot* shmioPrvSlot(struct ShmioHdr *hdr, uint64_t frameNo)
+{
+	return (struct ShmioSlot*)(((uint8_t*)hdr) + hdr->slotOfst + (frameNo % hdr->numSlots) * hdr->slotStride);
+}
+
+static void shmioPrvPresent(void *ctx, const uint16_t *pixels)
+{
+	struct Shmio *shm = (struct Shmio*)ctx;
+	struct ShmioHdr *hdr = shm->hdr;
+	struct ShmioSlot *slot = shmioPrvSlot(hdr, ++shm->frameNo);
+
+	__atomic_store_n(&slot->seq, shm->frameNo * 2 - 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(slot->pixels, pixels, hdr->width * hdr->height * sizeof(uint16_t));
+	__atomic_store_n(&slot->seq, shm->frameNo * 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&hdr->frameSeq, shm->frameNo, __ATOMIC_RELEASE);
+}
+
+static void shmioPrvClose(void *ctx)
+{
+	struct Shmio *shm = (struct Shmio*)ctx, **prevP;
+
+	for (prevP = &mSegments; *prevP != shm; prevP = &(*prevP)->next);
+	*prevP = shm->next;
+	if (mInputHdr == shm->hdr)
+		mInputHdr = NULL;
+	munmap(shm->hdr, shm->size);
+	shm_unlink(shm->name);
+	free(shm);
+}
+
+const struct DisplaySink* shmioDisplaySink(void)
+{
+	static const struct DisplaySink sink = {
+		.name = "shm",
+		.help = "POSIX shared memory frame ring and input queue, for external frontends (shm:NAME)",
+		.prepare = shmioPrvPrepare,
+		.open = shmioPrvOpen,
+		.present = shmioPrvPresent,
+		.close = shmioPrvClose,
+	};
+
+	return &sink;
+}
+
+bool shmioInputPoll(struct InputEvt *evt)
+{
+	struct ShmioHdr *hdr = mInputHdr;
+	const struct ShmioEvt *src;
+	uint32_t tail;
+
+	if (!hdr)
+		return false;
+
+	tail = __atomic_load_n(&hdr->evtTail, __ATOMIC_RELAXED);
+	if (tail == __atomic_load_n(&hdr->evtHead, __ATOMIC_ACQUIRE))
+		return false;
+
+	src = ((const struct ShmioEvt*)(((uint8_t*)hdr) + hdr->evtOfst)) + tail % hdr->evtNum;
+	switch (src->type) {
+		case ShmioEvtTouch:
+			evt->type = InputEvtTouch;
+			evt->x = src->x;
+			evt->y = src->y;
+			break;
+
+		case ShmioEvtKey:
+			evt->type = InputEvtKey;
+			evt->key = src->key;
+			evt->down = !!src->down;
+			break;
+
+		default:
+			fprintf(stderr, "shm input: ignoring event of unknown type %u\n", src->type);
+			evt = NULL;
+			break;
+	}
+	__atomic_store_n(&hdr->evtTail, tail + 1, __ATOMIC_RELEASE);
+
+	return !!evt;
+}
@@ -0,0 +1,83 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _SHMIO_H_
+#define _SHMIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*
+	Layout of the POSIX shared memory segment made by "-o shm:NAME". External frontends map it (read-write, for the
+	input queue) and need nothing but this header. All offsets are from the start of the segment, all fields are plain
+	little-endian integers at fixed offsets, so any language can use it
+
+	The segment exists, with a working input queue, as soon as the emulator starts. The screen size is only known once
+	the guest sets up its LCD: until then "size" is 0 and there are no frames. Then the segment grows, and "size" says
+	how much of it to map. An existing segment of the same name is reused, never shrunk, so frontends that still have it
+	mapped from an earlier run keep working. Wait for "magic" again if it goes to 0, the header is being rewritten
+
+	Memory ordering: fields marked "release" are written last, with a release store, after everything they publish.
+	Read them with an acquire load (C11: atomic_load_explicit on an _Atomic cast, GCC: __atomic_load_n) before reading
+	what they guard. Fields marked "frontend" are written by frontends the same way
+
+	Frames: a ring of numSlots RGB565 frames of width x height. A slot's seq is odd while it is being written and
+	2 * (frame number) once done. hdr.frameSeq is the number of the newest complete frame, which lives in slot
+	(frameSeq % numSlots). Readers may use the pixels in place and check seq afterwards to see if they were overwritten
+
+	Input: a single-producer (frontend) single-consumer (emulator) queue of evtNum entries. The frontend writes entry
+	(evtHead % evtNum) and then bumps evtHead, the emulator does the same with evtTail. Touch coordinates are in the
+	w x winHeight area, both negative for pen up. Keys use SDL keycode values, but SDL is not needed to produce them
+*/
+
+#define SHMIO_MAGIC				0x4d524175ul	//"uARM"
+#define SHMIO_VERSION			2
+#define SHMIO_NUM_SLOTS			4
+#define SHMIO_NUM_EVTS			256
+
+enum ShmioEvtType {
+	ShmioEvtTouch = 1,
+	ShmioEvtKey,
+};
+
+struct ShmioEvt {
+	uint8_t type;			//enum ShmioEvtType
+	uint8_t down;			//keys only
+	uint16_t rfu;
+	int32_t x, y;			//touch only
+	uint32_t key;			//keys only
+};
+
+struct ShmioSlot {
+	uint64_t seq;			//release
+	uint16_t pixels[];
+};
+
+struct ShmioHdr {			//64 bytes, no padding
+	uint32_t magic;			//release. 0 while the header is being set up
+	uint32_t version;
+	uint32_t evtNum, evtOfst;
+	uint32_t evtHead;		//frontend, release
+	uint32_t evtTail;		//release
+	uint32_t size;			//release. 0 until the screen size is known and the fields below are valid
+	uint32_t width, height, winHeight;
+	uint32_t numSlots, slotOfst, slotStride;
+	uint32_t rfu;
+	uint64_t frameSeq;		//release
+};
+
+
+#ifndef SHMIO_FRONTEND_ONLY
+
+	#include "display.h"
+	#include "input.h"
+
+	const struct DisplaySink* shmioDisplaySink(void);
+
+	//events frontends queued, taken one at a time
+	bool shmioInputPoll(struct InputEvt *evt);
+
+#endif
+
+
+#endif
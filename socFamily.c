@@ -0,0 +1,75 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include "device.h"
+#include "SoC.h"
+#include "util.h"
+
+
+//the selected device's family, fixed by socInit(). everything below other than socGetRamBase() is only called once there is a SoC
+static const struct SocFamily *mFamily = NULL;
+
+
+
+struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev)
+{
+	if (mFamily)
+		ERR("only one SoC per process, see SoC.h\n");
+	
+	mFamily = deviceGetSocFamily();
+	
+	return mFamily->init(romPieces, romPieceSizes, romNumPieces, sdNumSectors, sdR, sdW, nandFile, gdbPort, socRev);
+}
+
+void socRun(struct SoC* soc)
+{
+	while (1)
+		mFamily->runCycles(soc, SOC_RUN_SLICE_CYCLES);
+}
+
+void socRunCycles(struct SoC* soc, uint32_t numCycles)
+{
+	mFamily->runCycles(soc, numCycles);
+}
+
+uint32_t socGetRamBase(void)
+{
+	return deviceGetSocFamily()->getRamBase();
+}
+
+enum SocGpioState socGpioGetState(struct SocGpio* gpio, uint_fast8_t gpioNum)
+{
+	return mFamily->gpioGetState(gpio, gpioNum);
+}
+
+void socGpioSetState(struct SocGpio* gpio, uint_fast8_t gpioNum, bool on)
+{
+	mFamily->gpioSetState(gpio, gpioNum, on);
+}
+
+void socGpioSetNotif(struct SocGpio* gpio, uint_fast8_t gpioNum, GpioChangedNotifF notifF, void* userData)
+{
+	mFamily->gpioSetNotif(gpio, gpioNum, notifF, userData);
+}
+
+void socGpioSetDirsChangedNotif(struct SocGpio* gpio, GpioDirsChangedF notifF, void *userData)
+{
+	mFamily->gpioSetDirsChangedNotif(gpio, notifF, userData);
+}
+
+void socUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void *userData)
+{
+	mFamily->uartSetFuncs(uart, readF, writeF, userData);
+}
+
+void socUartSetBulk(struct SocUart *uart, bool bulk)
+{
+	mFamily->uartSetBulk(uart, bulk);
+}
+
+bool socI2cDeviceAdd(struct SocI2c *i2c, I2cDeviceActionF actF, void *userData)
+{
+	if (!mFamily->i2cDeviceAdd)
+		return false;
+	
+	return mFamily->i2cDeviceAdd(i2c, actF, userData);
+}
@@ -18,7 +18,8 @@
 #include "omap_IC.h"
 
 #include "soc_uWire.h"
-#include "soc_GPIO.h"
+#include "omap_GPIO.h"
+#include "omap_I2C.h"
 
 #include "SoC.h"
 #include "CPU.h"
@@ -34,12 +35,15 @@
 #include <string.h>
 #include <stdlib.h>
 #include "SDL2/SDL.h"
+#include "input.h"
+#include "speed.h"
 #include "util.h"
 
 
 
 #define ROM_BASE		0x00000000UL
 #define RAM_BASE		0x10000000UL
+#define CYCLES_PER_SEC	33554432UL	//32KHz timer ticks every 1024 cycles
 #define SRAM_BASE		0x20000000UL
 #define SRAM_SIZE		0x00030000UL
 
@@ -68,7 +72,7 @@ struct SoC {
 	struct SocDma *dma;
 	struct SocI2c *i2c; 
 	struct SocIc *ic;
-	bool mouseDown;
+	uint32_t cycles;
 
 	struct ArmRam *sram;
 	struct ArmRam *ram;
@@ -177,7 +181,7 @@ static void socUartPrvWrite(uint_fast16_t chr, void* userData)
 	socExtSerialWriteChar(chr);
 }
 
-struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev)
+static struct SoC* socPrvInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev)
 {
 	struct SoC *soc = (struct SoC*)malloc(sizeof(struct SoC));
 	static uint32_t romWriteIgnoreData[64] = {};
@@ -219,7 +223,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 		case RamTerminationMirror:
 	
 			//ram mirror for ram probe code
-			soc->ramMirror = ramInit(soc->mem, RAM_BASE + deviceGetRamSize(), deviceGetRamSize(), ramBuffer);
+			soc->ramMirror = ramMirrorInit(soc->mem, RAM_BASE + deviceGetRamSize(), soc->ram);
 			if (!soc->ramMirror)
 				ERR("Cannot init RAM mirror");
 			break;
@@ -242,19 +246,19 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	if(!soc->rom)
 		ERR("Cannot init ROM");
 	
-	soc->ic = socIcInit(soc->cpu, soc->mem, socRev);
+	soc->ic = omapIcInit(soc->cpu, soc->mem, socRev);
 	if (!soc->ic)
 		ERR("Cannot init OMAP's IC");
 	
-	soc->dma = socDmaInit(soc->mem, soc->ic);
+	soc->dma = omapDmaInit(soc->mem, soc->ram, soc->ic);
 	if (!soc->dma)
 		ERR("Cannot init OMAP's DMA");
 	
-	soc->gpio = socGpioInit(soc->mem, soc->ic, socRev);
+	soc->gpio = omapGpioInit(soc->mem, soc->ic, socRev);
 	if (!soc->gpio)
 		ERR("Cannot init OMAP's GPIO");
 	
-	soc->i2c = socI2cInit(soc->mem, soc->ic, soc->dma, OMAP_I2C_BASE, OMAP_I_I2C);
+	soc->i2c = omapI2cInit(soc->mem, soc->ic, soc->dma, OMAP_I2C_BASE, OMAP_I_I2C);
 	if (!soc->i2c)
 		ERR("Cannot init OMAP's I2C");
 	
@@ -270,18 +274,22 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	if (!soc->wdt)
 		ERR("Cannot init OMAP's WDT");
 	
-	soc->uart1 = socUartInit(soc->mem, soc->ic, OMAP_UART1_BASE, OMAP_I_UART1);
+	soc->uart1 = omapUartInit(soc->mem, soc->ic, OMAP_UART1_BASE, OMAP_I_UART1);
 	if (!soc->uart1)
 		ERR("Cannot init OMAP's UART1");
 	
-	soc->uart2 = socUartInit(soc->mem, soc->ic, OMAP_UART2_BASE, OMAP_I_UART2);
+	soc->uart2 = omapUartInit(soc->mem, soc->ic, OMAP_UART2_BASE, OMAP_I_UART2);
 	if (!soc->uart2)
 		ERR("Cannot init OMAP's UART2");
 	
-	soc->uart3 = socUartInit(soc->mem, soc->ic, OMAP_UART3_BASE, OMAP_I_UART3);
+	soc->uart3 = omapUartInit(soc->mem, soc->ic, OMAP_UART3_BASE, OMAP_I_UART3);
 	if (!soc->uart3)
 		ERR("Cannot init OMAP's UART3");
 	
+	socExtSerialAttach(soc->uart1, "uart1");
+	socExtSerialAttach(soc->uart2, "uart2");
+	socExtSerialAttach(soc->uart3, "uart3");
+	
 	for (i = 0; i < 3; i++) {
 		
 		static const uint8_t irqs[] = {OMAP_I_TIMER_1, OMAP_I_TIMER_2, OMAP_I_TIMER_3};
@@ -297,7 +305,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 		static const uint8_t dmas[] = {DMA_REQ_McBSP_1_TX, DMA_REQ_McBSP_2_TX, DMA_REQ_McBSP_3_TX};
 		static const uint32_t bases[] = {0xE1011800ul, 0xFFFB1000ul, 0xE1017000ul};
 		
-		soc->mcbsp[i] = omapMcBspInit(soc->mem, soc->ic, soc->dma, bases[i], irqs[i], irqs[i] + 1, dmas[i], dmas[i] + 1);
+		soc->mcbsp[i] = omapMcBspInit(soc->mem, soc->ic, soc->dma, bases[i], irqs[i], irqs[i] + 1, dmas[i], dmas[i] + 1, CYCLES_PER_SEC / 0x4000);
 		if (!soc->mcbsp[i])
 			ERR("Cannot init OMAP's McBSP%u", (unsigned)(i + 1));
 	}
@@ -318,7 +326,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	if (!soc->pwt)
 		ERR("Cannot init OMAP's PWT");
 
-	soc->lcd = omapLcdInit(soc->mem, soc->ic, deviceHasGrafArea());
+	soc->lcd = omapLcdInit(soc->mem, soc->ram, soc->ic, deviceHasGrafArea());
 	if (!soc->lcd)
 		ERR("Cannot init OMAP's LCD");
 
@@ -366,20 +374,27 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	}
 	atexit(SDL_Quit);
 	
+	speedSetClock(CYCLES_PER_SEC);
+	
 	return soc;
 }
 
-void socRun(struct SoC* soc)
+static uint32_t socPrvGetRamBase(void)
+{
+	return RAM_BASE;
+}
+
+static void socPrvRunCycles(struct SoC* soc, uint32_t numCycles)
 {
-	uint32_t cycles = 0;
+	uint32_t cycles = soc->cycles;
 	uint_fast8_t i;
 	
-	while (1)
-	{	
+	while (numCycles--) {
+		
 		cycles++;
 		
 		if (!(cycles & 0x000003FFUL))
-			socDmaPeriodic(soc->dma);
+			omapDmaPeriodic(soc->dma);
 		if (!(cycles & 0x000003FFUL))
 			socUwirePeriodic(soc->uWire);
 		if (!(cycles & 0x000003FFFUL)) {
@@ -397,59 +412,50 @@ void socRun(struct SoC* soc)
 		if (!(cycles & 0x000FFFFFUL)) 
 			omapRtcPeriodic(soc->rtc);
 		if (!(cycles & 0x000000FFUL)) {
-			socUartProcess(soc->uart1);
-			socUartProcess(soc->uart2);
-			socUartProcess(soc->uart3);
+			omapUartProcess(soc->uart1);
+			omapUartProcess(soc->uart2);
+			omapUartProcess(soc->uart3);
 		}
 		devicePeriodic(soc->dev, cycles);
 	
 		if (!(cycles & 0x00FFFFUL)) {
 			
-			SDL_Event event;
+			struct InputEvt evt;
+			
+			speedAdvance(0x00010000UL);
 			
-			if (SDL_PollEvent(&event)) switch (event.type) {
+			if (inputPoll(&evt)) switch (evt.type) {
 				
-				case SDL_QUIT:
+				case InputEvtQuit:
 					fprintf(stderr, "quit reqested\n");
 					exit(0);
 					break;
 				
-				case SDL_MOUSEBUTTONDOWN:
-					if (event.button.button != SDL_BUTTON_LEFT)
-						break;
-					soc->mouseDown = true;
-					deviceTouch(soc->dev, event.button.x, event.button.y);
-					break;
-				
-				case SDL_MOUSEBUTTONUP:
-					if (event.button.button != SDL_BUTTON_LEFT)
-						break;
-					soc->mouseDown = false;
-					deviceTouch(soc->dev, -1, -1);
+				case InputEvtTouch:
+					deviceTouch(soc->dev, evt.x, evt.y);
 					break;
 				
-				case SDL_MOUSEMOTION:
-					if (!soc->mouseDown)
-						break;
-					deviceTouch(soc->dev, event.motion.x, event.motion.y);
-					break;
-				
-				case SDL_KEYDOWN:
-				
-					deviceKey(soc->dev, event.key.keysym.sym, true);
-					keypadSdlKeyEvt(soc->kp, event.key.keysym.sym, true);
-					break;
-				
-				case SDL_KEYUP:
-				
-					deviceKey(soc->dev, event.key.keysym.sym, false);
-					keypadSdlKeyEvt(soc->kp, event.key.keysym.sym, false);
+				case InputEvtKey:
+					deviceKey(soc->dev, evt.key, evt.down);
+					keypadSdlKeyEvt(soc->kp, evt.key, evt.down);
 					break;
 			}
 		}
 		
 		cpuCycle(soc->cpu);
 	}
+	soc->cycles = cycles;
 }
 
-
+const struct SocFamily socFamilyOmap = {
+	.init = socPrvInit,
+	.runCycles = socPrvRunCycles,
+	.getRamBase = socPrvGetRamBase,
+	.gpioGetState = omapGpioGetState,
+	.gpioSetState = omapGpioSetState,
+	.gpioSetNotif = omapGpioSetNotif,
+	.gpioSetDirsChangedNotif = omapGpioSetDirsChangedNotif,
+	.uartSetFuncs = omapUartSetFuncs,
+	.uartSetBulk = omapUartSetBulk,
+	.i2cDeviceAdd = omapI2cDeviceAdd,
+};
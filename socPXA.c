@@ -9,11 +9,11 @@
 #include "cp15.h"
 
 #include "soc_UART.h"
-#include "soc_GPIO.h"
+#include "pxa_GPIO.h"
 #include "soc_AC97.h"
 #include "soc_SSP.h"
 #include "soc_DMA.h"
-#include "soc_I2C.h"
+#include "pxa_I2C.h"
 #include "soc_I2S.h"
 #include "soc_IC.h"
 
@@ -45,6 +45,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include "SDL2/SDL.h"
+#include "input.h"
+#include "speed.h"
 #include "util.h"
 
 
@@ -58,6 +60,7 @@
 
 #define ROM_BASE			0x00000000UL
 #define RAM_BASE			0xA0000000UL
+#define CYCLES_PER_SEC		29491200UL	//OS timer runs at 3.6864MHz and ticks every 8 cycles
 
 #define PXA_I2C_BASE		0x40301680UL
 #define PXA_PWR_I2C_BASE	0x40F00180UL
@@ -74,7 +77,7 @@ struct SoC {
 	struct SocI2s *i2s;
 	struct SocI2c *i2c;
 	struct SocIc *ic;
-	bool mouseDown;
+	uint32_t cycles;
 	
 	struct PxaMemCtrlr *memCtrl;
 	struct PxaPwrClk *pwrClk;
@@ -142,7 +145,7 @@ static void socUartPrvWrite(uint_fast16_t chr, void* userData)
 	socExtSerialWriteChar(chr);
 }
 
-struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev)
+static struct SoC* socPrvInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev)
 {
 	struct SoC *soc = (struct SoC*)malloc(sizeof(struct SoC));
 	static uint32_t romWriteIgnoreData[64] = {};
@@ -173,7 +176,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 		case RamTerminationMirror:
 	
 			//ram mirror for ram probe code
-			soc->ramMirror = ramInit(soc->mem, RAM_BASE + deviceGetRamSize(), deviceGetRamSize(), ramBuffer);
+			soc->ramMirror = ramMirrorInit(soc->mem, RAM_BASE + deviceGetRamSize(), soc->ram);
 			if (!soc->ramMirror)
 				ERR("Cannot init RAM mirror");
 			break;
@@ -196,11 +199,11 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	if (!soc->rom)
 		ERR("Cannot init ROM1");
 	
-	soc->ic = socIcInit(soc->cpu, soc->mem, socRev);
+	soc->ic = pxaIcInit(soc->cpu, soc->mem, socRev);
 	if (!soc->ic)
 		ERR("Cannot init PXA's IC");
 	
-	soc->dma = socDmaInit(soc->mem, soc->ic);
+	soc->dma = pxaDmaInit(soc->mem, soc->ram, soc->ic);
 	if (!soc->dma)
 		ERR("Cannot init PXA's DMA");
 	
@@ -233,7 +236,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 			ERR("Cannot init SRAM");
 	}
 	
-	soc->gpio = socGpioInit(soc->mem, soc->ic, socRev);
+	soc->gpio = pxaGpioInit(soc->mem, soc->ic, socRev);
 	if (!soc->gpio)
 		ERR("Cannot init PXA's GPIO");
 
@@ -245,22 +248,22 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	if (!soc->rtc)
 		ERR("Cannot init PXA's RTC");
 	
-	soc->ffUart = socUartInit(soc->mem, soc->ic, PXA_FFUART_BASE, PXA_I_FFUART);
+	soc->ffUart = pxaUartInit(soc->mem, soc->ic, PXA_FFUART_BASE, PXA_I_FFUART);
 	if (!soc->ffUart)
 		ERR("Cannot init PXA's FFUART");
 	
 	if (socRev != 2) {
 		
-		soc->hwUart = socUartInit(soc->mem, soc->ic, PXA_HWUART_BASE, PXA_I_HWUART);
+		soc->hwUart = pxaUartInit(soc->mem, soc->ic, PXA_HWUART_BASE, PXA_I_HWUART);
 		if (!soc->hwUart)
 			ERR("Cannot init PXA's HWUART");
 	}
 	
-	soc->stUart = socUartInit(soc->mem, soc->ic, PXA_STUART_BASE, PXA_I_STUART);
+	soc->stUart = pxaUartInit(soc->mem, soc->ic, PXA_STUART_BASE, PXA_I_STUART);
 	if (!soc->stUart)
 		ERR("Cannot init PXA's STUART");
 	
-	soc->btUart = socUartInit(soc->mem, soc->ic, PXA_BTUART_BASE, PXA_I_BTUART);
+	soc->btUart = pxaUartInit(soc->mem, soc->ic, PXA_BTUART_BASE, PXA_I_BTUART);
 	if (!soc->btUart)
 		ERR("Cannot init PXA's BTUART");
 	
@@ -269,12 +272,12 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 		ERR("Cannot init PXA's PWRCLKMGR");
 	
 	if (socRev == 2) {
-		soc->pwrI2c = socI2cInit(soc->mem, soc->ic, soc->dma, PXA_PWR_I2C_BASE, PXA_I_PWR_I2C);
+		soc->pwrI2c = pxaI2cInit(soc->mem, soc->ic, soc->dma, PXA_PWR_I2C_BASE, PXA_I_PWR_I2C);
 		if (!soc->pwrI2c)
 			ERR("Cannot init PXA Pwr's I2C\n");
 	}
 	
-	soc->i2c = socI2cInit(soc->mem, soc->ic, soc->dma, PXA_I2C_BASE, PXA_I_I2C);
+	soc->i2c = pxaI2cInit(soc->mem, soc->ic, soc->dma, PXA_I2C_BASE, PXA_I_I2C);
 	if (!soc->i2c)
 		ERR("Cannot init PXA's I2C");
 
@@ -282,7 +285,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	if (!soc->memCtrl)
 		ERR("Cannot init PXA's MEMC");
 
-	soc->ac97 = socAC97Init(soc->mem, soc->ic, soc->dma);
+	soc->ac97 = socAC97Init(soc->mem, soc->ic, soc->dma, CYCLES_PER_SEC / 0x800);
 	if (!soc->ac97)
 		ERR("Cannot init PXA's AC97");
 
@@ -328,7 +331,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 			ERR("Cannot init PXA270's UDC");
 	}
 
-	soc->i2s = socI2sInit(soc->mem, soc->ic, soc->dma);
+	soc->i2s = socI2sInit(soc->mem, soc->ic, soc->dma, CYCLES_PER_SEC / 0x800);
 	if (!soc->i2s)
 		ERR("Cannot init PXA's I2S");
 
@@ -355,7 +358,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	if (!soc->mmc)
 		ERR("Cannot init PXA's MMC");
 	
-	soc->lcd = pxaLcdInit(soc->mem, soc->ic, deviceHasGrafArea());
+	soc->lcd = pxaLcdInit(soc->mem, soc->ram, soc->ic, deviceHasGrafArea());
 	if (!soc->lcd)
 		ERR("Cannot init PXA's LCD");
 	
@@ -392,7 +395,14 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 		ERR("Cannot init device\n");
 	
 	if (sp.dbgUart)
-		socUartSetFuncs(sp.dbgUart, socUartPrvRead, socUartPrvWrite, soc->hwUart);
+		pxaUartSetFuncs(sp.dbgUart, socUartPrvRead, socUartPrvWrite, soc->hwUart);
+	
+	//any of them may be hooked up to the host as well (overriding the above)
+	socExtSerialAttach(soc->ffUart, "ff");
+	if (soc->hwUart)
+		socExtSerialAttach(soc->hwUart, "hw");
+	socExtSerialAttach(soc->stUart, "st");
+	socExtSerialAttach(soc->btUart, "bt");
 	
 	/*
 		var gpio = {latches: [0x30000, 0x1400001, 0x200], inputs: [0x786c06, 0x100, 0x0], levels: [0x7b6c04, 0x1400101, 0x200], dirs: [0xcf878178, 0xffd1beff, 0x1ffff], riseDet: [0x1680, 0x40000, 0x0], fallDet: [0x786c04, 0x0, 
@@ -440,15 +450,22 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	}
 	atexit(SDL_Quit);
 	
+	speedSetClock(CYCLES_PER_SEC);
+	
 	return soc;
 }
 
-void socRun(struct SoC* soc)
+static uint32_t socPrvGetRamBase(void)
+{
+	return RAM_BASE;
+}
+
+static void socPrvRunCycles(struct SoC* soc, uint32_t numCycles)
 {
-	uint32_t cycles = 0;
+	uint32_t cycles = soc->cycles;
 	uint_fast8_t i;
 	
-	while (1) {	
+	while (numCycles--) {
 		
 		cycles++;
 		
@@ -461,17 +478,17 @@ void socRun(struct SoC* soc)
 			}
 		}
 		if (!(cycles & 0x000000FFUL))
-			socDmaPeriodic(soc->dma);
+			pxaDmaPeriodic(soc->dma);
 		if (!(cycles & 0x000007FFUL))
 			socAC97Periodic(soc->ac97);
 		if (!(cycles & 0x000007FFUL))
 			socI2sPeriodic(soc->i2s);
 		if (!(cycles & 0x000000FFUL)) {
-			socUartProcess(soc->ffUart);
+			pxaUartProcess(soc->ffUart);
 			if (soc->hwUart)
-				socUartProcess(soc->hwUart);
-			socUartProcess(soc->stUart);
-			socUartProcess(soc->btUart);
+				pxaUartProcess(soc->hwUart);
+			pxaUartProcess(soc->stUart);
+			pxaUartProcess(soc->btUart);
 		}
 		
 		devicePeriodic(soc->dev, cycles);
@@ -483,50 +500,41 @@ void socRun(struct SoC* soc)
 		
 		if (!(cycles & 0x00FFFFUL)) {
 			
-			SDL_Event event;
+			struct InputEvt evt;
+			
+			speedAdvance(0x00010000UL);
 			
-			if (SDL_PollEvent(&event)) switch (event.type) {
+			if (inputPoll(&evt)) switch (evt.type) {
 				
-				case SDL_QUIT:
+				case InputEvtQuit:
 					exit(0);
 					break;
 				
-				case SDL_MOUSEBUTTONDOWN:
-					if (event.button.button != SDL_BUTTON_LEFT)
-						break;
-					soc->mouseDown = true;
-					deviceTouch(soc->dev, event.button.x, event.button.y);
-					break;
-				
-				case SDL_MOUSEBUTTONUP:
-					if (event.button.button != SDL_BUTTON_LEFT)
-						break;
-					soc->mouseDown = false;
-					deviceTouch(soc->dev, -1, -1);
+				case InputEvtTouch:
+					deviceTouch(soc->dev, evt.x, evt.y);
 					break;
 				
-				case SDL_MOUSEMOTION:
-					if (!soc->mouseDown)
-						break;
-					deviceTouch(soc->dev, event.motion.x, event.motion.y);
-					break;
-				
-				case SDL_KEYDOWN:
-				
-					deviceKey(soc->dev, event.key.keysym.sym, true);
-					keypadSdlKeyEvt(soc->kp, event.key.keysym.sym, true);
-					break;
-				
-				case SDL_KEYUP:
-				
-					deviceKey(soc->dev, event.key.keysym.sym, false);
-					keypadSdlKeyEvt(soc->kp, event.key.keysym.sym, false);
+				case InputEvtKey:
+					deviceKey(soc->dev, evt.key, evt.down);
+					keypadSdlKeyEvt(soc->kp, evt.key, evt.down);
 					break;
 			}
 		}
 		
 		cpuCycle(soc->cpu);
 	}
+	soc->cycles = cycles;
 }
 
-
+const struct SocFamily socFamilyPxa = {
+	.init = socPrvInit,
+	.runCycles = socPrvRunCycles,
+	.getRamBase = socPrvGetRamBase,
+	.gpioGetState = pxaGpioGetState,
+	.gpioSetState = pxaGpioSetState,
+	.gpioSetNotif = pxaGpioSetNotif,
+	.gpioSetDirsChangedNotif = pxaGpioSetDirsChangedNotif,
+	.uartSetFuncs = pxaUartSetFuncs,
+	.uartSetBulk = pxaUartSetBulk,
+	.i2cDeviceAdd = pxaI2cDeviceAdd,
+};
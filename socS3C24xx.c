@@ -1,6 +1,6 @@
 //(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
 
-#include "soc_GPIO.h"
+#include "s3c24xx_GPIO.h"
 
 #include "s3c24xx_MemCtrl.h"
 #include "s3c24xx_PwrClk.h"
@@ -30,6 +30,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include "SDL2/SDL.h"
+#include "input.h"
+#include "speed.h"
 #include "util.h"
 
 
@@ -37,6 +39,7 @@
 #define ROM_BASE	0x00000000UL
 
 #define RAM_BASE	0x30000000UL
+#define CYCLES_PER_SEC	101400000UL	//timers tick every 2 cycles, PCLK is 50.7MHz
 #define SRAM_SIZE	0x00001000UL
 
 
@@ -53,7 +56,7 @@ struct SoC {
 	struct S3C24xxWdt *wdt;
 	struct S3C24xxLcd *lcd;
 	bool soc40;
-	bool mouseDown;
+	uint32_t cycles;
 	
 	struct SocUart *uart0, *uart1, *uart2;
 	struct SocGpio *gpio;
@@ -128,7 +131,7 @@ static void socUartPrvWrite(uint_fast16_t chr, void* userData)
 	socExtSerialWriteChar(chr);
 }
 
-struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev)
+static struct SoC* socPrvInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t romNumPieces, uint32_t sdNumSectors, SdSectorR sdR, SdSectorW sdW, FILE *nandFile, int gdbPort, uint_fast8_t socRev)
 {
 	struct SoC *soc = (struct SoC*)malloc(sizeof(struct SoC));
 	static uint32_t romWriteIgnoreData[64] = {};
@@ -175,7 +178,7 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 		case RamTerminationMirror:
 	
 			//ram mirror for ram probe code
-			soc->ramMirror = ramInit(soc->mem, RAM_BASE + deviceGetRamSize(), deviceGetRamSize(), ramBuffer);
+			soc->ramMirror = ramMirrorInit(soc->mem, RAM_BASE + deviceGetRamSize(), soc->ram);
 			if (!soc->ramMirror)
 				ERR("Cannot init RAM mirror");
 			break;
@@ -194,15 +197,15 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 			break;
 	}
 	
-	soc->ic = socIcInit(soc->cpu, soc->mem, socRev);
+	soc->ic = s3c24xxIcInit(soc->cpu, soc->mem, socRev);
 	if (!soc->ic)
 		ERR("Cannot init S3C24xx's IC");
 	
-	//soc->dma = socDmaInit(soc->mem, soc->ic);
+	//soc->dma = socDmaInit(soc->mem, soc->ram, soc->ic);
 	//if (!soc->dma)
 	//	ERR("Cannot init S3C24xx's DMA");
 	
-	soc->gpio = socGpioInit(soc->mem, soc->ic, socRev);
+	soc->gpio = s3c24xxGpioInit(soc->mem, soc->ic, socRev);
 	if (!soc->gpio)
 		ERR("Cannot init S3C24xx's GPIO");
 	
@@ -210,23 +213,27 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	//if (!soc->i2c)
 	//	ERR("Cannot init S3C24xx's I2C");
 	
-	soc->uart0 = socUartInit(soc->mem, soc->ic, S3C24XX_UART0_BASE, S3C24XX_I_UART2_ERR);
+	soc->uart0 = s3c24xxUartInit(soc->mem, soc->ic, S3C24XX_UART0_BASE, S3C24XX_I_UART2_ERR);
 	if (!soc->uart0)
 		ERR("Cannot init S3C24xx's UART0");
 	
-	soc->uart1 = socUartInit(soc->mem, soc->ic, S3C24XX_UART1_BASE, S3C24XX_I_UART2_ERR);
+	soc->uart1 = s3c24xxUartInit(soc->mem, soc->ic, S3C24XX_UART1_BASE, S3C24XX_I_UART2_ERR);
 	if (!soc->uart1)
 		ERR("Cannot init S3C24xx's UART1");
 	
-	soc->uart2 = socUartInit(soc->mem, soc->ic, S3C24XX_UART2_BASE, S3C24XX_I_UART2_ERR);
+	soc->uart2 = s3c24xxUartInit(soc->mem, soc->ic, S3C24XX_UART2_BASE, S3C24XX_I_UART2_ERR);
 	if (!soc->uart2)
 		ERR("Cannot init S3C24xx's UART2");
 	
+	socExtSerialAttach(soc->uart0, "uart0");
+	socExtSerialAttach(soc->uart1, "uart1");
+	socExtSerialAttach(soc->uart2, "uart2");
+	
 	soc->timers = s3c24xxTimersInit(soc->mem, soc->ic, soc->dma);
 	if (!soc->timers)
 		ERR("Cannot init S3C24xx's Timers");
 	
-	soc->lcd = s3c24xxLcdInit(soc->mem, soc->ic, deviceHasGrafArea());
+	soc->lcd = s3c24xxLcdInit(soc->mem, soc->ram, soc->ic, deviceHasGrafArea());
 	if (!soc->lcd)
 		ERR("Cannot init S3C24xx's LCD unit");
 	
@@ -271,7 +278,10 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	if (!soc->dev)
 		ERR("Cannot init device\n");
 	
-	soc->nand = s3c24xxNandInit(soc->mem, sp.nand, soc->ic, soc->gpio);
+	if (soc->soc40)
+		soc->nand = s3c2440NandInit(soc->mem, sp.nand, soc->ic, soc->gpio);
+	else
+		soc->nand = s3c2410NandInit(soc->mem, sp.nand, soc->ic, soc->gpio);
 	if (!soc->nand)
 		ERR("Cannot init S3C24xx's NAND unit");
 	
@@ -281,6 +291,8 @@ struct SoC* socInit(void **romPieces, const uint32_t *romPieceSizes, uint32_t ro
 	}
 	atexit(SDL_Quit);
 	
+	speedSetClock(CYCLES_PER_SEC);
+	
 	return soc;
 }
 
@@ -348,21 +360,30 @@ void socBootload(struct SoC* soc, uint32_t nandPageSzAndFlags, void *param)
 }
 
 
-void socRun(struct SoC* soc)
+static uint32_t socPrvGetRamBase(void)
+{
+	return RAM_BASE;
+}
+
+static void socPrvRunCycles(struct SoC* soc, uint32_t numCycles)
 {
-	uint32_t cycles = 0;
+	uint32_t cycles = soc->cycles;
 	uint_fast8_t i;
 	
-	while (1)
-	{	
+	while (numCycles--) {
+		
 		cycles++;
 		
 		if (!(cycles & 0x00000001UL)) {
 			s3c24xxWdtPeriodic(soc->wdt);
 			s3c24xxTimersPeriodic(soc->timers);
 		}
-		if (!(cycles & 0x000000FFUL))
-			s3c24xxNandPeriodic(soc->nand);
+		if (!(cycles & 0x000000FFUL)) {
+			if (soc->soc40)
+				s3c2440NandPeriodic(soc->nand);
+			else
+				s3c2410NandPeriodic(soc->nand);
+		}
 		
 		if (!(cycles & 0x00000FFFUL))
 			s3c24xxLcdPeriodic(soc->lcd);
@@ -376,59 +397,49 @@ void socRun(struct SoC* soc)
 		//if (!(cycles & 0x000003FFUL))
 		//	socDmaPeriodic(soc->dma);
 		if (!(cycles & 0x000000FFUL)) {
-			socUartProcess(soc->uart0);
-			socUartProcess(soc->uart1);
-			socUartProcess(soc->uart2);
+			s3c24xxUartProcess(soc->uart0);
+			s3c24xxUartProcess(soc->uart1);
+			s3c24xxUartProcess(soc->uart2);
 		}
 		devicePeriodic(soc->dev, cycles);
 	
 		if (!(cycles & 0x00FFFFUL)) {
 			
-			SDL_Event event;
+			struct InputEvt evt;
+			
+			speedAdvance(0x00010000UL);
 			
-			if (SDL_PollEvent(&event)) switch (event.type) {
+			if (inputPoll(&evt)) switch (evt.type) {
 				
-				case SDL_QUIT:
+				case InputEvtQuit:
 					fprintf(stderr, "quit reqested\n");
 					exit(0);
 					break;
 				
-				case SDL_MOUSEBUTTONDOWN:
-					if (event.button.button != SDL_BUTTON_LEFT)
-						break;
-					soc->mouseDown = true;
-					deviceTouch(soc->dev, event.button.x, event.button.y);
+				case InputEvtTouch:
+					deviceTouch(soc->dev, evt.x, evt.y);
 					break;
 				
-				case SDL_MOUSEBUTTONUP:
-					if (event.button.button != SDL_BUTTON_LEFT)
-						break;
-					soc->mouseDown = false;
-					deviceTouch(soc->dev, -1, -1);
-					break;
-				
-				case SDL_MOUSEMOTION:
-					if (!soc->mouseDown)
-						break;
-					deviceTouch(soc->dev, event.motion.x, event.motion.y);
-					break;
-				
-				case SDL_KEYDOWN:
-				
-					deviceKey(soc->dev, event.key.keysym.sym, true);
-					keypadSdlKeyEvt(soc->kp, event.key.keysym.sym, true);
-					break;
-				
-				case SDL_KEYUP:
-				
-					deviceKey(soc->dev, event.key.keysym.sym, false);
-					keypadSdlKeyEvt(soc->kp, event.key.keysym.sym, false);
+				case InputEvtKey:
+					deviceKey(soc->dev, evt.key, evt.down);
+					keypadSdlKeyEvt(soc->kp, evt.key, evt.down);
 					break;
 			}
 		}
 		
 		cpuCycle(soc->cpu);
 	}
+	soc->cycles = cycles;
 }
 
-
+const struct SocFamily socFamilyS3c24xx = {
+	.init = socPrvInit,
+	.runCycles = socPrvRunCycles,
+	.getRamBase = socPrvGetRamBase,
+	.gpioGetState = s3c24xxGpioGetState,
+	.gpioSetState = s3c24xxGpioSetState,
+	.gpioSetNotif = s3c24xxGpioSetNotif,
+	.gpioSetDirsChangedNotif = s3c24xxGpioSetDirsChangedNotif,
+	.uartSetFuncs = s3c24xxUartSetFuncs,
+	.uartSetBulk = s3c24xxUartSetBulk,
+};
@@ -32,7 +32,7 @@ typedef bool (*Ac97CodecFifoW)(void *userData, uint32_t val);
 
 
 
-struct SocAC97* socAC97Init(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma);
+struct SocAC97* socAC97Init(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t periodicHz);	//how often socAC97Periodic() is called
 void socAC97Periodic(struct SocAC97 *ac97);
 
 //client api
@@ -40,6 +40,10 @@ void socAC97clientAdd(struct SocAC97 *ac97, enum Ac97Codec which, Ac97CodecRegR
 bool socAC97clientClientWantData(struct SocAC97 *ac97, enum Ac97Codec which, uint32_t *dataPtr);
 void socAC97clientClientHaveData(struct SocAC97 *ac97, enum Ac97Codec which, uint32_t data);
 
+//span api: move every sample due at the codec's sample clock since the last call, up to "max", in one go. return how many moved
+uint32_t socAC97clientTakeSamples(struct SocAC97 *ac97, enum Ac97Codec which, uint32_t rate, uint32_t *dst, uint32_t max);
+uint32_t socAC97clientGiveSamples(struct SocAC97 *ac97, enum Ac97Codec which, uint32_t rate, const uint32_t *src, uint32_t max);
+
 
 
 
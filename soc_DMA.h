@@ -6,13 +6,17 @@
 #include "mem.h"
 #include "CPU.h"
 #include "soc_IC.h"
+#include "RAM.h"
 
 struct SocDma;
 
+//a peripheral that can take or give a run of FIFO data at once instead of one register access per item. gets up to len
+//bytes (a multiple of the channel's itemSz) and returns how many it moved, 0 if none right now or not at this item size
+typedef uint32_t (*SocDmaBulkF)(void *userData, void *buf, uint32_t len, uint_fast8_t itemSz);
 
-struct SocDma* socDmaInit(struct ArmMem *physMem, struct SocIc *ic);
-void socDmaPeriodic(struct SocDma* dma);
-void socDmaExternalReq(struct SocDma* dma, uint_fast8_t chNum, bool requested);	//request a transfer burst
+
+//the engine is per SoC family (pxa_DMA.h, omap_DMA.h). peripherals request transfer bursts through its ExternalReq, and a
+//bulk handler given to its SetBulkHandler is used when a channel serving that request line moves data between RAM and them
 
 
 #endif
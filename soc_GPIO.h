@@ -27,7 +27,6 @@ enum SocGpioState {	//these values make it look like all HiZ, AFR, and nonexiste
 };
 
 
-struct SocGpio* socGpioInit(struct ArmMem *physMem, struct SocIc *ic, uint_fast8_t socRev);
 
 //for external use :)
 enum SocGpioState socGpioGetState(struct SocGpio* gpio, uint_fast8_t gpioNum);
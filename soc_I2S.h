@@ -16,9 +16,15 @@
 
 struct SocI2s;
 
-struct SocI2s* socI2sInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma);
+//a codec gets stereo frames as they go out on the wire, with the sample rate the bit clock is set for
+typedef void (*I2sClientTxF)(void *userData, const uint32_t *frames, uint32_t num, uint32_t rate);
+
+//periodicHz is how often socI2sPeriodic() gets called
+struct SocI2s* socI2sInit(struct ArmMem *physMem, struct SocIc *ic, struct SocDma *dma, uint32_t periodicHz);
 void socI2sPeriodic(struct SocI2s *i2s);
 
+void socI2sClientAdd(struct SocI2s *i2s, I2sClientTxF txF, void *userData);
+
 
 
 #endif
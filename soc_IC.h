@@ -13,8 +13,6 @@
 struct SocIc;
 
 
-struct SocIc* socIcInit(struct ArmCpu *cpu, struct ArmMem *physMem, uint_fast8_t socRev);
-
-void socIcInt(struct SocIc *ic, uint_fast8_t intNum, bool raise);
+//init and raise are per SoC family, see pxa_IC.h, omap_IC.h and s3c24xx_IC.h
 
 #endif
@@ -23,9 +23,9 @@ typedef uint_fast16_t	(*SocUartReadF)(void *userData);
 typedef void			(*SocUartWriteF)(uint_fast16_t chr, void *userData);
 
 
-struct SocUart* socUartInit(struct ArmMem *physMem, struct SocIc *ic, uint32_t baseAddr, uint8_t irq);
-void socUartProcess(struct SocUart *uart);		//write out data in TX fifo and read data into RX fifo
+//init and processing (write out data in TX fifo and read data into RX fifo) are per SoC family, these two are for the frontend
 
 void socUartSetFuncs(struct SocUart *uart, SocUartReadF readF, SocUartWriteF writeF, void *userData);
+void socUartSetBulk(struct SocUart *uart, bool bulk);		//ignore wire speed, move data as fast as the FIFOs allow
 
 #endif
@@ -0,0 +1,126 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <stdatomic.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "speed.h"
+
+
+#define NS_PER_SEC				1000000000ULL
+#define SPEED_SLACK_NS			2000000ULL		//this far ahead of host time we sleep
+#define SPEED_BEHIND_NS			50000000ULL		//this far behind, we start skipping frames
+#define SPEED_MAX_DEBT_NS		1000000000ULL	//never try to make up more than this
+#define SPEED_MAX_SKIP			4				//draw at least one frame of this many
+
+
+static uint64_t mCyclesPerSec, mEmuNs, mEmuNsRem, mHostStartNs, mSleptNs, mForgivenNs;
+static uint64_t mFramesDrawn, mFramesSkipped;
+static bool mRealTime = false, mBehind = false, mReportQueued = false;
+static uint32_t mSkipRun;
+static atomic_int_fast64_t mNudgeNs = 0;
+
+
+
+static uint64_t speedPrvHostNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void speedPrvReport(void)
+{
+	uint64_t hostNs = speedPrvHostNs() - mHostStartNs + mForgivenNs;
+
+	if (!mEmuNs || !hostNs)
+		return;
+
+	fprintf(stderr, "speed: %.3f sec of guest time in %.3f sec (%.1f%% of real time, %s), %.1f%% of host time asleep, %llu frames drawn, %llu skipped\n",
+		(double)mEmuNs / NS_PER_SEC, (double)hostNs / NS_PER_SEC, 100.0 * mEmuNs / hostNs, mRealTime ? "throttled" : "turbo",
+		100.0 * mSleptNs / hostNs, (unsigned long long)mFramesDrawn, (unsigned long long)mFramesSkipped);
+}
+
+void speedSetRealTime(bool on)
+{
+	mRealTime = on;
+
+	if (!mReportQueued) {
+		mReportQueued = true;
+		atexit(speedPrvReport);
+	}
+}
+
+void speedSetClock(uint64_t cyclesPerSecond)
+{
+	mCyclesPerSec = cyclesPerSecond;
+	mHostStartNs = speedPrvHostNs();
+	mForgivenNs = 0;
+	mSleptNs = 0;
+	mEmuNs = 0;
+	mEmuNsRem = 0;
+
+}
+
+void speedAdvance(uint32_t cycles)
+{
+	uint64_t hostNs, t;
+
+	t = (uint64_t)cycles * NS_PER_SEC + mEmuNsRem;
+	mEmuNs += t / mCyclesPerSec;
+	mEmuNsRem = t % mCyclesPerSec;
+
+	if (!mRealTime)
+		return;
+
+	//a nudge moves our idea of when host time started, as if we had been ahead or behind by that much
+	if (atomic_load_explicit(&mNudgeNs, memory_order_relaxed)) {
+
+		t = atomic_exchange_explicit(&mNudgeNs, 0, memory_order_relaxed);
+		mHostStartNs += t;
+		mForgivenNs += t;
+	}
+
+	hostNs = speedPrvHostNs() - mHostStartNs;
+
+	if (mEmuNs > hostNs + SPEED_SLACK_NS) {			//ahead: sleep it off
+
+		struct timespec ts;
+
+		t = mEmuNs - hostNs;
+		ts.tv_sec = t / NS_PER_SEC;
+		ts.tv_nsec = t % NS_PER_SEC;
+		nanosleep(&ts, NULL);
+		mSleptNs += t;
+		mBehind = false;
+	}
+	else if (hostNs > mEmuNs + SPEED_MAX_DEBT_NS) {	//too far behind to ever catch up. let it go
+
+		t = hostNs - mEmuNs - SPEED_BEHIND_NS;
+		mHostStartNs += t;
+		mForgivenNs += t;
+		mBehind = true;
+	}
+	else
+		mBehind = hostNs > mEmuNs + SPEED_BEHIND_NS;
+}
+
+void speedNudge(int64_t ns)
+{
+	atomic_fetch_add_explicit(&mNudgeNs, ns, memory_order_relaxed);
+}
+
+bool speedShouldSkipFrame(void)
+{
+	if (mBehind && ++mSkipRun < SPEED_MAX_SKIP) {
+
+		mFramesSkipped++;
+		return true;
+	}
+
+	mSkipRun = 0;
+	mFramesDrawn++;
+	return false;
+}
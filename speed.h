@@ -0,0 +1,24 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _SPEED_H_
+#define _SPEED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+//the governor keeps emulated time in step with host time. unless enabled it never throttles (turbo). stats are printed at exit once this is called
+void speedSetRealTime(bool on);
+
+//SoCs tell us how many cycles make up one second of guest time (as seen by their timers) and report cycles as they go
+void speedSetClock(uint64_t cyclesPerSecond);
+void speedAdvance(uint32_t cycles);
+
+//audio output steers us to keep its buffer level: positive to have guest time run a bit slower, negative faster. any thread
+void speedNudge(int64_t ns);
+
+//optional work (LCD conversion) asks this before doing its thing. true if it should be skipped to catch up
+bool speedShouldSkipFrame(void);
+
+
+#endif
@@ -601,6 +601,63 @@ enum SdReplyType vsdCommand(struct VSD *vsd, uint8_t cmd, uint32_t param, void *
 	return replTyp;
 }
 
+static enum SdDataReplyType vsdPrvDataXferSectors(struct VSD *vsd, void *data, uint32_t nBlocks, bool toCard)
+{
+	if (vsd->curSec >= vsd->nSec || vsd->nSec - vsd->curSec < nBlocks) {
+		
+		fprintf(stderr, "SD transfer of %lu sectors at sec %lu is past the end of the card\n", (unsigned long)nBlocks, (unsigned long)vsd->curSec);
+		return SdDataErrBackingStore;
+	}
+	
+	if (toCard ? !vsd->secW(vsd->curSec, data, nBlocks) : !vsd->secR(vsd->curSec, data, nBlocks)) {
+		
+		fprintf(stderr, "failed to %s SD backing store sec %lu\n", toCard ? "write" : "read", (unsigned long)vsd->curSec);
+		return SdDataErrBackingStore;
+	}
+	
+	if (vsd->haveExpectedNumBlocks && !(vsd->numBlocksExpected -= nBlocks))
+		vsd->bufContinuous = false;	//end it here
+	
+	if (vsd->bufContinuous)
+		vsd->curSec += nBlocks;
+	else
+		vsd->state = StateTran;
+	
+	return SdDataOk;
+}
+
+uint32_t vsdDataBlocksLeft(struct VSD *vsd)
+{
+	uint32_t left;
+	
+	if ((vsd->state != StateData && vsd->state != StateRcv) || !vsd->bufIsData || vsd->curSec >= vsd->nSec)
+		return 0;
+	
+	if (!vsd->bufContinuous)
+		left = 1;
+	else if (vsd->haveExpectedNumBlocks)
+		left = vsd->numBlocksExpected;
+	else
+		left = vsd->nSec - vsd->curSec;
+	
+	return left < vsd->nSec - vsd->curSec ? left : vsd->nSec - vsd->curSec;
+}
+
+enum SdDataReplyType vsdDataXferBlocks(struct VSD *vsd, void* data, uint32_t nBlocks)
+{
+	if ((vsd->state != StateData && vsd->state != StateRcv) || !vsd->bufIsData) {
+		fprintf(stderr, "multi-block transfer impossible outside of a data stage\n");
+		return SdDataErrWrongCurrentState;
+	}
+	
+	if (!nBlocks || nBlocks > vsdDataBlocksLeft(vsd)) {
+		fprintf(stderr, "multi-block transfer of %lu blocks is not what the card expects\n", (unsigned long)nBlocks);
+		return SdDataErrWrongCurrentState;
+	}
+	
+	return vsdPrvDataXferSectors(vsd, data, nBlocks, vsd->state == StateRcv);
+}
+
 enum SdDataReplyType vsdDataXferBlockToCard(struct VSD *vsd, const void* data, uint32_t blockSz)
 {
 	if (vsd->state != StateRcv) {
@@ -615,29 +672,14 @@ enum SdDataReplyType vsdDataXferBlockToCard(struct VSD *vsd, const void* data, u
 	
 	//fprintf(stderr, "host to card xfer: %u bytes for sec %u\n", blockSz, vsd->curSec);
 	
-	if (vsd->bufIsData) {
-		
-		if (!vsd->secW(vsd->curSec, data)) {
-			
-			fprintf(stderr, "failed to write SD backing store sec %lu\n", (unsigned long)vsd->curSec);
-			return SdDataErrBackingStore;
-		}
-		if (vsd->haveExpectedNumBlocks && !--vsd->numBlocksExpected)
-			vsd->bufContinuous = false;	//end it here
-		
-		if (vsd->bufContinuous)
-			vsd->curSec++;
-		else
-			vsd->state = StateTran;
-	}
-	else {
+	if (!vsd->bufIsData) {
 		
 		//data to be handled here
 		fprintf(stderr, "unexpected data write\n");
 		return SdDataErrWrongCurrentState;
 	}
 	
-	return SdDataOk;
+	return vsdPrvDataXferSectors(vsd, (void*)data, 1, true);
 }
 
 enum SdDataReplyType vsdDataXferBlockFromCard(struct VSD *vsd, void* data, uint32_t blockSz)
@@ -652,26 +694,11 @@ enum SdDataReplyType vsdDataXferBlockFromCard(struct VSD *vsd, void* data, uint3
 		return SdDataErrWrongBlockSize;
 	}
 	
-	if (vsd->bufIsData) {
-		if (!vsd->secR(vsd->curSec, data)) {
-			
-			fprintf(stderr, "failed to read SD backing store sec %lu\n", (unsigned long)vsd->curSec);
-			return SdDataErrBackingStore;
-		}
-		
-		if (vsd->haveExpectedNumBlocks && !--vsd->numBlocksExpected)
-			vsd->bufContinuous = false;	//end it here
-		
-		if (vsd->bufContinuous)
-			vsd->curSec++;
-		else
-			vsd->state = StateTran;
-	}
-	else {
-		
-		memcpy(data, vsd->curBuf, blockSz);
-		vsd->state = StateTran;
-	}
+	if (vsd->bufIsData)
+		return vsdPrvDataXferSectors(vsd, data, 1, false);
+	
+	memcpy(data, vsd->curBuf, blockSz);
+	vsd->state = StateTran;
 	
 	//fprintf(stderr, "card to host xfer: %u bytes\n", blockSz);
 	
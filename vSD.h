@@ -6,6 +6,8 @@
 #include "SoC.h"
 
 
+#define VSD_SECTOR_SIZE		512
+
 struct VSD;
 typedef struct VSD VSD;
 
@@ -23,8 +25,8 @@ enum SdDataReplyType {
 	SdDataErrBackingStore,
 };
 
-typedef bool (*SdSectorR)(uint32_t secNum, void *buf);
-typedef bool (*SdSectorW)(uint32_t secNum, const void *buf);
+typedef bool (*SdSectorR)(uint32_t secNum, void *buf, uint32_t numSecs);
+typedef bool (*SdSectorW)(uint32_t secNum, const void *buf, uint32_t numSecs);
 
 
 struct VSD* vsdInit(SdSectorR, SdSectorW, uint32_t nSec);
@@ -34,6 +36,10 @@ bool vsdIsCardBusy(struct VSD *vsd);
 enum SdDataReplyType vsdDataXferBlockToCard(struct VSD *vsd, const void* data, uint32_t blockSz);
 enum SdDataReplyType vsdDataXferBlockFromCard(struct VSD *vsd, void* data, uint32_t blockSz);
 
+//whole 512-byte sectors of a CMD17/18/24/25 transfer at once, direction as per the command. the card must be expecting that many
+enum SdDataReplyType vsdDataXferBlocks(struct VSD *vsd, void* data, uint32_t nBlocks);
+uint32_t vsdDataBlocksLeft(struct VSD *vsd);		//how many vsdDataXferBlocks() would take right now
+
 
 
 
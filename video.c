@@ -0,0 +1,267 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "video.h"
+#include "util.h"
+
+
+#define VIDEO_FPS				30
+#define VIDEO_NS_PER_FRAME		(1000000000ULL / VIDEO_FPS)
+#define VIDEO_QUEUE_LEN			8					//frames captured but not yet written. more than that and we drop them
+#define VIDEO_DEDUP_PREFIX		"dedup:"
+
+
+/*
+	Frames are captured as the LCD finishes them, stamped with the time, and queued for a writer thread, so neither
+	the emulator nor any other display output ever waits for the conversion or the disk. The writer lays them out on
+	a fixed VIDEO_FPS grid: each tick gets the newest frame captured before it
+*/
+
+struct VideoQueued {
+	uint64_t ns;
+	uint16_t *pixels;
+};
+
+struct Video {
+	FILE *f;
+	uint32_t w, h;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct VideoQueued queue[VIDEO_QUEUE_LEN];
+	uint32_t head, tail;		//free running, under "lock". the producer owns slots outside [tail, head), the writer those inside
+	bool stop;					//under "lock"
+	uint64_t numLost;			//emulator thread only
+	
+	//writer thread only
+	uint16_t *cur, *written;	//latest frame and the last one written
+	uint8_t *out;				//one converted frame
+	uint64_t nextNs, numWritten, numDropped;
+	bool y4m, dedup, haveFrame, haveWritten;
+};
+
+
+
+static uint64_t videoPrvNowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void videoPrvFree(struct Video *vid)
+{
+	uint_fast8_t i;
+
+	for (i = 0; i < VIDEO_QUEUE_LEN; i++)
+		free(vid->queue[i].pixels);
+	free(vid->cur);
+	free(vid->written);
+	free(vid->out);
+	free(vid);
+}
+
+static void* videoPrvThread(void *param);
+
+static void* videoPrvOpen(const char *args, uint32_t w, uint32_t h, uint32_t winH)
+{
+	const char *ext, *path = args;
+	struct Video *vid;
+	uint_fast8_t i;
+
+	if (!path || !*path) {
+		fprintf(stderr, "video output needs a file name: -o video:FILE\n");
+		return NULL;
+	}
+
+	vid = (struct Video*)calloc(1, sizeof(*vid));
+	if (!vid)
+		ERR("cannot alloc video output");
+
+	if (!strncmp(path, VIDEO_DEDUP_PREFIX, strlen(VIDEO_DEDUP_PREFIX))) {
+		path += strlen(VIDEO_DEDUP_PREFIX);
+		vid->dedup = true;
+	}
+	ext = strrchr(path, '.');
+	vid->y4m = ext && !strcmp(ext, ".y4m");
+	vid->w = w;
+	vid->h = h;
+
+	vid->cur = (uint16_t*)malloc(w * h * sizeof(uint16_t));
+	vid->written = (uint16_t*)malloc(w * h * sizeof(uint16_t));
+	vid->out = (uint8_t*)malloc(w * h * 3);
+	if (!vid->cur || !vid->written || !vid->out)
+		ERR("cannot alloc video buffers");
+
+	for (i = 0; i < VIDEO_QUEUE_LEN; i++) {
+		vid->queue[i].pixels = (uint16_t*)malloc(w * h * sizeof(uint16_t));
+		if (!vid->queue[i].pixels)
+			ERR("cannot alloc video buffers");
+	}
+
+	vid->f = fopen(path, "wb");
+	if (!vid->f) {
+		perror("cannot create video file");
+		videoPrvFree(vid);
+		return NULL;
+	}
+	setvbuf(vid->f, NULL, _IOFBF, 1 << 20);
+
+	if (vid->y4m)
+		fprintf(vid->f, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", (unsigned)w, (unsigned)h, VIDEO_FPS);
+
+	fprintf(stderr, "recording %u x %u %s video at %u fps%s to '%s'\n", (unsigned)w, (unsigned)h, vid->y4m ? "Y4M" : "raw RGB24",
+		VIDEO_FPS, vid->dedup ? " (repeated frames dropped)" : "", path);
+
+	vid->nextNs = videoPrvNowNs();
+
+	pthread_mutex_init(&vid->lock, NULL);
+	pthread_cond_init(&vid->cond, NULL);
+	if (pthread_create(&vid->thread, NULL, videoPrvThread, vid))
+		ERR("cannot start video writer thread\n");
+
+	return vid;
+}
+
+//called from the LCD's frame hook on the emulator thread. never waits for the writer, a full queue just loses the frame
+static void videoPrvPresent(void *ctx, const uint16_t *pixels)
+{
+	struct Video *vid = (struct Video*)ctx;
+	struct VideoQueued *q;
+	bool full;
+
+	pthread_mutex_lock(&vid->lock);
+	full = vid->head - vid->tail == VIDEO_QUEUE_LEN;
+	pthread_mutex_unlock(&vid->lock);
+
+	if (full) {
+		vid->numLost++;
+		return;
+	}
+
+	q = &vid->queue[vid->head % VIDEO_QUEUE_LEN];
+	q->ns = videoPrvNowNs();
+	memcpy(q->pixels, pixels, vid->w * vid->h * sizeof(uint16_t));
+
+	pthread_mutex_lock(&vid->lock);
+	vid->head++;
+	pthread_cond_signal(&vid->cond);
+	pthread_mutex_unlock(&vid->lock);
+}
+
+static void videoPrvWriteFrame(struct Video *vid)
+{
+	uint32_t i, n = vid->w * vid->h;
+	uint8_t *y = vid->out, *u = y + n, *v = u + n;
+
+	if (vid->dedup && vid->haveWritten && !memcmp(vid->cur, vid->written, n * sizeof(uint16_t))) {
+		vid->numDropped++;
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+
+		int32_t r = (vid->cur[i] >> 11) & 0x1f, g = (vid->cur[i] >> 5) & 0x3f, b = vid->cur[i] & 0x1f;
+
+		r = (r << 3) | (r >> 2);
+		g = (g << 2) | (g >> 4);
+		b = (b << 3) | (b >> 2);
+
+		if (vid->y4m) {		//BT.601, full range
+			y[i] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+			u[i] = ((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128;
+			v[i] = ((128 * r - 107 * g - 21 * b + 128) >> 8) + 128;
+		}
+		else {
+			vid->out[i * 3 + 0] = r;
+			vid->out[i * 3 + 1] = g;
+			vid->out[i * 3 + 2] = b;
+		}
+	}
+
+	if (vid->y4m)
+		fputs("FRAME\n", vid->f);
+	fwrite(vid->out, 3, n, vid->f);
+
+	memcpy(vid->written, vid->cur, n * sizeof(uint16_t));
+	vid->haveWritten = true;
+	vid->numWritten++;
+}
+
+//every tick before "untilNs" shows the newest frame we have
+static void videoPrvWriteTicks(struct Video *vid, uint64_t untilNs)
+{
+	while (vid->nextNs < untilNs) {
+
+		if (vid->haveFrame)
+			videoPrvWriteFrame(vid);
+		vid->nextNs += VIDEO_NS_PER_FRAME;
+	}
+}
+
+static void* videoPrvThread(void *param)
+{
+	struct Video *vid = (struct Video*)param;
+	struct VideoQueued *q;
+
+	pthread_mutex_lock(&vid->lock);
+	while (1) {
+
+		while (vid->head == vid->tail && !vid->stop)
+			pthread_cond_wait(&vid->cond, &vid->lock);
+		if (vid->head == vid->tail)
+			break;
+		pthread_mutex_unlock(&vid->lock);
+
+		q = &vid->queue[vid->tail % VIDEO_QUEUE_LEN];
+		videoPrvWriteTicks(vid, q->ns);
+		memcpy(vid->cur, q->pixels, vid->w * vid->h * sizeof(uint16_t));
+		vid->haveFrame = true;
+
+		pthread_mutex_lock(&vid->lock);
+		vid->tail++;
+	}
+	pthread_mutex_unlock(&vid->lock);
+
+	//the last frame lasts until the recording ends
+	videoPrvWriteTicks(vid, videoPrvNowNs());
+
+	return NULL;
+}
+
+static void videoPrvClose(void *ctx)
+{
+	struct Video *vid = (struct Video*)ctx;
+
+	pthread_mutex_lock(&vid->lock);
+	vid->stop = true;
+	pthread_cond_signal(&vid->cond);
+	pthread_mutex_unlock(&vid->lock);
+	pthread_join(vid->thread, NULL);
+
+	fclose(vid->f);
+	fprintf(stderr, "video: %llu frames written, %llu repeats dropped, %llu lost to a slow disk\n", (unsigned long long)vid->numWritten,
+		(unsigned long long)vid->numDropped, (unsigned long long)vid->numLost);
+	pthread_mutex_destroy(&vid->lock);
+	pthread_cond_destroy(&vid->cond);
+	videoPrvFree(vid);
+}
+
+const struct DisplaySink* videoDisplaySink(void)
+{
+	static const struct DisplaySink sink = {
+		.name = "video",
+		.help = "record frames to a Y4M (*.y4m) or raw RGB24 file (video:FILE or video:dedup:FILE)",
+		.open = videoPrvOpen,
+		.present = videoPrvPresent,
+		.close = videoPrvClose,
+	};
+
+	return &sink;
+}
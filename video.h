@@ -0,0 +1,13 @@
+//(c) uARM project    https://github.com/uARM-Palm/uARM    uARM@dmitry.gr
+
+#ifndef _VIDEO_H_
+#define _VIDEO_H_
+
+#include "display.h"
+
+
+//records frames as the LCD makes them to a file at a fixed rate: "FILE" or "dedup:FILE". *.y4m gets Y4M (4:4:4), anything else raw RGB24
+const struct DisplaySink* videoDisplaySink(void);
+
+
+#endif